@@ -2,7 +2,10 @@
 #include "str_opekit.h"
 
 #include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 using std::stoi;
@@ -11,6 +14,77 @@ using std::transform;
 using std::vector;
 
 void DAG_optimizer::optimize_quadruples() {
+  number_values();
+
+  // the last quadruple holds the value of the expression, keep it that way
+  // when the expression is folded into a number or a reused tmp
+  if (!_origin_nodes.empty()) {
+    append_result(_optimized_nodes, table_lookup(_origin_nodes.back().count));
+  }
+}
+
+void DAG_optimizer::begin_batch() {
+  clear();
+  _batching = true;
+}
+
+size_t DAG_optimizer::add_to_batch(const vector<quadruple> &nodes) {
+  if (!_batching) {
+    throw std::logic_error("No batch is started");
+  }
+
+  // tmps are local to the expression, value numbers are shared by the batch
+  _table.clear();
+  _origin_nodes = nodes;
+  number_values();
+
+  _batch_results.push_back(
+      nodes.empty() ? quadruple::item(quadruple::empty, -1)
+                    : table_lookup(nodes.back().count));
+  return _batch_results.size() - 1;
+}
+
+void DAG_optimizer::finish_batch() {
+  // what a shared computation depends on is shared as well, operands are
+  // always computed before the node using them
+  for (size_t index = _optimized_nodes.size(); index-- > 0;) {
+    if (!_batch_shared[index]) {
+      continue;
+    }
+    const quadruple &quad = _optimized_nodes[index];
+    for (const quadruple::item &operand : {quad.operand1, quad.operand2}) {
+      if (operand.first == quadruple::optimized) {
+        _batch_shared[operand.second - 1] = true;
+      }
+    }
+  }
+
+  _batch_prelude.clear();
+  _batch_expressions.assign(_batch_results.size(), vector<quadruple>());
+  for (size_t index = 0; index < _optimized_nodes.size(); ++index) {
+    if (_batch_shared[index]) {
+      _batch_prelude.push_back(_optimized_nodes[index]);
+    } else {
+      _batch_expressions[_batch_owners[index]].push_back(
+          _optimized_nodes[index]);
+    }
+  }
+  for (size_t index = 0; index < _batch_results.size(); ++index) {
+    if (_batch_results[index].first != quadruple::empty) {
+      append_result(_batch_expressions[index], _batch_results[index]);
+    }
+  }
+  _batching = false;
+}
+
+void DAG_optimizer::append_result(vector<quadruple> &nodes,
+                                  const quadruple::item &result) {
+  if (nodes.empty() || nodes.back().count != result) {
+    nodes.push_back({'=', result, {quadruple::empty, 0}, make_new_tmp()});
+  }
+}
+
+void DAG_optimizer::number_values() {
   for (const quadruple &quad : this->_origin_nodes) {
     if (quad.op == '=') {
       // process assignment
@@ -21,23 +95,37 @@ void DAG_optimizer::optimize_quadruples() {
       table_insert(quad.count, result);
     } else {
       // process other operations - Optimization
-      quadruple::item arg1 = table_lookup(quad.operand1);
-      if (arg1.first == quadruple::empty) {
-        throw std::logic_error("Undefined variable: " +
-                               quadruple::item2str(quad.operand1));
+      quadruple::item arg1 = resolve_operand(quad.operand1);
+      quadruple::item arg2 = resolve_operand(quad.operand2);
+      value_key key = {quad.op, arg1, arg2};
+      // commutative operations are numbered with ordered operands
+      if ((key.op == '+' || key.op == '*') && key.operand2 < key.operand1) {
+        std::swap(key.operand1, key.operand2);
       }
-      quadruple::item arg2 = table_lookup(quad.operand2);
-      if (arg2.first == quadruple::empty) {
-        throw std::logic_error("Undefined variable: " +
-                               quadruple::item2str(quad.operand2));
+
+      // the same operation is computed before, reuse its result
+      const quadruple::item *number = _value_numbers.find(key);
+      if (number != nullptr) {
+        table_insert(quad.count, *number);
+        ++_eliminated_count;
+        // computed by another expression of the batch, share it
+        if (_batching &&
+            _batch_owners[number->second - 1] != _batch_results.size()) {
+          _batch_shared[number->second - 1] = true;
+        }
+        continue;
       }
+
       quadruple::item result = make_new_tmp();
       // map the original quadruple to the optimized one
       table_insert(quad.count, result);
-      // add optimized node to the quadruple map
-      table_insert(result, quadruple::item(quadruple::empty, -1));
+      _value_numbers.emplace(key, result);
       // add optimized node to the optimized vector
       _optimized_nodes.push_back({quad.op, arg1, arg2, result});
+      if (_batching) {
+        _batch_owners.push_back(_batch_results.size());
+        _batch_shared.push_back(false);
+      }
     }
   }
 }
@@ -45,13 +133,25 @@ void DAG_optimizer::optimize_quadruples() {
 quadruple::item DAG_optimizer::table_lookup(const quadruple::item &item) {
   // if found, return the value
   // if not, return { quadruple::empty, -1 }
-  auto it = _table.find(item);
-  if (it != _table.end()) {
-    return it->second;
+  const quadruple::item *value = _table.find(item);
+  if (value != nullptr) {
+    return *value;
   }
   return {quadruple::empty, -1};
 }
 
+quadruple::item DAG_optimizer::resolve_operand(const quadruple::item &item) {
+  if (item.first == quadruple::number) {
+    return item;
+  }
+
+  quadruple::item value = table_lookup(item);
+  if (value.first == quadruple::empty) {
+    throw std::logic_error("Undefined variable: " + quadruple::item2str(item));
+  }
+  return value;
+}
+
 inline void DAG_optimizer::table_insert(const quadruple::item &key,
                                         const quadruple::item &value) {
   _table[key] = value;
@@ -61,6 +161,15 @@ quadruple::item DAG_optimizer::make_new_tmp() {
   return {quadruple::optimized, _optimized_count++};
 }
 
+void DAG_optimizer::read_origin_nodes(const quadruple_file &file) {
+  clear();
+
+  _origin_nodes.reserve(file.size());
+  for (size_t index = 0; index < file.size(); ++index) {
+    _origin_nodes.push_back(file[index]);
+  }
+}
+
 void DAG_optimizer::read_origin_nodes(ifstream &fin) {
   clear();
 
@@ -80,7 +189,7 @@ void DAG_optimizer::read_origin_nodes(ifstream &fin) {
 
     // parse strings into quadruple
     quadruple quad;
-    quad.op = parsed_string[0].length() == 1 ? parsed_string[0][0] : '=';
+    quad.op = quadruple::str2op(parsed_string[0]);
     quad.operand1 = quadruple::str2item(parsed_string[1]);
     quad.operand2 = quadruple::str2item(parsed_string[2]);
     quad.count = quadruple::str2item(parsed_string[3]);
@@ -8,17 +8,19 @@
 #define LIB_6CXX_DAG_OPTIMIZER_H
 
 #include "intermediate_code_generator.h"
+#include "open_hash_map.h"
+#include "quadruple_file.h"
 
+#include <cstddef>
 #include <fstream>
 #include <stack>
-#include <unordered_map>
 #include <vector>
 
 using quadruple = intermediate_code_generator::quadruple;
 
 using std::ifstream;
+using std::size_t;
 using std::stack;
-using std::unordered_map;
 using std::vector;
 
 // Hash function for quadruple::item
@@ -30,6 +32,35 @@ template <> struct hash<quadruple::item> {
 };
 } // namespace std
 
+/**
+ * @brief The key of the value numbering table: an operator with its operands
+ * after copy propagation
+ */
+struct value_key {
+  char op;                  // Operator
+  quadruple::item operand1; // Operand 1
+  quadruple::item operand2; // Operand 2
+
+  inline bool operator==(const value_key &other) const {
+    return op == other.op && operand1 == other.operand1 &&
+           operand2 == other.operand2;
+  }
+};
+
+// Hash function for value_key
+namespace std {
+template <> struct hash<value_key> {
+  inline size_t operator()(const value_key &k) const {
+    size_t seed = hash<char>()(k.op);
+    seed ^= hash<quadruple::item>()(k.operand1) + 0x9e3779b9 + (seed << 6) +
+            (seed >> 2);
+    seed ^= hash<quadruple::item>()(k.operand2) + 0x9e3779b9 + (seed << 6) +
+            (seed >> 2);
+    return seed;
+  }
+};
+} // namespace std
+
 /**
  * @brief DAG Node
  */
@@ -39,7 +70,7 @@ public:
 
 public:
   /**
-   * @brief Read origin nodes from file
+   * @brief Read origin nodes from a text file, one `( op, a, b, T )` per line
    * @param fin ifstream object
    */
   void read_origin_nodes(ifstream &fin);
@@ -54,7 +85,16 @@ public:
   }
 
   /**
-   * @brief Optimize quadruples with DAG
+   * @brief Read origin nodes from a mapped binary quadruple file
+   * @param file The mapped file
+   */
+  void read_origin_nodes(const quadruple_file &file);
+
+  /**
+   * @brief Optimize quadruples with DAG. Operands are copy-propagated, then
+   * every operation is looked up in the value numbering table so that a
+   * repeated computation reuses the existing result instead of a new tmp.
+   * The result of the last optimized quadruple is the value of the expression.
    */
   void optimize_quadruples();
 
@@ -62,22 +102,98 @@ public:
    * @brief Get optimized quadruples
    * @return optimized quadruples
    */
-  inline vector<quadruple> get_optimized() { return _optimized_nodes; }
+  inline const vector<quadruple> &get_optimized() const {
+    return _optimized_nodes;
+  }
+
+  /**
+   * @brief Get the number of quadruples eliminated as common subexpressions
+   * @return The number of eliminated quadruples
+   */
+  inline unsigned int get_eliminated_count() const { return _eliminated_count; }
+
+  /**
+   * @brief Start a batch. The value numbering table is kept across all
+   * expressions added to the batch, so a computation shared by several
+   * expressions is emitted once into a common prelude.
+   */
+  void begin_batch();
+
+  /**
+   * @brief Optimize one expression of the batch
+   * @param nodes The quadruples of the expression
+   * @return The index of the expression in the batch
+   * @throw std::logic_error No batch is started
+   */
+  size_t add_to_batch(const vector<quadruple> &nodes);
+
+  /**
+   * @brief Split the batch into the prelude and the expressions. The prelude
+   * holds every computation used by more than one expression, together with
+   * the computations it depends on; each expression holds the rest of its own
+   * computations and ends with a quadruple holding its value, so the
+   * expression is evaluated by running the prelude and then the expression.
+   * No more expressions can be added afterwards.
+   */
+  void finish_batch();
+
+  /**
+   * @brief Get the quadruples shared by the expressions of the batch
+   * @return The prelude
+   */
+  inline const vector<quadruple> &get_batch_prelude() const {
+    return _batch_prelude;
+  }
+
+  /**
+   * @brief Get the quadruples of an expression of the batch
+   * @param index The index of the expression
+   * @return The quadruples, referring to tmps of the prelude
+   */
+  inline const vector<quadruple> &get_batch_expression(size_t index) const {
+    return _batch_expressions[index];
+  }
+
+  /**
+   * @brief Get the number of expressions in the batch
+   * @return The number of expressions
+   */
+  inline size_t get_batch_size() const { return _batch_results.size(); }
 
   /**
    * @brief Clear all data, ready for next optimization
    */
   inline void clear() {
+    _batching = false;
     _optimized_count = 1;
+    _eliminated_count = 0;
     _table.clear();
+    _value_numbers.clear();
     _origin_nodes.clear();
     _optimized_nodes.clear();
     while (!_operand_stack.empty()) {
       _operand_stack.pop();
     }
+    _batch_owners.clear();
+    _batch_shared.clear();
+    _batch_results.clear();
+    _batch_prelude.clear();
+    _batch_expressions.clear();
   }
 
 private:
+  /**
+   * @brief Number the values of the origin nodes into optimized nodes
+   */
+  void number_values();
+
+  /**
+   * @brief Make the last optimized quadruple hold the value of the expression
+   * @param nodes The optimized quadruples of the expression
+   * @param result The value of the expression
+   */
+  void append_result(vector<quadruple> &nodes, const quadruple::item &result);
+
   /**
    * @brief Get a item in table
    * @param item key
@@ -85,6 +201,13 @@ private:
    */
   quadruple::item table_lookup(const quadruple::item &item);
 
+  /**
+   * @brief Get the value of an operand of an operation
+   * @param item The operand
+   * @return The number itself, or the mapped value of a tmp
+   */
+  quadruple::item resolve_operand(const quadruple::item &item);
+
   /**
    * @brief Insert a item into table
    * @param key key
@@ -103,10 +226,18 @@ private:
    * @brief Optimized quadruple count
    */
   unsigned int _optimized_count = 1;
+  /**
+   * @brief Eliminated quadruple count
+   */
+  unsigned int _eliminated_count = 0;
   /**
    * @brief DAG table, used to store the mapping relationship of DAG nodes
    */
-  unordered_map<quadruple::item, quadruple::item> _table;
+  open_hash_map<quadruple::item, quadruple::item> _table;
+  /**
+   * @brief Value numbering table, maps an operation to the tmp holding it
+   */
+  open_hash_map<value_key, quadruple::item> _value_numbers;
   /**
    * @brief Origin nodes
    */
@@ -119,6 +250,30 @@ private:
    * @brief Operand stack, used to store intermediate results
    */
   stack<quadruple::item> _operand_stack;
+  /**
+   * @brief Whether a batch is being optimized
+   */
+  bool _batching = false;
+  /**
+   * @brief The expression computing each optimized node of the batch
+   */
+  vector<size_t> _batch_owners;
+  /**
+   * @brief Whether each optimized node of the batch goes into the prelude
+   */
+  vector<bool> _batch_shared;
+  /**
+   * @brief The value of each expression of the batch
+   */
+  vector<quadruple::item> _batch_results;
+  /**
+   * @brief Quadruples shared by the expressions of the batch
+   */
+  vector<quadruple> _batch_prelude;
+  /**
+   * @brief Quadruples of each expression of the batch
+   */
+  vector<vector<quadruple>> _batch_expressions;
 };
 
 #endif // LIB_6CXX_DAG_OPTIMIZER_H
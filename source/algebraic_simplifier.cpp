@@ -0,0 +1,175 @@
+#include "algebraic_simplifier.h"
+
+#include <climits>
+#include <vector>
+
+using std::vector;
+
+/**
+ * @brief Get the exponent of a power of two
+ * @param value The number
+ * @return k if value is 2^k with k > 0, otherwise 0
+ */
+static int power_of_two(int value) {
+  if (value <= 1 || (value & (value - 1)) != 0) {
+    return 0;
+  }
+  int exponent = 0;
+  while (value > 1) {
+    value >>= 1;
+    ++exponent;
+  }
+  return exponent;
+}
+
+/**
+ * @brief Judge if an item is a specific number
+ * @param item The item
+ * @param value The number
+ * @return true The item is the number
+ * @return false The item is not the number
+ */
+static inline bool is_number(const quadruple::item &item, int value) {
+  return item.first == quadruple::number && item.second == value;
+}
+
+void algebraic_simplifier::simplify_quadruples() {
+  _simplified_nodes.reserve(_origin_nodes.size());
+
+  for (const quadruple &origin : this->_origin_nodes) {
+    quadruple quad = origin;
+    quad.operand1 = resolve(quad.operand1);
+
+    if (quad.op == '=') {
+      _values[quad.count] = quad.operand1;
+    } else {
+      quad.operand2 = resolve(quad.operand2);
+      simplify_operation(quad);
+    }
+
+    _simplified_nodes.push_back(quad);
+  }
+}
+
+bool algebraic_simplifier::fold(char op, int left, int right, int &result) {
+  unsigned int l = static_cast<unsigned int>(left);
+  unsigned int r = static_cast<unsigned int>(right);
+
+  switch (op) {
+  case '+':
+    result = static_cast<int>(l + r);
+    return true;
+  case '-':
+    result = static_cast<int>(l - r);
+    return true;
+  case '*':
+    result = static_cast<int>(l * r);
+    return true;
+  case '/':
+    if (right == 0 || (left == INT_MIN && right == -1)) {
+      return false;
+    }
+    result = left / right;
+    return true;
+  case quadruple::shift_left:
+    if (right < 0 || right >= 32) {
+      return false;
+    }
+    result = static_cast<int>(l << r);
+    return true;
+  default:
+    return false;
+  }
+}
+
+void algebraic_simplifier::simplify_operation(quadruple &quad) {
+  const quadruple::item &a = quad.operand1;
+  const quadruple::item &b = quad.operand2;
+
+  // constant folding
+  int value;
+  if (a.first == quadruple::number && b.first == quadruple::number &&
+      fold(quad.op, a.second, b.second, value)) {
+    ++_folded_count;
+    assign(quad, {quadruple::number, value});
+    return;
+  }
+
+  // algebraic identities
+  switch (quad.op) {
+  case '+':
+    if (is_number(a, 0)) {
+      ++_identity_count;
+      return assign(quad, b);
+    } else if (is_number(b, 0)) {
+      ++_identity_count;
+      return assign(quad, a);
+    }
+    break;
+  case '-':
+    if (is_number(b, 0)) {
+      ++_identity_count;
+      return assign(quad, a);
+    } else if (a == b) {
+      ++_identity_count;
+      return assign(quad, {quadruple::number, 0});
+    }
+    break;
+  case '*':
+    if (is_number(a, 0) || is_number(b, 0)) {
+      ++_identity_count;
+      return assign(quad, {quadruple::number, 0});
+    } else if (is_number(a, 1)) {
+      ++_identity_count;
+      return assign(quad, b);
+    } else if (is_number(b, 1)) {
+      ++_identity_count;
+      return assign(quad, a);
+    }
+    break;
+  case '/':
+  case quadruple::shift_left:
+    if (is_number(b, quad.op == '/' ? 1 : 0)) {
+      ++_identity_count;
+      return assign(quad, a);
+    }
+    break;
+  default:
+    break;
+  }
+
+  // strength reduction of multiplications by powers of two
+  if (quad.op == '*') {
+    quadruple::item x = a;
+    int exponent = b.first == quadruple::number ? power_of_two(b.second) : 0;
+    if (exponent == 0 && a.first == quadruple::number) {
+      x = b;
+      exponent = power_of_two(a.second);
+    }
+
+    if (exponent == 1) {
+      ++_reduced_count;
+      quad.op = '+';
+      quad.operand1 = x;
+      quad.operand2 = x;
+    } else if (exponent > 1) {
+      ++_reduced_count;
+      quad.op = quadruple::shift_left;
+      quad.operand1 = x;
+      quad.operand2 = {quadruple::number, exponent};
+    }
+  }
+}
+
+void algebraic_simplifier::assign(quadruple &quad,
+                                  const quadruple::item &value) {
+  quad.op = '=';
+  quad.operand1 = value;
+  quad.operand2 = {quadruple::empty, 0};
+  _values[quad.count] = value;
+}
+
+quadruple::item algebraic_simplifier::resolve(const quadruple::item &item) {
+  const quadruple::item *value = _values.find(item);
+  return value != nullptr ? *value : item;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file algebraic_simplifier.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Constant folding, algebraic simplification and strength reduction
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_ALGEBRAIC_SIMPLIFIER_H
+#define LIB_7CXX_ALGEBRAIC_SIMPLIFIER_H
+
+#include "DAG_optimizer.h"
+#include "intermediate_code_generator.h"
+#include "open_hash_map.h"
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * @brief Simplify quadruples before they are optimized by `DAG_optimizer`.
+ *
+ * Operands are propagated through known values, then every operation is
+ * 1. folded, if both operands are numbers: `(*, 2, 3, T3)` -> `(:=, 6, , T3)`
+ * 2. simplified with an algebraic identity: `x+0`, `x-0`, `x*1`, `x/1` -> `x`,
+ *    `x*0`, `x-x` -> `0`
+ * 3. strength reduced: `x*2` -> `x+x`, `x*2^k` -> `x<<k`
+ *
+ * A simplified operation becomes an assignment `:=`, which is resolved by
+ * `DAG_optimizer`. Divisions by powers of two are kept, because a shift
+ * rounds negative numbers towards negative infinity.
+ */
+class algebraic_simplifier {
+public:
+  /**
+   * @brief Read origin nodes from vector
+   * @param nodes nodes
+   */
+  inline void read_origin_nodes(const vector<quadruple> &nodes) {
+    clear();
+    _origin_nodes = nodes;
+  }
+
+  /**
+   * @brief Simplify the origin quadruples
+   */
+  void simplify_quadruples();
+
+  /**
+   * @brief Get simplified quadruples
+   * @return simplified quadruples
+   */
+  inline const vector<quadruple> &get_simplified() const {
+    return _simplified_nodes;
+  }
+
+  /**
+   * @brief Get the number of operations folded into constants
+   * @return The number of folded operations
+   */
+  inline unsigned int get_folded_count() const { return _folded_count; }
+
+  /**
+   * @brief Get the number of operations removed by algebraic identities
+   * @return The number of simplified operations
+   */
+  inline unsigned int get_identity_count() const { return _identity_count; }
+
+  /**
+   * @brief Get the number of operations replaced by cheaper ones
+   * @return The number of strength reduced operations
+   */
+  inline unsigned int get_reduced_count() const { return _reduced_count; }
+
+  /**
+   * @brief Clear all data, ready for next simplification
+   */
+  inline void clear() {
+    _folded_count = 0;
+    _identity_count = 0;
+    _reduced_count = 0;
+    _values.clear();
+    _origin_nodes.clear();
+    _simplified_nodes.clear();
+  }
+
+  /**
+   * @brief Compute an operation on two numbers, with the wrap-around of
+   * two's complement integers
+   * @param op The operator
+   * @param left The left operand
+   * @param right The right operand
+   * @param result The result
+   * @return true The operation is computed
+   * @return false The operation is undefined (division by zero or overflow)
+   */
+  static bool fold(char op, int left, int right, int &result);
+
+private:
+  /**
+   * @brief Simplify an operation on resolved operands
+   * @param quad The operation, rewritten in place
+   */
+  void simplify_operation(quadruple &quad);
+
+  /**
+   * @brief Replace an operation by an assignment of a known value
+   * @param quad The operation
+   * @param value The value of the operation
+   */
+  void assign(quadruple &quad, const quadruple::item &value);
+
+  /**
+   * @brief Get the known value of an operand
+   * @param item The operand
+   * @return The value, or the operand itself if its value is unknown
+   */
+  quadruple::item resolve(const quadruple::item &item);
+
+private:
+  unsigned int _folded_count = 0;   // Folded operation count
+  unsigned int _identity_count = 0; // Simplified operation count
+  unsigned int _reduced_count = 0;  // Strength reduced operation count
+  /**
+   * @brief Known values of tmps, a number or another tmp
+   */
+  open_hash_map<quadruple::item, quadruple::item> _values;
+  /**
+   * @brief Origin nodes
+   */
+  vector<quadruple> _origin_nodes;
+  /**
+   * @brief Simplified nodes
+   */
+  vector<quadruple> _simplified_nodes;
+};
+
+#endif // LIB_7CXX_ALGEBRAIC_SIMPLIFIER_H
@@ -81,19 +81,31 @@ struct analysis_table_row {
  */
 class analysis_table_row_reader {
  private:
-  /**
-   * @brief The name of the csv file
-   *
-   */
-  const char *_file_name = "../data/analysis_table.csv";
-
   /**
    * @brief The `ifstream` data reader
    */
   ifstream _fin;
 
  public:
-  inline analysis_table_row_reader() : _fin(_file_name) {
+  /**
+   * @brief Get the name of the csv file read by default
+   *
+   * @return const char* The name
+   */
+  static inline const char *default_file_name() {
+    return "../data/analysis_table.csv";
+  }
+
+  inline analysis_table_row_reader()
+      : analysis_table_row_reader(default_file_name()) {}
+
+  /**
+   * @brief Open a csv file
+   *
+   * @param file_name The name of the csv file
+   */
+  inline explicit analysis_table_row_reader(const string &file_name)
+      : _fin(file_name) {
     if (!_fin.is_open()) {
       throw std::ios::failure("File for analysis _table reader is not opened.");
     }
@@ -114,6 +126,15 @@ class analysis_table {
  public:
   inline analysis_table() { parse_table(_reader.read_table()); }
 
+  /**
+   * @brief Read the _table from a csv file
+   *
+   * @param file_name The name of the csv file
+   */
+  inline explicit analysis_table(const string &file_name) : _reader(file_name) {
+    parse_table(_reader.read_table());
+  }
+
   analysis_table(const analysis_table &other) = delete;
 
   ~analysis_table() = default;
@@ -121,9 +142,9 @@ class analysis_table {
   /**
    * @brief Get the _table object
    *
-   * @return const vector<analysis_table_row> The parsed _table, ready to use
+   * @return const vector<analysis_table_row>& The parsed _table, ready to use
    */
-  vector<analysis_table_row> get_table() const { return _table; }
+  const vector<analysis_table_row> &get_table() const { return _table; }
 
   /**
    * @brief operator[] overloard
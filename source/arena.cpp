@@ -0,0 +1,68 @@
+#include "arena.h"
+
+#include <utility>
+
+const size_t arena::default_chunk_size;
+
+arena::arena(size_t chunk_size)
+    : _next_chunk_size(chunk_size < 1 ? 1 : chunk_size) {}
+
+arena::arena(void *buffer, size_t size, size_t chunk_size)
+    : _next_chunk_size(chunk_size < 1 ? 1 : chunk_size) {
+  if (buffer != nullptr && size > 0) {
+    _chunks.push_back({static_cast<char *>(buffer), size, nullptr});
+    use_chunk(0);
+  }
+}
+
+void arena::reset() {
+  _used_before = 0;
+  if (_chunks.empty()) {
+    _current = nullptr;
+    _cursor = _end = 0;
+  } else {
+    use_chunk(0);
+  }
+}
+
+size_t arena::get_used() const { return _used_before + _cursor; }
+
+size_t arena::get_capacity() const {
+  size_t capacity = 0;
+  for (const chunk &c : _chunks) {
+    capacity += c.size;
+  }
+  return capacity;
+}
+
+void *arena::allocate_slow(size_t size, size_t alignment) {
+  // padding is at most `alignment - 1`, so a chunk this big always fits
+  size_t needed = size + alignment - 1;
+
+  // chunks kept by `reset` come first, too small ones are skipped
+  size_t next = _current == nullptr ? _index : _index + 1;
+  while (next < _chunks.size() && _chunks[next].size < needed) {
+    _used_before += _chunks[next].size;
+    ++next;
+  }
+  if (next == _chunks.size()) {
+    size_t chunk_size = _next_chunk_size < needed ? needed : _next_chunk_size;
+    unique_ptr<char[]> memory(new char[chunk_size]);
+    char *start = memory.get();
+    _chunks.push_back({start, chunk_size, std::move(memory)});
+    _next_chunk_size = 2 * chunk_size;
+  }
+
+  if (_current != nullptr) {
+    _used_before += _end;
+  }
+  use_chunk(next);
+  return allocate(size, alignment);
+}
+
+void arena::use_chunk(size_t index) {
+  _index = index;
+  _current = _chunks[index].memory;
+  _cursor = 0;
+  _end = _chunks[index].size;
+}
@@ -0,0 +1,212 @@
+/**
+ * @file arena.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Monotonic arena for the transient data of one compilation
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_ARENA_H
+#define LIB_7CXX_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+using std::size_t;
+using std::unique_ptr;
+using std::vector;
+
+/**
+ * @brief A monotonic memory resource: memory is handed out by bumping a
+ * pointer through chunks, freeing a single allocation does nothing, and
+ * `reset` releases everything at once.
+ *
+ * The stages take the data which lives for one compilation only, such as
+ * the token list and the semantic tree, from the arena of the job, so
+ * tearing a compilation down is one `reset` instead of a free per node. The
+ * chunks are kept by `reset` and reused, and nothing is locked: an arena
+ * serves one compilation at a time, every thread has its own.
+ */
+class arena {
+public:
+  /**
+   * @brief Construct an arena, no memory is taken before the first allocation
+   * @param chunk_size The size of the first chunk, every later chunk doubles
+   */
+  explicit arena(size_t chunk_size = default_chunk_size);
+
+  /**
+   * @brief Construct an arena which starts with a buffer of the caller
+   * @param buffer The buffer, it must outlive the arena
+   * @param size The size of the buffer
+   * @param chunk_size The size of the first chunk taken from the heap once
+   * the buffer is used up
+   */
+  arena(void *buffer, size_t size, size_t chunk_size = default_chunk_size);
+
+  arena(const arena &) = delete;
+
+  /**
+   * @brief Allocate memory
+   * @param size The size
+   * @param alignment The alignment, a power of two
+   * @return The memory
+   * @throw std::bad_alloc Out of memory
+   */
+  inline void *allocate(size_t size,
+                        size_t alignment = alignof(std::max_align_t)) {
+    if (_current == nullptr) {
+      return allocate_slow(size, alignment);
+    }
+    char *free = _current + _cursor;
+    size_t padding =
+        static_cast<size_t>(-reinterpret_cast<std::uintptr_t>(free)) &
+        (alignment - 1);
+    if (padding + size > _end - _cursor) {
+      return allocate_slow(size, alignment);
+    }
+    _cursor += padding + size;
+    return free + padding;
+  }
+
+  /**
+   * @brief Free memory, which only happens on `reset`
+   */
+  inline void deallocate(void *, size_t) {}
+
+  /**
+   * @brief Release everything allocated so far, the chunks are kept for the
+   * next allocations
+   * @warning Everything allocated from the arena must be destroyed first
+   */
+  void reset();
+
+  /**
+   * @brief Get the bytes used up since the last `reset`, with the padding and
+   * the unused ends of chunks left behind
+   * @return The bytes
+   */
+  size_t get_used() const;
+
+  /**
+   * @brief Get the bytes of all chunks, the buffer of the caller included
+   * @return The bytes
+   */
+  size_t get_capacity() const;
+
+  /**
+   * @brief The default size of the first chunk
+   */
+  static const size_t default_chunk_size = 64 << 10;
+
+private:
+  /**
+   * @brief A chunk, the buffer of the caller has no owner
+   */
+  struct chunk {
+    char *memory;             // The memory
+    size_t size;              // Its size
+    unique_ptr<char[]> owner; // The memory, if taken from the heap
+  };
+
+  /**
+   * @brief Move on to the next kept chunk which fits an allocation, or take a
+   * new one from the heap, and allocate from it
+   * @param size The size
+   * @param alignment The alignment
+   * @return The memory
+   */
+  void *allocate_slow(size_t size, size_t alignment);
+
+  /**
+   * @brief Make a chunk the current one
+   * @param index The index of the chunk
+   */
+  void use_chunk(size_t index);
+
+private:
+  vector<chunk> _chunks;     // All chunks, in the order they are used
+  size_t _index = 0;         // The index of the current chunk
+  char *_current = nullptr;  // The current chunk, null before the first
+  size_t _cursor = 0;        // The first free byte of the current chunk
+  size_t _end = 0;           // The size of the current chunk
+  size_t _used_before = 0;   // Bytes handed out from earlier chunks
+  size_t _next_chunk_size;   // The size of the next chunk from the heap
+};
+
+/**
+ * @brief A standard allocator on an arena, for the containers and trees of a
+ * compilation. Without an arena it falls back to `operator new`, so the same
+ * container type serves both. The allocator moves with the memory when
+ * containers are swapped or assigned.
+ *
+ * @tparam T The type of the objects
+ */
+template <typename T> class arena_allocator {
+public:
+  typedef T value_type;
+  typedef std::true_type propagate_on_container_copy_assignment;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  /**
+   * @brief Construct an allocator
+   * @param memory The arena, or null for the heap
+   */
+  arena_allocator(arena *memory = nullptr) : _arena(memory) {}
+
+  /**
+   * @brief Construct an allocator for another type on the same arena
+   * @param other The other allocator
+   */
+  template <typename U>
+  arena_allocator(const arena_allocator<U> &other)
+      : _arena(other.get_arena()) {}
+
+  /**
+   * @brief Allocate objects
+   * @param count The number of objects
+   * @return The memory
+   */
+  inline T *allocate(size_t count) {
+    if (_arena == nullptr) {
+      return static_cast<T *>(::operator new(count * sizeof(T)));
+    }
+    return static_cast<T *>(_arena->allocate(count * sizeof(T), alignof(T)));
+  }
+
+  /**
+   * @brief Free objects, memory of an arena is freed by its `reset`
+   * @param objects The memory
+   */
+  inline void deallocate(T *objects, size_t) {
+    if (_arena == nullptr) {
+      ::operator delete(objects);
+    }
+  }
+
+  /**
+   * @brief Get the arena
+   * @return The arena, or null for the heap
+   */
+  inline arena *get_arena() const { return _arena; }
+
+private:
+  arena *_arena; // The arena, or null for the heap
+};
+
+template <typename T, typename U>
+inline bool operator==(const arena_allocator<T> &a,
+                       const arena_allocator<U> &b) {
+  return a.get_arena() == b.get_arena();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const arena_allocator<T> &a,
+                       const arena_allocator<U> &b) {
+  return !(a == b);
+}
+
+#endif // LIB_7CXX_ARENA_H
@@ -0,0 +1,287 @@
+#include "assembly_generator.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::logic_error;
+using std::to_string;
+
+/**
+ * @brief An allocatable register
+ */
+struct register_name {
+  const char *name32;  // The 32-bit name, used by the operations
+  const char *name64;  // The 64-bit name, used to save and restore it
+  bool callee_saved;   // Whether the function must preserve it
+};
+
+// caller-saved registers come first, so small functions save nothing
+static const register_name registers[] = {
+    {"%ecx", "%rcx", false},  {"%esi", "%rsi", false},
+    {"%edi", "%rdi", false},  {"%r8d", "%r8", false},
+    {"%r9d", "%r9", false},   {"%r10d", "%r10", false},
+    {"%ebx", "%rbx", true},   {"%r12d", "%r12", true},
+    {"%r13d", "%r13", true},  {"%r14d", "%r14", true},
+    {"%r15d", "%r15", true}};
+
+static const int register_count =
+    static_cast<int>(sizeof(registers) / sizeof(registers[0]));
+
+/**
+ * @brief Judge if an item is a tmp
+ * @param item The item
+ * @return true The item is a tmp
+ * @return false The item is a number or empty
+ */
+static inline bool is_tmp(const quadruple::item &item) {
+  return item.first == quadruple::T || item.first == quadruple::optimized;
+}
+
+void assembly_generator::compute_live_ranges() {
+  unordered_map<quadruple::item, size_t> range_index;
+
+  for (size_t index = 0; index < _origin_nodes.size(); ++index) {
+    const quadruple &quad = _origin_nodes[index];
+
+    for (const quadruple::item *operand : {&quad.operand1, &quad.operand2}) {
+      if (!is_tmp(*operand)) {
+        continue;
+      }
+      auto it = range_index.find(*operand);
+      if (it == range_index.end()) {
+        throw logic_error("Undefined variable: " +
+                          quadruple::item2str(*operand));
+      }
+      _live_ranges[it->second].end = index;
+    }
+
+    if (!range_index.emplace(quad.count, _live_ranges.size()).second) {
+      throw logic_error("Redefinition of " + quadruple::item2str(quad.count));
+    }
+    _live_ranges.push_back({quad.count, index, index});
+  }
+
+  // the result is read by the return sequence
+  if (!_live_ranges.empty()) {
+    _live_ranges[range_index[_origin_nodes.back().count]].end =
+        _origin_nodes.size();
+  }
+}
+
+void assembly_generator::allocate_registers() {
+  _live_ranges.clear();
+  _locations.clear();
+  _spill_count = 0;
+
+  compute_live_ranges();
+
+  vector<size_t> active; // ranges holding a register, sorted by end
+  vector<bool> used(register_count, false);
+  vector<bool> ever_used(register_count, false);
+
+  auto by_end = [this](size_t l, size_t r) {
+    return _live_ranges[l].end < _live_ranges[r].end;
+  };
+
+  for (size_t current = 0; current < _live_ranges.size(); ++current) {
+    const live_range &range = _live_ranges[current];
+
+    // expire ranges which end here, their registers are read before the
+    // result of this quadruple is written
+    while (!active.empty() && _live_ranges[active.front()].end <= range.start) {
+      used[_locations[_live_ranges[active.front()].tmp].reg] = false;
+      active.erase(active.begin());
+    }
+
+    auto free_reg = std::find(used.begin(), used.end(), false);
+    if (free_reg != used.end()) {
+      int reg = static_cast<int>(free_reg - used.begin());
+      used[reg] = true;
+      ever_used[reg] = true;
+      _locations[range.tmp] = {reg, -1};
+      active.insert(std::upper_bound(active.begin(), active.end(), current,
+                                     by_end),
+                    current);
+      continue;
+    }
+
+    // spill the range which ends last
+    size_t victim = active.back();
+    if (_live_ranges[victim].end > range.end) {
+      location &victim_location = _locations[_live_ranges[victim].tmp];
+      _locations[range.tmp] = {victim_location.reg, -1};
+      victim_location = {-1, static_cast<int>(_spill_count++)};
+      active.pop_back();
+      active.insert(std::upper_bound(active.begin(), active.end(), current,
+                                     by_end),
+                    current);
+    } else {
+      _locations[range.tmp] = {-1, static_cast<int>(_spill_count++)};
+    }
+  }
+
+  _saved_count = 0;
+  for (int reg = 0; reg < register_count; ++reg) {
+    if (ever_used[reg] && registers[reg].callee_saved) {
+      ++_saved_count;
+    }
+  }
+}
+
+void assembly_generator::generate_assembly(const string &function_name) {
+  if (_origin_nodes.empty()) {
+    throw logic_error("No quadruples to generate assembly for");
+  }
+  if (_locations.empty()) {
+    allocate_registers();
+  }
+
+  _assembly.clear();
+  _assembly += "\t.text\n";
+  _assembly += "\t.globl\t" + function_name + "\n";
+  _assembly += "\t.type\t" + function_name + ", @function\n";
+  _assembly += function_name + ":\n";
+
+  // prologue
+  emit("pushq", "%rbp");
+  emit("movq", "%rsp, %rbp");
+  vector<int> saved;
+  for (int reg = 0; reg < register_count; ++reg) {
+    if (!registers[reg].callee_saved) {
+      continue;
+    }
+    for (const auto &entry : _locations) {
+      if (entry.second.reg == reg) {
+        saved.push_back(reg);
+        emit("pushq", registers[reg].name64);
+        break;
+      }
+    }
+  }
+  size_t frame = (_spill_count * 4 + 15) / 16 * 16;
+  if (frame > 0) {
+    emit("subq", "$" + to_string(frame) + ", %rsp");
+  }
+
+  // body
+  for (const quadruple &quad : _origin_nodes) {
+    emit_quadruple(quad);
+  }
+
+  // epilogue
+  emit("movl", operand(_origin_nodes.back().count) + ", %eax");
+  if (!saved.empty()) {
+    emit("leaq", "-" + to_string(saved.size() * 8) + "(%rbp), %rsp");
+    for (auto reg = saved.rbegin(); reg != saved.rend(); ++reg) {
+      emit("popq", registers[*reg].name64);
+    }
+    emit("popq", "%rbp");
+  } else {
+    emit("leave");
+  }
+  emit("ret");
+
+  _assembly += "\t.size\t" + function_name + ", .-" + function_name + "\n";
+  _assembly += "\t.section\t.note.GNU-stack,\"\",@progbits\n";
+}
+
+string assembly_generator::operand(const quadruple::item &item) const {
+  if (item.first == quadruple::number) {
+    return "$" + to_string(item.second);
+  }
+
+  auto it = _locations.find(item);
+  if (it == _locations.end()) {
+    throw logic_error("Unallocated variable: " + quadruple::item2str(item));
+  }
+  if (it->second.reg >= 0) {
+    return registers[it->second.reg].name32;
+  }
+  return "-" + to_string(_saved_count * 8 + (it->second.slot + 1) * 4) +
+         "(%rbp)";
+}
+
+bool assembly_generator::in_register(const quadruple::item &item) const {
+  if (!is_tmp(item)) {
+    return false;
+  }
+  auto it = _locations.find(item);
+  return it != _locations.end() && it->second.reg >= 0;
+}
+
+void assembly_generator::emit_quadruple(const quadruple &quad) {
+  string dest = operand(quad.count);
+  string a = operand(quad.operand1);
+
+  switch (quad.op) {
+  case '=':
+    if (a == dest) {
+      return;
+    }
+    if (in_register(quad.count) || !is_tmp(quad.operand1) ||
+        in_register(quad.operand1)) {
+      emit("movl", a + ", " + dest);
+    } else {
+      emit("movl", a + ", %eax");
+      emit("movl", "%eax, " + dest);
+    }
+    return;
+  case '+':
+  case '-':
+  case '*':
+  case quadruple::shift_left: {
+    string mnemonic = quad.op == '+'   ? "addl"
+                      : quad.op == '-' ? "subl"
+                      : quad.op == '*' ? "imull"
+                                       : "sall";
+    if (quad.op == quadruple::shift_left &&
+        quad.operand2.first != quadruple::number) {
+      throw logic_error("Shift by a variable amount is not supported");
+    }
+    string b = operand(quad.operand2);
+
+    // compute in place when the result has a register which does not hold
+    // the second operand, the operands of + and * may be swapped for that
+    if (in_register(quad.count) && b == dest &&
+        (quad.op == '+' || quad.op == '*')) {
+      std::swap(a, b);
+    }
+    if (in_register(quad.count) && b != dest) {
+      if (a != dest) {
+        emit("movl", a + ", " + dest);
+      }
+      emit(mnemonic, b + ", " + dest);
+    } else {
+      emit("movl", a + ", %eax");
+      emit(mnemonic, b + ", %eax");
+      emit("movl", "%eax, " + dest);
+    }
+    return;
+  }
+  case '/': {
+    string b = operand(quad.operand2);
+    emit("movl", a + ", %eax");
+    emit("cltd");
+    if (quad.operand2.first == quadruple::number) {
+      emit("movl", b + ", %r11d");
+      b = "%r11d";
+    }
+    emit("idivl", b);
+    emit("movl", "%eax, " + dest);
+    return;
+  }
+  default:
+    throw logic_error(string("unexpected operator") + quad.op);
+  }
+}
+
+void assembly_generator::emit(const string &mnemonic, const string &operands) {
+  _assembly += "\t" + mnemonic;
+  if (!operands.empty()) {
+    _assembly += "\t" + operands;
+  }
+  _assembly += "\n";
+}
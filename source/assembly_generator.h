@@ -0,0 +1,149 @@
+/**
+ * @file assembly_generator.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Linear-scan register allocation and x86-64 assembly generation
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_ASSEMBLY_GENERATOR_H
+#define LIB_7CXX_ASSEMBLY_GENERATOR_H
+
+#include "DAG_optimizer.h"
+#include "intermediate_code_generator.h"
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::ostream;
+using std::size_t;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+/**
+ * @brief Generate a GNU assembler (AT&T syntax) file for x86-64 from
+ * quadruples.
+ *
+ * The generated function has the signature `int name(void)` and returns the
+ * result of the last quadruple. Tmps are assigned to general purpose registers
+ * by linear scan over their live ranges; when registers run out, the tmp whose
+ * range ends last is spilled to the stack frame. `%eax` and `%edx` are kept
+ * for `idiv` and `%r11d` for divisors which are numbers.
+ */
+class assembly_generator {
+public:
+  /**
+   * @brief The location of a tmp
+   */
+  struct location {
+    int reg;  // Index into the register table, -1 if spilled
+    int slot; // Index of the stack slot if spilled, -1 otherwise
+  };
+
+  /**
+   * @brief The live range of a tmp
+   */
+  struct live_range {
+    quadruple::item tmp; // The tmp
+    size_t start;        // Index of the defining quadruple
+    size_t end;          // Index of the last using quadruple
+  };
+
+public:
+  /**
+   * @brief Read origin nodes from vector
+   * @param nodes nodes
+   */
+  inline void read_origin_nodes(const vector<quadruple> &nodes) {
+    clear();
+    _origin_nodes = nodes;
+  }
+
+  /**
+   * @brief Compute live ranges and assign every tmp a register or a slot
+   */
+  void allocate_registers();
+
+  /**
+   * @brief Generate the assembly of a function returning the result
+   * @param function_name The symbol of the function
+   */
+  void generate_assembly(const string &function_name);
+
+  /**
+   * @brief Get the generated assembly
+   * @return The content of the `.s` file
+   */
+  inline const string &get_assembly() const { return _assembly; }
+
+  /**
+   * @brief Get the live ranges, sorted by start
+   * @return The live ranges
+   */
+  inline const vector<live_range> &get_live_ranges() const {
+    return _live_ranges;
+  }
+
+  /**
+   * @brief Get the number of tmps spilled to the stack
+   * @return The number of spilled tmps
+   */
+  inline size_t get_spill_count() const { return _spill_count; }
+
+  /**
+   * @brief Clear all data, ready for next generation
+   */
+  inline void clear() {
+    _spill_count = 0;
+    _origin_nodes.clear();
+    _live_ranges.clear();
+    _locations.clear();
+    _assembly.clear();
+  }
+
+private:
+  /**
+   * @brief Compute the live range of every tmp
+   */
+  void compute_live_ranges();
+
+  /**
+   * @brief Get the operand text of an item
+   * @param item A number or a tmp
+   * @return `$n`, `%reg` or `-n(%rbp)`
+   */
+  string operand(const quadruple::item &item) const;
+
+  /**
+   * @brief Judge if an item lives in a register
+   * @param item The item
+   * @return true The item is a tmp in a register
+   * @return false Otherwise
+   */
+  bool in_register(const quadruple::item &item) const;
+
+  /**
+   * @brief Emit one quadruple
+   * @param quad The quadruple
+   */
+  void emit_quadruple(const quadruple &quad);
+
+  /**
+   * @brief Emit an instruction
+   * @param mnemonic The mnemonic
+   * @param operands The operands in AT&T order
+   */
+  void emit(const string &mnemonic, const string &operands = "");
+
+private:
+  size_t _spill_count = 0;                           // Spilled tmp count
+  size_t _saved_count = 0;                           // Saved register count
+  vector<quadruple> _origin_nodes;                   // Origin nodes
+  vector<live_range> _live_ranges;                   // Live ranges
+  unordered_map<quadruple::item, location> _locations; // Tmp locations
+  string _assembly;                                  // Generated assembly
+};
+
+#endif // LIB_7CXX_ASSEMBLY_GENERATOR_H
@@ -0,0 +1,469 @@
+#include "batch_io.h"
+
+#include <fstream>
+#include <ios>
+#include <iterator>
+
+#ifdef PL0_IO_URING
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+using std::ifstream;
+using std::ios_base;
+using std::ofstream;
+
+const size_t batch_io::files_in_flight;
+
+#ifdef PL0_IO_URING
+
+/**
+ * @brief The operations of a file, kept in the low bits of `user_data`
+ */
+enum ring_operation {
+  ring_open,  // open the file
+  ring_statx, // get the size of a file to read
+  ring_read,  // read the next part
+  ring_write, // write the next part
+  ring_close, // close the file
+  ring_operation_bits = 3
+};
+
+/**
+ * @brief A file in flight
+ */
+struct ring_file {
+  int fd = -1;              // The descriptor, -1 before it is open
+  unsigned int pending = 0; // Operations in flight
+  size_t offset = 0;        // Bytes read or written so far
+  struct statx stat;        // The size of a file to read
+};
+
+/**
+ * @brief A ring set up with raw system calls, the SQ and CQ rings and the
+ * SQEs are mapped from the kernel. A file has at most two operations in
+ * flight, so the rings never fill up.
+ */
+struct batch_io::ring {
+  int fd = -1;                      // The ring
+  void *sq_map = MAP_FAILED;        // Mapped SQ ring
+  size_t sq_map_size = 0;           // Its size
+  void *cq_map = MAP_FAILED;        // Mapped CQ ring, may be the SQ ring
+  size_t cq_map_size = 0;           // Its size
+  io_uring_sqe *sqes = nullptr;     // Mapped SQEs
+  size_t sqes_size = 0;             // Their size
+  unsigned int *sq_head = nullptr;  // Consumed by the kernel
+  unsigned int *sq_tail = nullptr;  // Produced here
+  unsigned int sq_mask = 0;         // Index mask of the SQ ring
+  unsigned int *sq_array = nullptr; // SQE indices
+  unsigned int sq_local_tail = 0;   // Tail before it is published
+  unsigned int *cq_head = nullptr;  // Consumed here
+  unsigned int *cq_tail = nullptr;  // Produced by the kernel
+  unsigned int cq_mask = 0;         // Index mask of the CQ ring
+  io_uring_cqe *cqes = nullptr;     // Completions
+  vector<ring_file> states;         // The files of the running batch
+
+  ~ring() {
+    if (sqes != nullptr) {
+      ::munmap(sqes, sqes_size);
+    }
+    if (cq_map != MAP_FAILED && cq_map != sq_map) {
+      ::munmap(cq_map, cq_map_size);
+    }
+    if (sq_map != MAP_FAILED) {
+      ::munmap(sq_map, sq_map_size);
+    }
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+
+  /**
+   * @brief Set up a ring
+   * @param entries The SQ entries
+   * @return true The ring is ready
+   * @return false The kernel has no usable io_uring
+   */
+  bool setup(unsigned int entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    // reads and writes at the file position came with the open, close and
+    // statx operations, in Linux 5.6
+    if (fd < 0 || (params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+      return false;
+    }
+
+    sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_map_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_map) {
+      sq_map_size = cq_map_size =
+          sq_map_size > cq_map_size ? sq_map_size : cq_map_size;
+    }
+    sq_map = ::mmap(nullptr, sq_map_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq_map == MAP_FAILED) {
+      return false;
+    }
+    cq_map = single_map ? sq_map
+                        : ::mmap(nullptr, cq_map_size, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, fd,
+                                 IORING_OFF_CQ_RING);
+    if (cq_map == MAP_FAILED) {
+      return false;
+    }
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqe_map = ::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqe_map == MAP_FAILED) {
+      return false;
+    }
+    sqes = static_cast<io_uring_sqe *>(sqe_map);
+
+    char *sq = static_cast<char *>(sq_map);
+    sq_head = reinterpret_cast<unsigned int *>(sq + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned int *>(sq + params.sq_off.tail);
+    sq_mask = *reinterpret_cast<unsigned int *>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned int *>(sq + params.sq_off.array);
+    sq_local_tail = *sq_tail;
+    char *cq = static_cast<char *>(cq_map);
+    cq_head = reinterpret_cast<unsigned int *>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned int *>(cq + params.cq_off.tail);
+    cq_mask = *reinterpret_cast<unsigned int *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  /**
+   * @brief Queue an operation of a file
+   * @param opcode The io_uring opcode
+   * @param index The index of the file
+   * @param operation The operation, returned with the completion
+   * @return The SQE to fill in
+   */
+  io_uring_sqe &queue(unsigned char opcode, size_t index,
+                      ring_operation operation) {
+    unsigned int slot = sq_local_tail & sq_mask;
+    io_uring_sqe &sqe = sqes[slot];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = opcode;
+    sqe.user_data =
+        (static_cast<uint64_t>(index) << ring_operation_bits) | operation;
+    sq_array[slot] = slot;
+    ++sq_local_tail;
+    ++states[index].pending;
+    return sqe;
+  }
+
+  /**
+   * @brief Submit the queued operations and wait for a completion
+   * @throw std::ios_base::failure The ring stopped working
+   */
+  void submit_and_wait() {
+    __atomic_store_n(sq_tail, sq_local_tail, __ATOMIC_RELEASE);
+    while (true) {
+      // what the kernel has not consumed yet, after an interruption too
+      unsigned int queued =
+          sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+      if (::syscall(__NR_io_uring_enter, fd, queued, 1,
+                    IORING_ENTER_GETEVENTS, nullptr, 0) >= 0) {
+        return;
+      }
+      if (errno != EINTR) {
+        throw ios_base::failure("io_uring_enter failed");
+      }
+    }
+  }
+
+  /**
+   * @brief Run a batch: start files while fewer than `files_in_flight` are
+   * open, and pass every completion on until all files are done
+   * @param files The files
+   * @param start Queue the first operations of a file
+   * @param complete Handle a completion, queueing the next operation
+   */
+  template <typename Start, typename Complete>
+  void run(vector<batch_file> &files, Start start, Complete complete) {
+    states.assign(files.size(), ring_file());
+    size_t next = 0;
+    size_t active = 0;
+    while (next < files.size() || active > 0) {
+      for (; next < files.size() && active < files_in_flight; ++next) {
+        if (!files[next].name.empty()) {
+          start(next);
+          ++active;
+        }
+      }
+      if (active == 0) {
+        break;
+      }
+      submit_and_wait();
+
+      unsigned int head = *cq_head;
+      unsigned int tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+      for (; head != tail; ++head) {
+        const io_uring_cqe &cqe = cqes[head & cq_mask];
+        size_t index =
+            static_cast<size_t>(cqe.user_data >> ring_operation_bits);
+        ring_operation operation = static_cast<ring_operation>(
+            cqe.user_data & ((1 << ring_operation_bits) - 1));
+        --states[index].pending;
+        complete(index, operation, cqe.res);
+        if (operation == ring_close && states[index].pending == 0) {
+          --active;
+        } else if (states[index].fd < 0 && states[index].pending == 0) {
+          // the open failed, there is nothing to close
+          --active;
+        }
+      }
+      __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+  }
+
+  /**
+   * @brief Queue the close of a file
+   * @param index The index of the file
+   */
+  void queue_close(size_t index) {
+    io_uring_sqe &sqe = queue(IORING_OP_CLOSE, index, ring_close);
+    sqe.fd = states[index].fd;
+  }
+
+  /**
+   * @brief Queue a read into the rest of the buffer of a file
+   * @param file The file
+   * @param index The index of the file
+   */
+  void queue_read(batch_file &file, size_t index) {
+    ring_file &state = states[index];
+    io_uring_sqe &sqe = queue(IORING_OP_READ, index, ring_read);
+    sqe.fd = state.fd;
+    sqe.addr = reinterpret_cast<uint64_t>(&file.data[state.offset]);
+    sqe.len = static_cast<unsigned int>(file.data.size() - state.offset);
+    sqe.off = state.offset;
+  }
+
+  /**
+   * @brief Queue a write of the rest of a file
+   * @param file The file
+   * @param index The index of the file
+   */
+  void queue_write(batch_file &file, size_t index) {
+    ring_file &state = states[index];
+    io_uring_sqe &sqe = queue(IORING_OP_WRITE, index, ring_write);
+    sqe.fd = state.fd;
+    sqe.addr = reinterpret_cast<uint64_t>(file.data.data() + state.offset);
+    sqe.len = static_cast<unsigned int>(file.data.size() - state.offset);
+    sqe.off = state.offset;
+  }
+
+  /**
+   * @brief Read files: open and statx together, then read into a buffer one
+   * byte bigger than the file, so a short read is the end of the file
+   * @param files The files
+   */
+  void read_files(vector<batch_file> &files) {
+    auto start = [&](size_t index) {
+      const char *name = files[index].name.c_str();
+      io_uring_sqe &open = queue(IORING_OP_OPENAT, index, ring_open);
+      open.fd = AT_FDCWD;
+      open.addr = reinterpret_cast<uint64_t>(name);
+      open.open_flags = O_RDONLY | O_CLOEXEC;
+      io_uring_sqe &stat = queue(IORING_OP_STATX, index, ring_statx);
+      stat.fd = AT_FDCWD;
+      stat.addr = reinterpret_cast<uint64_t>(name);
+      stat.len = STATX_SIZE;
+      stat.off = reinterpret_cast<uint64_t>(&states[index].stat);
+      states[index].stat.stx_size = 0;
+    };
+
+    auto complete = [&](size_t index, ring_operation operation, int result) {
+      batch_file &file = files[index];
+      ring_file &state = states[index];
+      switch (operation) {
+      case ring_open:
+        if (result < 0) {
+          file.error = "file " + file.name + " open failed";
+        } else {
+          state.fd = result;
+        }
+        break;
+      case ring_statx:
+        if (result < 0) {
+          state.stat.stx_size = 0;
+        }
+        break;
+      case ring_read:
+        if (result < 0) {
+          file.error = "file " + file.name + " read failed";
+          file.data.clear();
+          queue_close(index);
+          return;
+        }
+        state.offset += static_cast<size_t>(result);
+        if (result > 0 && state.offset == file.data.size()) {
+          // the file grew, read on
+          file.data.resize(2 * file.data.size());
+          queue_read(file, index);
+        } else {
+          file.data.resize(state.offset);
+          queue_close(index);
+        }
+        return;
+      default:
+        return;
+      }
+
+      // the first read waits for both the open and the statx
+      if (state.pending == 0 && state.fd >= 0) {
+        size_t size = static_cast<size_t>(state.stat.stx_size);
+        file.data.resize(size > 0 ? size + 1 : 4096);
+        queue_read(file, index);
+      }
+    };
+
+    run(files, start, complete);
+  }
+
+  /**
+   * @brief Write files: open, write until everything is written, close
+   * @param files The files
+   */
+  void write_files(vector<batch_file> &files) {
+    auto start = [&](size_t index) {
+      io_uring_sqe &open = queue(IORING_OP_OPENAT, index, ring_open);
+      open.fd = AT_FDCWD;
+      open.addr = reinterpret_cast<uint64_t>(files[index].name.c_str());
+      open.open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+      open.len = 0644;
+    };
+
+    auto complete = [&](size_t index, ring_operation operation, int result) {
+      batch_file &file = files[index];
+      ring_file &state = states[index];
+      switch (operation) {
+      case ring_open:
+        if (result < 0) {
+          file.error = "file " + file.name + " open failed";
+          return;
+        }
+        state.fd = result;
+        break;
+      case ring_write:
+        if (result < 0) {
+          file.error = "file " + file.name + " write failed";
+          queue_close(index);
+          return;
+        }
+        state.offset += static_cast<size_t>(result);
+        break;
+      case ring_close:
+        if (result < 0 && file.error.empty()) {
+          file.error = "file " + file.name + " write failed";
+        }
+        return;
+      default:
+        return;
+      }
+
+      // a regular file takes everything at once, write on after short writes
+      if (state.offset < file.data.size()) {
+        queue_write(file, index);
+      } else {
+        queue_close(index);
+      }
+    };
+
+    run(files, start, complete);
+  }
+};
+
+#else
+
+struct batch_io::ring {};
+
+#endif
+
+batch_io::batch_io() {
+#ifdef PL0_IO_URING
+  _ring = new ring();
+  if (!_ring->setup(2 * files_in_flight)) {
+    delete _ring;
+    _ring = nullptr;
+  }
+#endif
+}
+
+batch_io::~batch_io() { delete _ring; }
+
+void batch_io::read_files(vector<batch_file> &files) {
+  for (batch_file &file : files) {
+    file.data.clear();
+    file.error.clear();
+  }
+#ifdef PL0_IO_URING
+  if (_ring != nullptr) {
+    _ring->read_files(files);
+    return;
+  }
+#endif
+  for (batch_file &file : files) {
+    if (!file.name.empty()) {
+      read_blocking(file);
+    }
+  }
+}
+
+void batch_io::write_files(vector<batch_file> &files) {
+  for (batch_file &file : files) {
+    file.error.clear();
+  }
+#ifdef PL0_IO_URING
+  if (_ring != nullptr) {
+    _ring->write_files(files);
+    return;
+  }
+#endif
+  for (batch_file &file : files) {
+    if (!file.name.empty()) {
+      write_blocking(file);
+    }
+  }
+}
+
+void batch_io::read_blocking(batch_file &file) {
+  ifstream fin(file.name, ios_base::binary);
+  if (!fin.is_open()) {
+    file.error = "file " + file.name + " open failed";
+    return;
+  }
+  file.data.assign(std::istreambuf_iterator<char>(fin),
+                   std::istreambuf_iterator<char>());
+  if (fin.bad()) {
+    file.error = "file " + file.name + " read failed";
+    file.data.clear();
+  }
+}
+
+void batch_io::write_blocking(batch_file &file) {
+  ofstream fout(file.name, ios_base::binary | ios_base::trunc);
+  if (!fout.is_open()) {
+    file.error = "file " + file.name + " open failed";
+    return;
+  }
+  fout.write(file.data.data(), static_cast<std::streamsize>(file.data.size()));
+  fout.close();
+  if (fout.fail()) {
+    file.error = "file " + file.name + " write failed";
+  }
+}
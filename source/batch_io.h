@@ -0,0 +1,92 @@
+/**
+ * @file batch_io.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Batched reads and writes of many small files, with io_uring on Linux
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_BATCH_IO_H
+#define LIB_7CXX_BATCH_IO_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using std::size_t;
+using std::string;
+using std::vector;
+
+/**
+ * @brief A file read or written by `batch_io`
+ */
+struct batch_file {
+  string name;  // The name of the file, empty to skip it
+  string data;  // The contents read, or to write
+  string error; // Why it failed, empty on success
+};
+
+/**
+ * @brief Reads and writes whole files in batches.
+ *
+ * With io_uring, the opens, reads, writes and closes of up to
+ * `files_in_flight` files are submitted together and reaped as they
+ * complete, so a batch of small files costs a few `io_uring_enter` calls
+ * instead of four blocking system calls per file. Where io_uring is not
+ * compiled in (`PL0_IO_URING`), or the kernel refuses to set it up, the
+ * files are read and written one after another with blocking calls; the
+ * results are the same.
+ */
+class batch_io {
+public:
+  /**
+   * @brief Construct a new batch_io, setting up a ring if possible
+   */
+  batch_io();
+
+  batch_io(const batch_io &) = delete;
+
+  ~batch_io();
+
+  /**
+   * @brief Read whole files
+   * @param files The files, `data` and `error` are filled in
+   */
+  void read_files(vector<batch_file> &files);
+
+  /**
+   * @brief Write whole files, created or truncated
+   * @param files The files, `error` is filled in
+   */
+  void write_files(vector<batch_file> &files);
+
+  /**
+   * @brief Judge if the files go through io_uring
+   * @return true A ring is set up
+   * @return false Blocking calls are used
+   */
+  inline bool uses_io_uring() const { return _ring != nullptr; }
+
+  /**
+   * @brief The files a batch keeps open at the same time
+   */
+  static const size_t files_in_flight = 64;
+
+private:
+  struct ring;
+
+  /**
+   * @brief Read one file with blocking calls
+   * @param file The file
+   */
+  static void read_blocking(batch_file &file);
+
+  /**
+   * @brief Write one file with blocking calls
+   * @param file The file
+   */
+  static void write_blocking(batch_file &file);
+
+private:
+  ring *_ring = nullptr; // The ring, null without io_uring
+};
+
+#endif // LIB_7CXX_BATCH_IO_H
@@ -0,0 +1,762 @@
+#include "DAG_optimizer.h"
+#include "compiler.h"
+#include "compiler_pipeline.h"
+#include "expression_generator.h"
+#include "intermediate_code_generator.h"
+#include "lexical_analyzer.h"
+#include "semantic_analyzer.h"
+#include "slr1.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+typedef chrono::steady_clock bench_clock;
+
+// heap allocations of the process, counted by the replaced `operator new`
+static atomic<uint64_t> allocation_count(0);
+
+void *operator new(size_t size) {
+  allocation_count.fetch_add(1, memory_order_relaxed);
+  void *memory = malloc(size == 0 ? 1 : size);
+  if (memory == nullptr) {
+    throw bad_alloc();
+  }
+  return memory;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void *operator new(size_t size, const nothrow_t &) noexcept {
+  allocation_count.fetch_add(1, memory_order_relaxed);
+  return malloc(size == 0 ? 1 : size);
+}
+
+void *operator new[](size_t size, const nothrow_t &tag) noexcept {
+  return operator new(size, tag);
+}
+
+void operator delete(void *memory) noexcept { free(memory); }
+
+void operator delete[](void *memory) noexcept { free(memory); }
+
+void operator delete(void *memory, const nothrow_t &) noexcept {
+  free(memory);
+}
+
+void operator delete[](void *memory, const nothrow_t &) noexcept {
+  free(memory);
+}
+
+/**
+ * @brief The measured stages, every one runs on the results of the ones
+ * before it
+ */
+enum bench_stage {
+  bench_lex,      // lexical_analyzer
+  bench_parse,    // slr1
+  bench_tree,     // semantic_analyzer
+  bench_generate, // intermediate_code_generator
+  bench_dag,      // DAG_optimizer
+  bench_pipeline, // compiler_pipeline, all stages up to the optimized code
+  bench_compiler, // compiler, allocation-free, up to the output text
+  bench_stage_size
+};
+
+static const char *const bench_stage_names[bench_stage_size] = {
+    "lexical_analyzer",            "slr1",          "semantic_analyzer",
+    "intermediate_code_generator", "DAG_optimizer", "pipeline",
+    "compiler"};
+
+// what the `compiler` stage returns, everything but the assembly
+static const unsigned int bench_artifacts = artifact_tokens |
+                                            artifact_quadruples |
+                                            artifact_optimized |
+                                            artifact_listing;
+
+/**
+ * @brief Latencies counted in buckets, 16 per power of two, so a workload of
+ * any size takes the same memory and percentiles are within ~6%
+ */
+class latency_histogram {
+public:
+  latency_histogram() : _buckets(64 * 16, 0) {}
+
+  /**
+   * @brief Count a latency
+   * @param seconds The latency
+   */
+  void record(double seconds) {
+    uint64_t nanoseconds = static_cast<uint64_t>(seconds * 1e9);
+    ++_buckets[bucket(nanoseconds)];
+    ++_count;
+    _total += seconds;
+    _max = std::max(_max, seconds);
+  }
+
+  /**
+   * @brief Get a percentile
+   * @param percent The percentile
+   * @return The latency in seconds, the middle of its bucket
+   */
+  double percentile(double percent) const {
+    if (_count == 0) {
+      return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(percent / 100 * (_count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t index = 0; index < _buckets.size(); ++index) {
+      seen += _buckets[index];
+      if (seen >= rank) {
+        return std::min(middle(index) / 1e9, _max);
+      }
+    }
+    return _max;
+  }
+
+  /**
+   * @brief Get the number of latencies
+   * @return The number
+   */
+  inline uint64_t count() const { return _count; }
+
+  /**
+   * @brief Get the sum of the latencies
+   * @return The seconds
+   */
+  inline double total() const { return _total; }
+
+  /**
+   * @brief Get the largest latency
+   * @return The seconds
+   */
+  inline double max() const { return _max; }
+
+private:
+  /**
+   * @brief Get the bucket of a latency
+   * @param value The latency in nanoseconds
+   * @return The index of the bucket
+   */
+  static size_t bucket(uint64_t value) {
+    if (value < 16) {
+      return static_cast<size_t>(value);
+    }
+    int exponent = 63;
+    while ((value >> exponent) == 0) {
+      --exponent;
+    }
+    return static_cast<size_t>((exponent - 3) * 16 +
+                               ((value >> (exponent - 4)) & 15));
+  }
+
+  /**
+   * @brief Get the middle of a bucket
+   * @param index The index of the bucket
+   * @return The latency in nanoseconds
+   */
+  static double middle(size_t index) {
+    if (index < 16) {
+      return static_cast<double>(index);
+    }
+    int exponent = static_cast<int>(index / 16) + 3;
+    double low = static_cast<double>((16 + index % 16)) *
+                 static_cast<double>(uint64_t(1) << (exponent - 4));
+    return low + static_cast<double>(uint64_t(1) << (exponent - 4)) / 2;
+  }
+
+private:
+  vector<uint64_t> _buckets; // Counts of the buckets
+  uint64_t _count = 0;       // Latencies counted
+  double _total = 0;         // Sum of the latencies
+  double _max = 0;           // Largest latency
+};
+
+/**
+ * @brief The measurements of one workload
+ */
+struct bench_run {
+  uint64_t target_bytes = 0;        // Requested size
+  uint64_t bytes = 0;               // Generated size
+  uint64_t expressions = 0;         // Generated expressions
+  uint64_t mismatches = 0;          // Wrong or invalid results
+  vector<latency_histogram> stages; // Latencies of every stage
+  vector<uint64_t> allocations;     // Heap allocations of every stage
+  long peak_rss_kib = 0;            // Peak resident set so far
+};
+
+/**
+ * @brief The measurements of the parallel evaluation of a tree
+ */
+struct tree_run {
+  uint64_t leaves = 0;         // Numbers of the expression
+  size_t nodes = 0;            // Nodes of the tree
+  size_t threads = 0;          // Workers of the pool
+  size_t cutoff = 0;           // Smallest subtree forked as a task
+  double serial_seconds = 0;   // Best time of `evaluate()`
+  double parallel_seconds = 0; // Best time of `evaluate(pool, cutoff)`
+  bool equal = true;           // Both results are the value of the text
+};
+
+/**
+ * @brief Parse a size with an optional K, M or G suffix
+ * @param text The size
+ * @return The bytes
+ */
+static uint64_t parse_size(const string &text) {
+  size_t end = 0;
+  uint64_t value = stoull(text, &end);
+  string suffix = text.substr(end);
+  if (suffix == "K" || suffix == "k") {
+    value <<= 10;
+  } else if (suffix == "M" || suffix == "m") {
+    value <<= 20;
+  } else if (suffix == "G" || suffix == "g") {
+    value <<= 30;
+  } else if (!suffix.empty()) {
+    throw invalid_argument("bad size: " + text);
+  }
+  return value;
+}
+
+/**
+ * @brief Split a comma separated list
+ * @param text The list
+ * @return The items
+ */
+static vector<string> split_list(const string &text) {
+  vector<string> items;
+  size_t start = 0;
+  while (start <= text.size()) {
+    size_t comma = text.find(',', start);
+    if (comma == string::npos) {
+      comma = text.size();
+    }
+    items.push_back(text.substr(start, comma - start));
+    start = comma + 1;
+  }
+  return items;
+}
+
+/**
+ * @brief Get the peak resident set of the process
+ * @return The size in KiB, 0 where it is unknown
+ */
+static long peak_rss_kib() {
+#ifdef __unix__
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    return usage.ru_maxrss;
+  }
+#endif
+  return 0;
+}
+
+/**
+ * @brief Get the seconds passed since a time point
+ * @param start The time point
+ * @return The seconds
+ */
+static inline double seconds_since(bench_clock::time_point start) {
+  return chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+/**
+ * @brief Where a stage started
+ */
+struct stage_start {
+  bench_clock::time_point time; // The time
+  uint64_t allocations;         // The allocations so far
+};
+
+/**
+ * @brief Start measuring a stage
+ * @return The start
+ */
+static inline stage_start start_stage() {
+  return {bench_clock::now(), allocation_count.load(memory_order_relaxed)};
+}
+
+/**
+ * @brief Record the latency and the allocations of a stage
+ * @param run The measurements
+ * @param stage The stage
+ * @param start The start of the stage
+ */
+static inline void finish_stage(bench_run &run, bench_stage stage,
+                                const stage_start &start) {
+  run.stages[stage].record(seconds_since(start.time));
+  run.allocations[stage] +=
+      allocation_count.load(memory_order_relaxed) - start.allocations;
+}
+
+/**
+ * @brief Compile expressions with the allocation-free compiler, so its
+ * buffers reach their working size
+ * @param generator The generator
+ * @param allocationFree The compiler
+ * @param expressions The number of expressions
+ * @param next_index The index of the next expression, advanced past the
+ * compiled ones so the workloads measure expressions the compiler has not
+ * seen
+ */
+static void warm_up(expression_generator &generator, compiler &allocationFree,
+                    uint64_t expressions, uint64_t &next_index) {
+  string text;
+  for (uint64_t count = 0; count < expressions; ++count) {
+    generator.generate(next_index++, text);
+    allocationFree.compile(text);
+  }
+}
+
+/**
+ * @brief Run every stage on generated expressions until a workload is
+ * reached
+ * @param generator The generator
+ * @param allocationFree The compiler of the `compiler` stage, kept warm
+ * across workloads
+ * @param target_bytes The size of the workload
+ * @param front_end_only Stop after the parser, for expressions with
+ * identifiers
+ * @param next_index The index of the next expression, advanced past the
+ * measured ones
+ * @return The measurements
+ */
+static bench_run run_workload(expression_generator &generator,
+                              compiler &allocationFree, uint64_t target_bytes,
+                              bool front_end_only, uint64_t &next_index) {
+  bench_run run;
+  run.target_bytes = target_bytes;
+  run.stages.resize(bench_stage_size);
+  run.allocations.assign(bench_stage_size, 0);
+
+  lexical_analyzer lexicalAnalyzer;
+  slr1 slr1Parser;
+  semantic_analyzer semanticAnalyzer;
+  intermediate_code_generator intermediateCodeGenerator;
+  DAG_optimizer dagOptimizer;
+  compiler_pipeline compilerPipeline((compile_options()));
+  intermediateCodeGenerator.set_inline_constants(true);
+
+  string text;
+  lexical_list pairs;
+  vector<Token> tokens;
+  do {
+    int expected = generator.generate(next_index++, text);
+    ++run.expressions;
+    run.bytes += text.size();
+
+    stage_start start = start_stage();
+    lexicalAnalyzer.clear();
+    lexicalAnalyzer.read_text(text);
+    lexicalAnalyzer.parse_text();
+    pairs.swap(lexicalAnalyzer.get_list());
+    finish_stage(run, bench_lex, start);
+
+    tokens.clear();
+    for (const lexical_pair &pair : pairs) {
+      tokens.push_back(pair.second);
+    }
+
+    start = start_stage();
+    slr1Parser.clear();
+    bool valid = slr1Parser.parse(pairs);
+    finish_stage(run, bench_parse, start);
+    if (!valid) {
+      ++run.mismatches;
+      continue;
+    }
+    if (front_end_only) {
+      continue;
+    }
+
+    start = start_stage();
+    semanticAnalyzer.clear();
+    semanticAnalyzer.construct_tree(tokens);
+    int value = semanticAnalyzer.evaluate();
+    finish_stage(run, bench_tree, start);
+
+    start = start_stage();
+    intermediateCodeGenerator.clear();
+    intermediateCodeGenerator.generate_quadruples(semanticAnalyzer.get_root());
+    finish_stage(run, bench_generate, start);
+
+    start = start_stage();
+    dagOptimizer.read_origin_nodes(intermediateCodeGenerator.get_quadruples());
+    dagOptimizer.optimize_quadruples();
+    finish_stage(run, bench_dag, start);
+
+    start = start_stage();
+    compile_result result =
+        compilerPipeline.compile_text("bench", text, stage_optimize);
+    finish_stage(run, bench_pipeline, start);
+
+    start = start_stage();
+    const compiler_output &output = allocationFree.compile(text);
+    finish_stage(run, bench_compiler, start);
+
+    if (value != expected || !result.valid || result.value != expected ||
+        !output.valid || output.value != expected) {
+      ++run.mismatches;
+    }
+  } while (run.bytes < target_bytes);
+
+  run.peak_rss_kib = peak_rss_kib();
+  return run;
+}
+
+/**
+ * @brief Append the tokens of a fully parenthesized expression whose tree is
+ * balanced. They are built directly, the lexer would take far longer than
+ * the tree
+ * @param out The tokens
+ * @param leaves The numbers of the expression, at least 1
+ * @param state The state of the pseudo-random digits and operators
+ * @return The value
+ */
+static int64_t balanced_expression(vector<Token> &out, uint64_t leaves,
+                                   uint64_t &state) {
+  state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+  uint64_t random = state >> 33;
+  if (leaves == 1) {
+    int digit = static_cast<int>(random % 9) + 1;
+    out.push_back(Token(1, static_cast<char>('0' + digit)));
+    return digit;
+  }
+
+  // sums and differences only, so the value stays below 9 per leaf
+  char op = (random & 1) != 0 ? '+' : '-';
+  out.push_back("(");
+  int64_t left = balanced_expression(out, leaves / 2, state);
+  out.push_back(Token(1, op));
+  int64_t right = balanced_expression(out, leaves - leaves / 2, state);
+  out.push_back(")");
+  return op == '+' ? left + right : left - right;
+}
+
+/**
+ * @brief Evaluate one big balanced tree serially and on a pool, several
+ * times each, and keep the best times
+ * @param leaves The numbers of the expression
+ * @param seed The seed
+ * @param pool The pool
+ * @param cutoff The smallest subtree forked as a task
+ * @param rounds The evaluations of each kind
+ * @return The measurements
+ */
+static tree_run run_parallel_evaluation(uint64_t leaves, uint64_t seed,
+                                        thread_pool &pool, size_t cutoff,
+                                        int rounds) {
+  tree_run run;
+  run.leaves = leaves;
+  run.threads = pool.size();
+  run.cutoff = cutoff;
+
+  vector<Token> tokens;
+  tokens.reserve(static_cast<size_t>(leaves) * 4);
+  uint64_t state = seed;
+  int expected = static_cast<int>(balanced_expression(tokens, leaves, state));
+
+  semantic_analyzer semanticAnalyzer;
+  semanticAnalyzer.construct_tree(tokens);
+  run.nodes = semanticAnalyzer.get_root()->get_size();
+
+  run.serial_seconds = run.parallel_seconds = 1e300;
+  for (int round = 0; round < rounds; ++round) {
+    bench_clock::time_point start = bench_clock::now();
+    int serial = semanticAnalyzer.evaluate();
+    run.serial_seconds = std::min(run.serial_seconds, seconds_since(start));
+
+    start = bench_clock::now();
+    int parallel = semanticAnalyzer.evaluate(pool, cutoff);
+    run.parallel_seconds = std::min(run.parallel_seconds, seconds_since(start));
+
+    if (serial != expected || parallel != expected) {
+      run.equal = false;
+    }
+  }
+  return run;
+}
+
+/**
+ * @brief Print the measurements as a table
+ * @param out The output stream
+ * @param run The measurements
+ */
+static void print_table(ostream &out, const bench_run &run) {
+  out << "workload " << run.bytes << " bytes, " << run.expressions
+      << " expressions, " << run.mismatches << " mismatches, peak RSS "
+      << run.peak_rss_kib << " KiB\n";
+  out << left << setw(30) << "stage" << right << setw(12) << "expr/s"
+      << setw(10) << "MB/s" << setw(10) << "p50(us)" << setw(10) << "p90(us)"
+      << setw(10) << "p99(us)" << setw(10) << "max(us)" << setw(10)
+      << "allocs" << '\n';
+  for (int stage = 0; stage < bench_stage_size; ++stage) {
+    const latency_histogram &h = run.stages[stage];
+    if (h.count() == 0) {
+      continue;
+    }
+    double total = h.total() > 0 ? h.total() : 1e-9;
+    out << left << setw(30) << bench_stage_names[stage] << right << fixed
+        << setprecision(0) << setw(12) << h.count() / total << setprecision(2)
+        << setw(10) << run.bytes / total / 1e6 << setprecision(1) << setw(10)
+        << h.percentile(50) * 1e6 << setw(10) << h.percentile(90) * 1e6
+        << setw(10) << h.percentile(99) * 1e6 << setw(10) << h.max() * 1e6
+        << setw(10) << static_cast<double>(run.allocations[stage]) / h.count()
+        << '\n';
+  }
+  out << '\n';
+}
+
+/**
+ * @brief Print the measurements of the parallel evaluation
+ * @param out The output stream
+ * @param run The measurements
+ */
+static void print_tree_table(ostream &out, const tree_run &run) {
+  out << "parallel evaluation: " << run.leaves << " leaves, " << run.nodes
+      << " nodes, " << run.threads << " threads, cutoff " << run.cutoff
+      << (run.equal ? ", results equal\n" : ", results DIFFER\n");
+  out << left << setw(30) << "evaluation" << right << setw(12) << "ms"
+      << setw(10) << "speedup" << '\n';
+  out << left << setw(30) << "serial" << right << fixed << setprecision(3)
+      << setw(12) << run.serial_seconds * 1e3 << setprecision(2) << setw(10)
+      << 1.0 << '\n';
+  out << left << setw(30) << "parallel" << right << setprecision(3)
+      << setw(12) << run.parallel_seconds * 1e3 << setprecision(2)
+      << setw(10)
+      << run.serial_seconds /
+             (run.parallel_seconds > 0 ? run.parallel_seconds : 1e-9)
+      << "\n\n";
+}
+
+/**
+ * @brief Print all measurements as JSON
+ * @param out The output stream
+ * @param options The shape of the expressions
+ * @param seed The seed
+ * @param runs The measurements
+ * @param tree The measurements of the parallel evaluation, null if it was
+ * skipped
+ */
+static void print_json(ostream &out, const generator_options &options,
+                       uint64_t seed, const vector<bench_run> &runs,
+                       const tree_run *tree) {
+  out << fixed << setprecision(9);
+  out << "{\n  \"seed\": " << seed << ",\n  \"expression_size\": "
+      << options.size << ",\n  \"depth\": " << options.depth
+      << ",\n  \"mix\": {\"+\": " << options.mix[0]
+      << ", \"-\": " << options.mix[1] << ", \"*\": " << options.mix[2]
+      << ", \"/\": " << options.mix[3]
+      << "},\n  \"parentheses\": " << options.parentheses
+      << ",\n  \"identifiers\": " << options.identifiers
+      << ",\n  \"runs\": [";
+  for (size_t index = 0; index < runs.size(); ++index) {
+    const bench_run &run = runs[index];
+    out << (index == 0 ? "\n" : ",\n") << "    {\"target_bytes\": "
+        << run.target_bytes << ", \"bytes\": " << run.bytes
+        << ", \"expressions\": " << run.expressions
+        << ", \"mismatches\": " << run.mismatches
+        << ", \"peak_rss_kib\": " << run.peak_rss_kib << ", \"stages\": {";
+    const char *separator = "\n";
+    for (int stage = 0; stage < bench_stage_size; ++stage) {
+      const latency_histogram &h = run.stages[stage];
+      if (h.count() == 0) {
+        continue;
+      }
+      double total = h.total() > 0 ? h.total() : 1e-9;
+      out << separator << "      \"" << bench_stage_names[stage]
+          << "\": {\"seconds\": " << h.total()
+          << ", \"expressions_per_second\": " << h.count() / total
+          << ", \"bytes_per_second\": " << run.bytes / total
+          << ", \"p50_seconds\": " << h.percentile(50)
+          << ", \"p90_seconds\": " << h.percentile(90)
+          << ", \"p99_seconds\": " << h.percentile(99)
+          << ", \"max_seconds\": " << h.max()
+          << ", \"allocations\": " << run.allocations[stage] << "}";
+      separator = ",\n";
+    }
+    out << "\n    }}";
+  }
+  out << "\n  ]";
+  if (tree != nullptr) {
+    out << ",\n  \"parallel_evaluation\": {\"leaves\": " << tree->leaves
+        << ", \"nodes\": " << tree->nodes << ", \"threads\": " << tree->threads
+        << ", \"cutoff\": " << tree->cutoff
+        << ", \"serial_seconds\": " << tree->serial_seconds
+        << ", \"parallel_seconds\": " << tree->parallel_seconds
+        << ", \"equal\": " << (tree->equal ? "true" : "false") << "}";
+  }
+  out << "\n}\n";
+}
+
+int main(int argc, char *argv[]) {
+  // --seed <n>: the seed of the generator, 1 by default
+  // --sizes <list>: the workloads in bytes, K, M and G suffixes allowed,
+  //   10,100,1K,10K,100K by default
+  // --expression-size <n>: the bytes of every expression, 32 by default
+  // --depth <n>: the deepest nesting of parentheses, 3 by default
+  // --mix <+,-,*,/>: the weights of the operators, 4,4,2,1 by default
+  // --parentheses <p>: the chance a factor is parenthesized, 0.2 by default
+  // --identifiers <p>: the chance a factor is an identifier, 0 by default;
+  //   identifiers stop the measurements after the parser, since the
+  //   semantic analyzer evaluates numbers only
+  // --json <file>: write the measurements as JSON, `-` for the standard
+  //   output
+  // --warm-up <n>: the expressions the allocation-free compiler compiles
+  //   before the workloads, 4096 by default
+  // --check-allocations: fail if the allocation-free compiler allocates
+  //   after the warm-up
+  // --tree-leaves <n>: the numbers of the balanced expression evaluated
+  //   serially and in parallel, K, M and G suffixes allowed, 256K by
+  //   default, 0 skips it
+  // --threads <n>: the workers of the parallel evaluation, one per hardware
+  //   thread by default
+  // --cutoff <n>: the smallest subtree the parallel evaluation forks
+  generator_options options;
+  uint64_t seed = 1;
+  vector<uint64_t> sizes = {10, 100, 1 << 10, 10 << 10, 100 << 10};
+  string json_file;
+  uint64_t warm_up_expressions = 4096;
+  bool check_allocations = false;
+  uint64_t tree_leaves = 256 << 10;
+  size_t thread_count = 0;
+  size_t cutoff = semantic_analyzer::default_cutoff;
+  try {
+    for (int index = 1; index < argc; ++index) {
+      string arg = argv[index];
+      if (arg == "--check-allocations") {
+        check_allocations = true;
+        continue;
+      }
+      if (index + 1 >= argc) {
+        throw invalid_argument("unknown option: " + arg);
+      }
+      string value = argv[++index];
+      if (arg == "--seed") {
+        seed = stoull(value);
+      } else if (arg == "--sizes") {
+        sizes.clear();
+        for (const string &size : split_list(value)) {
+          sizes.push_back(parse_size(size));
+        }
+      } else if (arg == "--expression-size") {
+        options.size = static_cast<size_t>(parse_size(value));
+      } else if (arg == "--depth") {
+        options.depth = stoul(value);
+      } else if (arg == "--mix") {
+        vector<string> weights = split_list(value);
+        if (weights.size() != 4) {
+          throw invalid_argument("--mix needs four weights");
+        }
+        for (int op = 0; op < 4; ++op) {
+          options.mix[op] = static_cast<unsigned int>(stoul(weights[op]));
+        }
+      } else if (arg == "--parentheses") {
+        options.parentheses = stod(value);
+      } else if (arg == "--identifiers") {
+        options.identifiers = stod(value);
+      } else if (arg == "--json") {
+        json_file = value;
+      } else if (arg == "--warm-up") {
+        warm_up_expressions = stoull(value);
+      } else if (arg == "--tree-leaves") {
+        tree_leaves = parse_size(value);
+      } else if (arg == "--threads") {
+        thread_count = stoul(value);
+      } else if (arg == "--cutoff") {
+        cutoff = stoul(value);
+      } else {
+        throw invalid_argument("unknown option: " + arg);
+      }
+    }
+  } catch (const exception &e) {
+    cerr << e.what() << endl;
+    cerr << "usage: pl0_bench [--seed n] [--sizes list] [--expression-size n] "
+            "[--depth n] [--mix +,-,*,/] [--parentheses p] [--identifiers p] "
+            "[--json file] [--warm-up n] [--check-allocations] "
+            "[--tree-leaves n] [--threads n] [--cutoff n]"
+         << endl;
+    return 1;
+  }
+
+  expression_generator generator(options, seed);
+  vector<bench_run> runs;
+  tree_run tree;
+  try {
+    compile_options compilerOptions;
+    compilerOptions.allocation_free = true;
+    compiler allocationFree(compilerOptions, bench_artifacts);
+    bool front_end_only = options.identifiers > 0;
+    // every expression is generated once, by the warm-up or by a workload
+    uint64_t next_index = 0;
+    if (!front_end_only) {
+      warm_up(generator, allocationFree, warm_up_expressions, next_index);
+    }
+
+    for (uint64_t size : sizes) {
+      runs.push_back(run_workload(generator, allocationFree, size,
+                                  front_end_only, next_index));
+      print_table(cout, runs.back());
+    }
+
+    if (tree_leaves > 0) {
+      thread_pool pool(thread_count);
+      tree = run_parallel_evaluation(tree_leaves, seed, pool, cutoff, 5);
+      print_tree_table(cout, tree);
+    }
+  } catch (const exception &e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  const tree_run *measured_tree = tree_leaves > 0 ? &tree : nullptr;
+  if (!json_file.empty()) {
+    if (json_file == "-") {
+      print_json(cout, options, seed, runs, measured_tree);
+    } else {
+      ofstream fout(json_file);
+      if (!fout.is_open()) {
+        cerr << "file " << json_file << " open failed" << endl;
+        return 1;
+      }
+      print_json(fout, options, seed, runs, measured_tree);
+    }
+  }
+
+  if (!tree.equal) {
+    cerr << "the parallel evaluation differs from the serial one" << endl;
+    return 1;
+  }
+  uint64_t steady_allocations = 0;
+  for (const bench_run &run : runs) {
+    if (run.mismatches > 0) {
+      return 1;
+    }
+    steady_allocations += run.allocations[bench_compiler];
+  }
+  if (check_allocations && steady_allocations > 0) {
+    cerr << "the allocation-free compiler allocated " << steady_allocations
+         << " times after the warm-up" << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,461 @@
+#include "compile_cache.h"
+#include "quadruple_file.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <ios>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+#ifdef __unix__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+using std::ifstream;
+using std::ios_base;
+using std::ostringstream;
+using std::pair;
+
+const uint32_t compile_cache::version;
+
+static const char compile_cache_magic[4] = {'P', 'L', '0', 'C'};
+static const char compile_cache_extension[] = ".pl0c";
+
+static const uint64_t fnv_offset = 14695981039346656037ull;
+static const uint64_t fnv_prime = 1099511628211ull;
+
+/**
+ * @brief Continue a 64-bit FNV-1a hash over some bytes
+ * @param hash The hash so far
+ * @param data The bytes
+ * @param size The number of bytes
+ * @return The hash
+ */
+static uint64_t fnv1a(uint64_t hash, const char *data, size_t size) {
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+  for (size_t index = 0; index < size; ++index) {
+    hash ^= bytes[index];
+    hash *= fnv_prime;
+  }
+  return hash;
+}
+
+/**
+ * @brief Continue a 64-bit FNV-1a hash over a string and its length, so
+ * neighbouring strings cannot run into each other
+ * @param hash The hash so far
+ * @param str The string
+ * @return The hash
+ */
+static uint64_t fnv1a(uint64_t hash, const string &str) {
+  uint64_t size = str.size();
+  hash = fnv1a(hash, reinterpret_cast<const char *>(&size), sizeof(size));
+  return fnv1a(hash, str.data(), str.size());
+}
+
+/**
+ * @brief Read a whole file
+ * @param file_name The name of the file
+ * @param contents The contents
+ * @return true The file is read
+ * @return false The file cannot be opened
+ */
+static bool read_file(const string &file_name, string &contents) {
+  ifstream fin(file_name, ios_base::binary);
+  if (!fin.is_open()) {
+    return false;
+  }
+  contents.assign(std::istreambuf_iterator<char>(fin),
+                  std::istreambuf_iterator<char>());
+  return !fin.bad();
+}
+
+/**
+ * @brief Get the current time
+ * @return Nanoseconds since the epoch
+ */
+static uint64_t now_nanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * @brief Append a value in its in-memory representation
+ * @param out The buffer
+ * @param value The value
+ */
+template <typename T> static void put(output_buffer &out, const T &value) {
+  out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/**
+ * @brief Append a string with its length
+ * @param out The buffer
+ * @param str The string
+ */
+static void put_string(output_buffer &out, const string &str) {
+  put(out, static_cast<uint32_t>(str.size()));
+  out.append(str.data(), str.size());
+}
+
+/**
+ * @brief Append quadruples with their count
+ * @param out The buffer
+ * @param quads The quadruples
+ */
+static void put_quadruples(output_buffer &out, const vector<quadruple> &quads) {
+  put(out, static_cast<uint32_t>(quads.size()));
+  for (const quadruple &quad : quads) {
+    put(out, quadruple_file::to_record(quad));
+  }
+}
+
+/**
+ * @brief Reads the fields of a record back, every read fails instead of
+ * running past the end
+ */
+class record_reader {
+public:
+  /**
+   * @brief Construct a new reader
+   * @param data The record
+   * @param size The size of the record
+   */
+  record_reader(const char *data, size_t size) : _data(data), _size(size) {}
+
+  /**
+   * @brief Read a value in its in-memory representation
+   * @param value The value
+   * @return true The value is read
+   * @return false The record ends too early
+   */
+  template <typename T> bool get(T &value) {
+    if (_size - _position < sizeof(value)) {
+      return false;
+    }
+    std::memcpy(&value, _data + _position, sizeof(value));
+    _position += sizeof(value);
+    return true;
+  }
+
+  /**
+   * @brief Read a string with its length
+   * @param str The string
+   * @return true The string is read
+   * @return false The record ends too early
+   */
+  bool get_string(string &str) {
+    uint32_t size = 0;
+    if (!get(size) || _size - _position < size) {
+      return false;
+    }
+    str.assign(_data + _position, size);
+    _position += size;
+    return true;
+  }
+
+  /**
+   * @brief Read quadruples with their count
+   * @param quads The quadruples
+   * @return true The quadruples are read
+   * @return false The record ends too early
+   */
+  bool get_quadruples(vector<quadruple> &quads) {
+    uint32_t count = 0;
+    if (!get(count) || (_size - _position) / sizeof(quadruple_record) < count) {
+      return false;
+    }
+    quads.clear();
+    quads.reserve(count);
+    quadruple_record record;
+    for (uint32_t index = 0; index < count; ++index) {
+      get(record);
+      quads.push_back(quadruple_file::to_quadruple(record));
+    }
+    return true;
+  }
+
+  /**
+   * @brief Get the number of bytes read
+   * @return The number of bytes
+   */
+  inline size_t position() const { return _position; }
+
+private:
+  const char *_data;    // The record
+  size_t _size;         // The size of the record
+  size_t _position = 0; // The next byte to read
+};
+
+compile_cache::compile_cache(const string &directory, uint64_t max_bytes,
+                             const compile_options &options)
+    : _directory(directory), _max_bytes(max_bytes), _hits(0), _misses(0),
+      _evicted(0) {
+  // everything besides the text that changes the results
+  string table;
+  if (!read_file(options.table_file, table)) {
+    throw ios_base::failure("file " + options.table_file + " open failed");
+  }
+  vector<string> disabled = options.disabled_passes;
+  std::sort(disabled.begin(), disabled.end());
+
+  _seed = fnv1a(fnv_offset, reinterpret_cast<const char *>(&version),
+                sizeof(version));
+  _seed = fnv1a(_seed, build_id());
+  _seed = fnv1a(_seed, table);
+  _seed = fnv1a(_seed, options.inline_constants ? "inline" : "temporaries");
+  for (const string &name : disabled) {
+    _seed = fnv1a(_seed, name);
+  }
+
+#ifdef __unix__
+  ::mkdir(_directory.c_str(), 0755);
+#endif
+  scan_directory();
+}
+
+uint64_t compile_cache::key(const string &text) const {
+  return fnv1a(_seed, text);
+}
+
+string compile_cache::file_name(uint64_t key) const {
+  ostringstream name;
+  name << _directory;
+  if (!_directory.empty() && _directory.back() != '/') {
+    name << '/';
+  }
+  name << std::hex << std::setw(16) << std::setfill('0') << key
+       << compile_cache_extension;
+  return name.str();
+}
+
+bool compile_cache::load(const string &text, compile_job &job) {
+  uint64_t text_key = key(text);
+  string name = file_name(text_key);
+  string record;
+  if (!read_file(name, record) || record.size() < sizeof(uint64_t)) {
+    ++_misses;
+    return false;
+  }
+
+  // the checksum covers everything before it
+  size_t body = record.size() - sizeof(uint64_t);
+  uint64_t checksum = 0;
+  std::memcpy(&checksum, record.data() + body, sizeof(checksum));
+  record_reader in(record.data(), body);
+  char magic[4];
+  uint32_t record_version = 0;
+  uint64_t record_key = 0;
+  string record_text;
+  uint8_t valid = 0;
+  uint32_t counts[4];
+  uint64_t removed = 0;
+  uint32_t pair_count = 0;
+  bool ok = checksum == fnv1a(fnv_offset, record.data(), body) &&
+            in.get(magic) &&
+            std::memcmp(magic, compile_cache_magic, sizeof(magic)) == 0 &&
+            in.get(record_version) && record_version == version &&
+            in.get(record_key) && record_key == text_key &&
+            in.get_string(record_text) && record_text == text &&
+            in.get(valid) && in.get(job.value) && in.get(counts) &&
+            in.get(removed) && in.get(pair_count);
+  job.pairs.clear();
+  for (uint32_t index = 0; ok && index < pair_count; ++index) {
+    lexical_pair pair;
+    ok = in.get_string(pair.first) && in.get_string(pair.second);
+    job.pairs.push_back(std::move(pair));
+  }
+  ok = ok && in.get_quadruples(job.parsed) &&
+       in.get_quadruples(job.optimized) && in.position() == body;
+  if (!ok) {
+    job.pairs.clear();
+    job.parsed.clear();
+    job.optimized.clear();
+    job.value = 0;
+    ++_misses;
+    return false;
+  }
+
+  job.expression = text;
+  job.valid = valid != 0;
+  job.folded_count = counts[0];
+  job.identity_count = counts[1];
+  job.reduced_count = counts[2];
+  job.eliminated_count = counts[3];
+  job.removed_count = static_cast<size_t>(removed);
+  ++_hits;
+
+  // a hit makes the record the most recently used one, for this process and
+  // for the next one scanning the directory
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto found = _entries.find(name);
+  if (found != _entries.end()) {
+    found->second.last_used = now_nanoseconds();
+  }
+#ifdef __unix__
+  ::utimensat(AT_FDCWD, name.c_str(), nullptr, 0);
+#endif
+  return true;
+}
+
+void compile_cache::store(const string &text, const compile_job &job) {
+  uint64_t text_key = key(text);
+  string name = file_name(text_key);
+
+  output_buffer out;
+  out.append(compile_cache_magic, sizeof(compile_cache_magic));
+  put(out, version);
+  put(out, text_key);
+  put_string(out, text);
+  put(out, static_cast<uint8_t>(job.valid ? 1 : 0));
+  put(out, job.value);
+  uint32_t counts[4] = {job.folded_count, job.identity_count,
+                        job.reduced_count, job.eliminated_count};
+  put(out, counts);
+  put(out, static_cast<uint64_t>(job.removed_count));
+  put(out, static_cast<uint32_t>(job.pairs.size()));
+  for (const lexical_pair &pair : job.pairs) {
+    put_string(out, pair.first);
+    put_string(out, pair.second);
+  }
+  put_quadruples(out, job.parsed);
+  put_quadruples(out, job.optimized);
+  put(out, fnv1a(fnv_offset, out.data(), out.size()));
+
+  // readers see either the old record or the whole new one; the temporary
+  // name is unique to the process and the thread, as processes may share the
+  // directory
+  ostringstream temporary;
+  temporary << name << ".tmp";
+#ifdef __unix__
+  temporary << ::getpid() << '-';
+#endif
+  temporary << std::hash<std::thread::id>()(std::this_thread::get_id());
+  try {
+    out.write_file(temporary.str());
+  } catch (const ios_base::failure &) {
+    // the cache only saves time, a failure to fill it is not an error
+    std::remove(temporary.str().c_str());
+    return;
+  }
+  if (std::rename(temporary.str().c_str(), name.c_str()) != 0) {
+    std::remove(temporary.str().c_str());
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  entry &stored = _entries[name];
+  _total_bytes -= stored.size;
+  stored.size = out.size();
+  stored.last_used = now_nanoseconds();
+  _total_bytes += stored.size;
+  if (_total_bytes > _max_bytes) {
+    evict();
+  }
+}
+
+void compile_cache::scan_directory() {
+#ifdef __unix__
+  std::lock_guard<std::mutex> lock(_mutex);
+  DIR *dir = ::opendir(_directory.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+  const size_t extension_size = sizeof(compile_cache_extension) - 1;
+  while (dirent *item = ::readdir(dir)) {
+    string base = item->d_name;
+    if (base.size() <= extension_size ||
+        base.compare(base.size() - extension_size, extension_size,
+                     compile_cache_extension) != 0) {
+      continue;
+    }
+    string name = _directory + (_directory.back() == '/' ? "" : "/") + base;
+    struct stat status;
+    if (::stat(name.c_str(), &status) != 0) {
+      continue;
+    }
+    entry &found = _entries[name];
+    found.size = static_cast<uint64_t>(status.st_size);
+    found.last_used = static_cast<uint64_t>(status.st_mtim.tv_sec) *
+                          1000000000ull +
+                      static_cast<uint64_t>(status.st_mtim.tv_nsec);
+    _total_bytes += found.size;
+  }
+  ::closedir(dir);
+
+  if (_total_bytes > _max_bytes) {
+    evict();
+  }
+#endif
+}
+
+void compile_cache::evict() {
+  // evict down to nine tenths of the limit, so the next stores do not evict
+  // again right away
+  vector<pair<uint64_t, const string *>> by_age;
+  by_age.reserve(_entries.size());
+  for (const auto &item : _entries) {
+    by_age.emplace_back(item.second.last_used, &item.first);
+  }
+  std::sort(by_age.begin(), by_age.end());
+
+  uint64_t target = _max_bytes / 10 * 9;
+  vector<string> removed;
+  for (const auto &item : by_age) {
+    if (_total_bytes <= target) {
+      break;
+    }
+    _total_bytes -= _entries[*item.second].size;
+    removed.push_back(*item.second);
+  }
+  for (const string &name : removed) {
+    std::remove(name.c_str());
+    _entries.erase(name);
+    ++_evicted;
+  }
+}
+
+void compile_cache::print_statistics(ostream &out) const {
+  size_t hits = _hits;
+  size_t lookups = hits + _misses;
+  size_t entries = 0;
+  uint64_t total_bytes = 0;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    entries = _entries.size();
+    total_bytes = _total_bytes;
+  }
+  out << "Cache: " << hits << " hits, " << _misses << " misses, "
+      << std::fixed << std::setprecision(1)
+      << (lookups > 0 ? 100.0 * hits / lookups : 0.0) << "% hit rate, "
+      << _evicted << " evicted, " << entries << " records of "
+      << total_bytes / 1024.0 << " KiB" << std::endl;
+}
+
+string compile_cache::build_id() {
+  // the executable itself changes with every build; elsewhere the time this
+  // file was compiled is the closest thing
+  static const string id = []() -> string {
+    string executable;
+#ifdef __linux__
+    if (read_file("/proc/self/exe", executable) && !executable.empty()) {
+      ostringstream hash;
+      hash << std::hex << fnv1a(fnv_offset, executable);
+      return hash.str();
+    }
+#endif
+    return __DATE__ " " __TIME__;
+  }();
+  return id;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file compile_cache.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Content-addressed on-disk cache of compilation results
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_COMPILE_CACHE_H
+#define LIB_7CXX_COMPILE_CACHE_H
+
+#include "compiler_pipeline.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::ostream;
+using std::size_t;
+using std::string;
+using std::uint32_t;
+using std::uint64_t;
+using std::unordered_map;
+using std::vector;
+
+/**
+ * Every result is a file `<directory>/<key>.pl0c`, the key is 16 hex digits.
+ * All fields are little-endian, strings are a u32 length and the bytes:
+ *
+ * | field                                                   |
+ * |---------------------------------------------------------|
+ * | magic "PL0C", u32 version, u64 key                      |
+ * | string: the normalized input text                       |
+ * | u8 valid, i32 value                                     |
+ * | u32 folded, identities, reductions, eliminated          |
+ * | u64 removed dead quadruples                             |
+ * | u32 n, n times string token and string lexeme           |
+ * | u32 n, n parsed quadruples as `quadruple_record`        |
+ * | u32 n, n optimized quadruples as `quadruple_record`     |
+ * | u64 FNV-1a hash of all bytes before                     |
+ *
+ * The input text is stored too, so a hash collision is a miss and not a wrong
+ * result.
+ */
+
+/**
+ * @brief Results of earlier compilations, keyed by the normalized input text,
+ * the contents of the analysis table, the build of the compiler and the
+ * options changing the results.
+ *
+ * A cache is shared by all pipelines of a run, every method is thread safe.
+ * Records are written to a temporary file and renamed, so concurrent
+ * processes sharing a directory never see half a record. Once the records
+ * take more than the size limit, the least recently used ones are removed.
+ */
+class compile_cache {
+public:
+  /**
+   * @brief The record format written by this build
+   */
+  static const uint32_t version = 2;
+
+  /**
+   * @brief Open a cache directory, creating it if needed
+   * @param directory The directory
+   * @param max_bytes The size limit of all records
+   * @param options The options of the pipelines using the cache
+   * @throw std::ios_base::failure The analysis table cannot be read
+   */
+  compile_cache(const string &directory, uint64_t max_bytes,
+                const compile_options &options);
+
+  compile_cache(const compile_cache &) = delete;
+
+  /**
+   * @brief Look up the results of a text and fill them into a job
+   * @param text The normalized input text
+   * @param job The job, filled in only on a hit
+   * @return true The results are in the job
+   * @return false There is no usable record
+   */
+  bool load(const string &text, compile_job &job);
+
+  /**
+   * @brief Store the results of a finished job
+   * @param text The normalized input text
+   * @param job The job
+   */
+  void store(const string &text, const compile_job &job);
+
+  /**
+   * @brief Get the key of a text
+   * @param text The normalized input text
+   * @return The key
+   */
+  uint64_t key(const string &text) const;
+
+  /**
+   * @brief Print the hits, the misses and the size of the cache
+   * @param out The output stream
+   */
+  void print_statistics(ostream &out) const;
+
+  /**
+   * @brief Get the number of texts found in the cache
+   * @return The number of hits
+   */
+  inline size_t get_hits() const { return _hits; }
+
+  /**
+   * @brief Get the number of texts not found in the cache
+   * @return The number of misses
+   */
+  inline size_t get_misses() const { return _misses; }
+
+  /**
+   * @brief Get the number of records removed to stay within the size limit
+   * @return The number of records
+   */
+  inline size_t get_evicted() const { return _evicted; }
+
+  /**
+   * @brief Get an id of the running build of the compiler
+   * @return The id, a hash of the executable where it can be read
+   */
+  static string build_id();
+
+private:
+  /**
+   * @brief A record on disk
+   */
+  struct entry {
+    uint64_t size;      // Size of the file
+    uint64_t last_used; // Nanoseconds since the epoch
+  };
+
+  /**
+   * @brief Get the file of a key
+   * @param key The key
+   * @return The path of the file
+   */
+  string file_name(uint64_t key) const;
+
+  /**
+   * @brief Read the records already in the directory
+   */
+  void scan_directory();
+
+  /**
+   * @brief Remove the least recently used records until they fit, the mutex
+   * must be held
+   */
+  void evict();
+
+private:
+  string _directory;                        // Directory of the records
+  uint64_t _max_bytes;                      // Size limit of all records
+  uint64_t _seed;                           // Hash of everything but the text
+  mutable std::mutex _mutex;                // Guards the fields below
+  unordered_map<string, entry> _entries;    // Records by file name
+  uint64_t _total_bytes = 0;                // Size of all records
+  std::atomic<size_t> _hits;                // Results found
+  std::atomic<size_t> _misses;              // Results not found
+  std::atomic<size_t> _evicted;             // Records removed
+};
+
+#endif // LIB_7CXX_COMPILE_CACHE_H
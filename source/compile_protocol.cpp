@@ -0,0 +1,158 @@
+#include "compile_protocol.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ios>
+
+#ifdef __unix__
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using std::ios_base;
+
+const char compile_protocol::request_compile;
+const char compile_protocol::request_evaluate;
+const char compile_protocol::request_shutdown;
+const char compile_protocol::response_ok;
+const char compile_protocol::response_invalid;
+const char compile_protocol::response_error;
+const uint32_t compile_protocol::max_frame_size;
+
+#ifdef __unix__
+
+/**
+ * @brief Read exactly `size` bytes
+ * @param fd The socket
+ * @param data The buffer
+ * @param size The number of bytes
+ * @return The number of bytes read, less than `size` only at end of stream
+ */
+static size_t read_fully(int fd, char *data, size_t size) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t got = ::read(fd, data + done, size - done);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw ios_base::failure(string("socket read failed: ") +
+                              std::strerror(errno));
+    }
+    if (got == 0) {
+      break;
+    }
+    done += static_cast<size_t>(got);
+  }
+  return done;
+}
+
+void compile_protocol::send_frame(int fd, char kind, const char *data,
+                                  size_t size) {
+  if (size >= max_frame_size) {
+    throw ios_base::failure("frame too large");
+  }
+
+  uint32_t length = static_cast<uint32_t>(size + 1);
+  char header[5] = {static_cast<char>(length & 0xff),
+                    static_cast<char>((length >> 8) & 0xff),
+                    static_cast<char>((length >> 16) & 0xff),
+                    static_cast<char>((length >> 24) & 0xff), kind};
+
+  iovec parts[2];
+  parts[0].iov_base = header;
+  parts[0].iov_len = sizeof(header);
+  parts[1].iov_base = const_cast<char *>(data);
+  parts[1].iov_len = size;
+
+  // a short write continues from where it stopped; a closed peer fails the
+  // call instead of raising SIGPIPE
+  int first = 0;
+  while (first < 2) {
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = parts + first;
+    message.msg_iovlen = 2 - first;
+    ssize_t sent = ::sendmsg(fd, &message, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw ios_base::failure(string("socket write failed: ") +
+                              std::strerror(errno));
+    }
+    size_t left = static_cast<size_t>(sent);
+    while (first < 2 && left >= parts[first].iov_len) {
+      left -= parts[first].iov_len;
+      ++first;
+    }
+    if (first < 2) {
+      parts[first].iov_base = static_cast<char *>(parts[first].iov_base) + left;
+      parts[first].iov_len -= left;
+    }
+  }
+}
+
+bool compile_protocol::receive_frame(int fd, char &kind, string &payload) {
+  unsigned char header[4];
+  size_t got = read_fully(fd, reinterpret_cast<char *>(header), 4);
+  if (got == 0) {
+    return false;
+  }
+  if (got < 4) {
+    throw ios_base::failure("truncated frame");
+  }
+
+  uint32_t length = header[0] | (header[1] << 8) | (header[2] << 16) |
+                    (static_cast<uint32_t>(header[3]) << 24);
+  if (length == 0 || length > max_frame_size) {
+    throw ios_base::failure("bad frame length");
+  }
+  if (read_fully(fd, &kind, 1) < 1) {
+    throw ios_base::failure("truncated frame");
+  }
+  payload.resize(length - 1);
+  if (read_fully(fd, &payload[0], payload.size()) < payload.size()) {
+    throw ios_base::failure("truncated frame");
+  }
+  return true;
+}
+
+int compile_protocol::connect_to(const string &socket_path) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    throw ios_base::failure("socket path too long: " + socket_path);
+  }
+  std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size());
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    throw ios_base::failure("socket creation failed");
+  }
+  if (::connect(fd, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)) != 0) {
+    ::close(fd);
+    throw ios_base::failure("connect to " + socket_path + " failed");
+  }
+  return fd;
+}
+
+#else
+
+void compile_protocol::send_frame(int, char, const char *, size_t) {
+  throw ios_base::failure("Unix domain sockets are not supported");
+}
+
+bool compile_protocol::receive_frame(int, char &, string &) {
+  throw ios_base::failure("Unix domain sockets are not supported");
+}
+
+int compile_protocol::connect_to(const string &) {
+  throw ios_base::failure("Unix domain sockets are not supported");
+}
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ * @file compile_protocol.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Length-prefixed frames exchanged with the compile server
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_COMPILE_PROTOCOL_H
+#define LIB_7CXX_COMPILE_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using std::size_t;
+using std::string;
+using std::uint32_t;
+
+/**
+ * Every message is a frame, the length is little-endian:
+ *
+ * | offset | size  | field                                 |
+ * |--------|-------|---------------------------------------|
+ * | 0      | 4     | length n of the kind and the payload  |
+ * | 4      | 1     | kind                                  |
+ * | 5      | n - 1 | payload                               |
+ *
+ * Requests:
+ * - `c`: compile the expression in the payload, the response carries the
+ *   text of the output file
+ * - `e`: evaluate the expression in the payload, the response carries the
+ *   value in decimal
+ * - `q`: stop the server, the response is empty
+ *
+ * Responses are `o` (done), `i` (the expression is invalid) or `x` (failed,
+ * the payload is the message). A client may send any number of requests over
+ * one connection, each one is answered before the next one is read.
+ */
+class compile_protocol {
+public:
+  static const char request_compile = 'c';  // Compile an expression
+  static const char request_evaluate = 'e'; // Evaluate an expression
+  static const char request_shutdown = 'q'; // Stop the server
+  static const char response_ok = 'o';      // Done
+  static const char response_invalid = 'i'; // The expression is invalid
+  static const char response_error = 'x';   // Failed
+
+  /**
+   * @brief The largest accepted frame
+   */
+  static const uint32_t max_frame_size = 1u << 24;
+
+  /**
+   * @brief Send the header and the payload of a frame with a single gathered
+   * `sendmsg`, unless it is cut short
+   * @param fd The socket
+   * @param kind The kind
+   * @param data The payload
+   * @param size The size of the payload
+   * @throw std::ios_base::failure The socket is broken
+   */
+  static void send_frame(int fd, char kind, const char *data, size_t size);
+
+  /**
+   * @brief Receive a frame
+   * @param fd The socket
+   * @param kind The kind
+   * @param payload The payload, its capacity is reused
+   * @return true A frame is received
+   * @return false The peer closed the connection between two frames
+   * @throw std::ios_base::failure The socket is broken or the frame is
+   * malformed
+   */
+  static bool receive_frame(int fd, char &kind, string &payload);
+
+  /**
+   * @brief Connect to a server
+   * @param socket_path The path of the Unix domain socket
+   * @return The connected socket
+   * @throw std::ios_base::failure The server cannot be reached
+   */
+  static int connect_to(const string &socket_path);
+};
+
+#endif // LIB_7CXX_COMPILE_PROTOCOL_H
@@ -0,0 +1,210 @@
+#include "compile_server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <ios>
+#include <thread>
+
+#ifdef __unix__
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using std::ios_base;
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+compile_server::compile_server(const compile_options &options,
+                               const string &socket_path,
+                               size_t pipeline_count)
+    : _socket_path(socket_path), _stopping(false), _request_count(0) {
+  if (pipeline_count == 0) {
+    pipeline_count = std::thread::hardware_concurrency();
+  }
+  if (pipeline_count == 0) {
+    pipeline_count = 1;
+  }
+
+  // in-memory compilation writes no files, so the backends are left out
+  compile_options server_options = options;
+  server_options.emit_assembly = false;
+  server_options.emit_binary = false;
+  for (size_t index = 0; index < pipeline_count; ++index) {
+    _pipelines.emplace_back(new compiler_pipeline(server_options));
+    _free_pipelines.push_back(index);
+  }
+}
+
+compile_server::~compile_server() { stop(); }
+
+#ifdef __unix__
+
+void compile_server::run() {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (_socket_path.size() >= sizeof(address.sun_path)) {
+    throw ios_base::failure("socket path too long: " + _socket_path);
+  }
+  std::memcpy(address.sun_path, _socket_path.c_str(), _socket_path.size());
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    throw ios_base::failure("socket creation failed");
+  }
+  // a socket left behind by a previous server is replaced, anything else at
+  // the path is kept
+  struct stat path_stat;
+  if (::lstat(_socket_path.c_str(), &path_stat) == 0) {
+    if (!S_ISSOCK(path_stat.st_mode)) {
+      ::close(fd);
+      throw ios_base::failure(_socket_path +
+                              ": path exists and is not a socket");
+    }
+    ::unlink(_socket_path.c_str());
+  }
+  if (::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) !=
+          0 ||
+      ::listen(fd, SOMAXCONN) != 0) {
+    ::close(fd);
+    throw ios_base::failure("bind to " + _socket_path + " failed");
+  }
+  {
+    lock_guard<mutex> lock(_client_mutex);
+    _listen_fd = fd;
+  }
+
+  while (!_stopping) {
+    int client = ::accept(fd, nullptr, nullptr);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      // `stop` shuts the listening socket down, which fails `accept`
+      break;
+    }
+
+    lock_guard<mutex> lock(_client_mutex);
+    if (_stopping) {
+      ::close(client);
+      break;
+    }
+    _clients.insert(client);
+    std::thread(&compile_server::serve_client, this, client).detach();
+  }
+
+  // the client threads hold `this`, wait for all of them
+  {
+    unique_lock<mutex> lock(_client_mutex);
+    _client_cv.wait(lock, [this] { return _clients.empty(); });
+    _listen_fd = -1;
+  }
+  ::close(fd);
+  ::unlink(_socket_path.c_str());
+}
+
+void compile_server::stop() {
+  _stopping = true;
+
+  lock_guard<mutex> lock(_client_mutex);
+  if (_listen_fd >= 0) {
+    ::shutdown(_listen_fd, SHUT_RDWR);
+  }
+  for (int client : _clients) {
+    ::shutdown(client, SHUT_RDWR);
+  }
+}
+
+void compile_server::serve_client(int fd) {
+  string request;
+  string response;
+  char kind = 0;
+
+  try {
+    while (compile_protocol::receive_frame(fd, kind, request)) {
+      if (kind == compile_protocol::request_shutdown) {
+        compile_protocol::send_frame(fd, compile_protocol::response_ok,
+                                     nullptr, 0);
+        stop();
+        break;
+      }
+
+      char status = handle_request(kind, request, response);
+      compile_protocol::send_frame(fd, status, response.data(),
+                                   response.size());
+    }
+  } catch (const ios_base::failure &) {
+    // a broken connection only ends this client
+  }
+
+  lock_guard<mutex> lock(_client_mutex);
+  _clients.erase(fd);
+  ::close(fd);
+  _client_cv.notify_all();
+}
+
+#else
+
+void compile_server::run() {
+  throw ios_base::failure("Unix domain sockets are not supported");
+}
+
+void compile_server::stop() { _stopping = true; }
+
+void compile_server::serve_client(int) {}
+
+#endif
+
+char compile_server::handle_request(char kind, const string &payload,
+                                    string &response) {
+  response.clear();
+  if (kind != compile_protocol::request_compile &&
+      kind != compile_protocol::request_evaluate) {
+    response = string("unknown request: ") + kind;
+    return compile_protocol::response_error;
+  }
+
+  bool evaluate = kind == compile_protocol::request_evaluate;
+  size_t index = acquire_pipeline();
+  compiler_pipeline &pipeline = *_pipelines[index];
+  compile_result result = pipeline.compile_text(
+      "request", payload, evaluate ? stage_optimize : stage_output);
+  if (result.error.empty() && !evaluate) {
+    const output_buffer &output = pipeline.get_output();
+    response.assign(output.data(), output.size());
+  }
+  release_pipeline(index);
+  ++_request_count;
+
+  if (!result.error.empty()) {
+    response = result.error;
+    return compile_protocol::response_error;
+  }
+  if (!result.valid) {
+    return compile_protocol::response_invalid;
+  }
+  if (evaluate) {
+    response = std::to_string(result.value);
+  }
+  return compile_protocol::response_ok;
+}
+
+size_t compile_server::acquire_pipeline() {
+  unique_lock<mutex> lock(_pipeline_mutex);
+  _pipeline_cv.wait(lock, [this] { return !_free_pipelines.empty(); });
+  size_t index = _free_pipelines.back();
+  _free_pipelines.pop_back();
+  return index;
+}
+
+void compile_server::release_pipeline(size_t index) {
+  {
+    lock_guard<mutex> lock(_pipeline_mutex);
+    _free_pipelines.push_back(index);
+  }
+  _pipeline_cv.notify_one();
+}
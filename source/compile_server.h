@@ -0,0 +1,117 @@
+/**
+ * @file compile_server.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Long-running compile server over a Unix domain socket
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_COMPILE_SERVER_H
+#define LIB_7CXX_COMPILE_SERVER_H
+
+#include "compile_protocol.h"
+#include "compiler_pipeline.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+using std::set;
+using std::size_t;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+/**
+ * @brief Serve compile and evaluate requests of `compile_protocol`.
+ *
+ * The pipelines are constructed once, when the server starts, so a request
+ * pays neither the process startup nor reading the analysis table. Every
+ * client gets its own thread, and borrows a pipeline for the duration of one
+ * request; when all pipelines are busy, the request waits for one.
+ */
+class compile_server {
+public:
+  /**
+   * @brief Construct a new server, it does not listen yet
+   * @param options The options of the pipelines
+   * @param socket_path The path of the Unix domain socket
+   * @param pipeline_count The number of pipelines, 0 means one per hardware
+   * thread
+   * @throw std::invalid_argument A disabled pass does not exist
+   */
+  compile_server(const compile_options &options, const string &socket_path,
+                 size_t pipeline_count = 0);
+
+  compile_server(const compile_server &) = delete;
+
+  /**
+   * @brief Stop the server and remove the socket
+   */
+  ~compile_server();
+
+  /**
+   * @brief Listen and serve clients until a shutdown request or `stop`
+   * @throw std::ios_base::failure The socket cannot be bound, or the path
+   * exists and is not a socket
+   */
+  void run();
+
+  /**
+   * @brief Stop accepting clients and close the open connections, `run`
+   * returns once the client threads are finished
+   */
+  void stop();
+
+  /**
+   * @brief Get the number of requests served
+   * @return The number of requests
+   */
+  inline size_t get_request_count() const { return _request_count; }
+
+private:
+  /**
+   * @brief Serve the requests of one client
+   * @param fd The connected socket
+   */
+  void serve_client(int fd);
+
+  /**
+   * @brief Answer one request
+   * @param kind The kind of the request
+   * @param payload The payload of the request
+   * @param response The payload of the response
+   * @return The kind of the response
+   */
+  char handle_request(char kind, const string &payload, string &response);
+
+  /**
+   * @brief Borrow a free pipeline, waiting if there is none
+   * @return The index of the pipeline
+   */
+  size_t acquire_pipeline();
+
+  /**
+   * @brief Return a borrowed pipeline
+   * @param index The index of the pipeline
+   */
+  void release_pipeline(size_t index);
+
+private:
+  string _socket_path;                              // Path of the socket
+  vector<unique_ptr<compiler_pipeline>> _pipelines; // Warmed-up pipelines
+  vector<size_t> _free_pipelines;                   // Indices of free ones
+  std::mutex _pipeline_mutex;                       // Guards `_free_pipelines`
+  std::condition_variable _pipeline_cv;             // Signals a free one
+  std::mutex _client_mutex;                         // Guards the fields below
+  std::condition_variable _client_cv;               // Signals a client left
+  set<int> _clients;                                // Open connections
+  int _listen_fd = -1;                              // Listening socket
+  std::atomic<bool> _stopping;                      // Set by `stop`
+  std::atomic<size_t> _request_count;               // Requests served
+};
+
+#endif // LIB_7CXX_COMPILE_SERVER_H
@@ -0,0 +1,91 @@
+#include "compiler.h"
+
+#include <stdexcept>
+
+/**
+ * @brief Take the options of a compiler: nothing is written to files
+ * @param options The options
+ * @return The options for the pipeline
+ */
+static compile_options in_memory_options(compile_options options) {
+  options.emit_assembly = false;
+  options.emit_binary = false;
+  return options;
+}
+
+compiler::compiler(const compile_options &options, unsigned int artifacts)
+    : _artifacts(artifacts), _pipeline(in_memory_options(options)) {
+  _job.memory = options.use_arenas ? &_arena : nullptr;
+}
+
+void compiler::run(const char *text, size_t size, compile_stage last_stage) {
+  compiler_pipeline::reset_job(_job, "expression", "", "pl0_expression");
+  _job.in_memory = true;
+  _job.expression.assign(text, size);
+  for (int stage = 0; stage <= last_stage; ++stage) {
+    _pipeline.run_stage(static_cast<compile_stage>(stage), _job);
+  }
+}
+
+const compiler_output &compiler::compile(const char *text, size_t size) {
+  run(text, size,
+      (_artifacts & artifact_listing) != 0 ? stage_output : stage_optimize);
+
+  // the buffers of the output keep their capacity for the next call
+  _output.valid = _job.valid && _job.error.empty();
+  _output.value = _output.valid ? _job.value : 0;
+  _output.error.swap(_job.error);
+  _output.tokens.clear();
+  _output.quadruples.clear();
+  _output.optimized.clear();
+  _output.listing.clear();
+  _output.assembly.clear();
+
+  if ((_artifacts & artifact_tokens) != 0) {
+    // the parser appends its end marker to the pairs
+    auto end = _job.pairs.end();
+    if (!_job.pairs.empty() && _job.pairs.back().first == "acc") {
+      --end;
+    }
+    _output.tokens.assign(_job.pairs.begin(), end);
+  }
+  if ((_artifacts & artifact_listing) != 0) {
+    const output_buffer &listing = _pipeline.get_output();
+    _output.listing.assign(listing.data(), listing.size());
+  }
+  // the rest of the job is on the heap
+  compiler_pipeline::release_job(_job);
+  _arena.reset();
+  if (!_output.valid) {
+    return _output;
+  }
+
+  if ((_artifacts & artifact_assembly) != 0) {
+    _assembly_generator.read_origin_nodes(_job.optimized);
+    _assembly_generator.allocate_registers();
+    _assembly_generator.generate_assembly(_job.function_name);
+    _output.assembly = _assembly_generator.get_assembly();
+  }
+  // the job and the output trade buffers instead of copying
+  if ((_artifacts & artifact_quadruples) != 0) {
+    _output.quadruples.swap(_job.parsed);
+  }
+  if ((_artifacts & artifact_optimized) != 0) {
+    _output.optimized.swap(_job.optimized);
+  }
+  return _output;
+}
+
+int compiler::evaluate(const char *text, size_t size) {
+  // the value comes from the semantic tree, no code is generated
+  run(text, size, stage_tree);
+  compiler_pipeline::release_job(_job);
+  _arena.reset();
+  if (!_job.error.empty()) {
+    throw std::invalid_argument(_job.error);
+  }
+  if (!_job.valid) {
+    throw std::invalid_argument("invalid expression");
+  }
+  return _job.value;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file compiler.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief The in-process API of libpl0: compile or evaluate an expression
+ * with one call
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_COMPILER_H
+#define LIB_7CXX_COMPILER_H
+
+#include "assembly_generator.h"
+#include "compiler_pipeline.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using std::size_t;
+using std::string;
+using std::vector;
+
+/**
+ * @brief The artifacts `compiler::compile` returns besides the validity and
+ * the value, combined with `|`
+ */
+enum compiler_artifact {
+  artifact_tokens = 1 << 0,     // {Token, Lexeme} pairs
+  artifact_quadruples = 1 << 1, // Parsed quadruples
+  artifact_optimized = 1 << 2,  // Optimized quadruples
+  artifact_listing = 1 << 3,    // The text of the output file
+  artifact_assembly = 1 << 4    // x86-64 assembly of the optimized quadruples
+};
+
+/**
+ * @brief What `compiler::compile` returns, only the requested artifacts are
+ * filled in
+ */
+struct compiler_output {
+  bool valid = false;            // The expression is valid
+  int value = 0;                 // The value of the expression
+  string error;                  // Why it failed, empty on success
+  vector<lexical_pair> tokens;   // {Token, Lexeme} pairs
+  vector<quadruple> quadruples;  // Parsed quadruples
+  vector<quadruple> optimized;   // Optimized quadruples
+  string listing;                // The text of the output file
+  string assembly;               // x86-64 assembly
+};
+
+/**
+ * @brief A reusable compiler for embedding.
+ *
+ * The stages, the analysis table and all buffers are set up once, when the
+ * compiler is constructed, and are reused by every call, so a call costs only
+ * the compilation itself. A compiler compiles one expression at a time; use
+ * one compiler per thread.
+ *
+ * With `compile_options::allocation_free`, `compile` does not touch the heap
+ * once the buffers have grown to the largest expression seen, except for the
+ * assembly artifact. With `compile_options::use_arenas`, the tokens and the
+ * tree of a call are taken from an arena of the compiler, which is reset when
+ * the call returns.
+ */
+class compiler {
+public:
+  /**
+   * @brief Construct a new compiler
+   * @param options The options, files are never written
+   * @param artifacts The artifacts to return, a combination of
+   * `compiler_artifact`
+   * @throw std::invalid_argument A disabled pass does not exist
+   * @throw std::ios_base::failure The analysis table cannot be read
+   */
+  explicit compiler(const compile_options &options = compile_options(),
+                    unsigned int artifacts = artifact_quadruples |
+                                             artifact_optimized);
+
+  compiler(const compiler &) = delete;
+
+  /**
+   * @brief Compile an expression
+   * @param text The expression
+   * @param size The size of the expression
+   * @return The result, valid until the next call; failures are reported in
+   * `error` instead of thrown
+   */
+  const compiler_output &compile(const char *text, size_t size);
+
+  /**
+   * @brief Compile an expression
+   * @param text The expression
+   * @return The result, valid until the next call
+   */
+  inline const compiler_output &compile(const string &text) {
+    return compile(text.data(), text.size());
+  }
+
+  /**
+   * @brief Evaluate an expression, without generating code
+   * @param text The expression
+   * @param size The size of the expression
+   * @return The value
+   * @throw std::invalid_argument The expression is invalid or cannot be
+   * evaluated
+   */
+  int evaluate(const char *text, size_t size);
+
+  /**
+   * @brief Evaluate an expression, without generating code
+   * @param text The expression
+   * @return The value
+   * @throw std::invalid_argument The expression is invalid or cannot be
+   * evaluated
+   */
+  inline int evaluate(const string &text) {
+    return evaluate(text.data(), text.size());
+  }
+
+  /**
+   * @brief Choose the artifacts returned by `compile`
+   * @param artifacts A combination of `compiler_artifact`
+   */
+  inline void set_artifacts(unsigned int artifacts) {
+    _artifacts = artifacts;
+  }
+
+  /**
+   * @brief Get the artifacts returned by `compile`
+   * @return A combination of `compiler_artifact`
+   */
+  inline unsigned int get_artifacts() const { return _artifacts; }
+
+private:
+  /**
+   * @brief Run the stages up to the last one on the text
+   * @param text The expression
+   * @param size The size of the expression
+   * @param last_stage The last stage
+   */
+  void run(const char *text, size_t size, compile_stage last_stage);
+
+private:
+  unsigned int _artifacts;                // Artifacts to return
+  compiler_pipeline _pipeline;            // All stages
+  assembly_generator _assembly_generator; // In-memory assembly
+  compile_job _job;                       // The expression being compiled
+  arena _arena;                           // Transient data of `_job`
+  compiler_output _output;                // Result of the last call
+};
+
+#endif // LIB_7CXX_COMPILER_H
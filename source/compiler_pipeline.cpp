@@ -0,0 +1,452 @@
+#include "compiler_pipeline.h"
+#include "compile_cache.h"
+#include "quadruple_file.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __unix__
+#include <glob.h>
+#endif
+
+using std::endl;
+using std::ifstream;
+using std::ios_base;
+using std::logic_error;
+using std::ofstream;
+using std::ostringstream;
+using std::to_string;
+
+compiler_pipeline::compiler_pipeline(const compile_options &options)
+    : _options(options), _slr1(options.table_file) {
+  // optimization passes, in running order
+  _pass_manager.add_pass("algebraic-simplifier",
+                         [this](vector<quadruple> &quads) {
+                           _algebraic_simplifier.read_origin_nodes(quads);
+                           _algebraic_simplifier.simplify_quadruples();
+                           quads = _algebraic_simplifier.get_simplified();
+                         });
+  _pass_manager.add_pass("DAG-optimizer", [this](vector<quadruple> &quads) {
+    _dag_optimizer.read_origin_nodes(quads);
+    _dag_optimizer.optimize_quadruples();
+    quads = _dag_optimizer.get_optimized();
+  });
+  _pass_manager.add_pass("dead-code-eliminator",
+                         [this](vector<quadruple> &quads) {
+                           _dead_code_eliminator.read_origin_nodes(quads);
+                           _dead_code_eliminator.eliminate_dead_code();
+                           quads = _dead_code_eliminator.get_compacted();
+                         });
+
+  for (const string &name : options.disabled_passes) {
+    if (!_pass_manager.set_enabled(name, false)) {
+      throw std::invalid_argument("unknown pass: " + name);
+    }
+  }
+  _pass_manager.set_verify(options.verify);
+  _intermediate_code_generator.set_inline_constants(options.inline_constants);
+  _lexical_analyzer.set_scanner(options.allocation_free);
+  _semantic_analyzer.set_node_pool(options.allocation_free);
+  _job.memory = options.use_arenas ? &_arena : nullptr;
+}
+
+compile_result compiler_pipeline::compile(const string &input_name,
+                                          const string &output_stem,
+                                          const string &function_name) {
+  reset_job(_job, input_name, output_stem, function_name);
+  for (int stage = 0; stage < compile_stage_size; ++stage) {
+    run_stage(static_cast<compile_stage>(stage), _job);
+  }
+  compile_result result = take_result(_job);
+  _arena.reset();
+  return result;
+}
+
+compile_result compiler_pipeline::compile_loaded(const string &input_name,
+                                                 const string &text,
+                                                 const string &output_stem,
+                                                 const string &function_name) {
+  reset_job(_job, input_name, output_stem, function_name);
+  _job.preloaded = true;
+  _job.expression = text;
+  for (int stage = 0; stage < compile_stage_size; ++stage) {
+    run_stage(static_cast<compile_stage>(stage), _job);
+  }
+  compile_result result = take_result(_job);
+  _arena.reset();
+  return result;
+}
+
+compile_result compiler_pipeline::compile_text(const string &name,
+                                               const string &text,
+                                               compile_stage last_stage) {
+  reset_job(_job, name, "", "");
+  _job.in_memory = true;
+  _job.expression = text;
+  _output.clear();
+  for (int stage = 0; stage <= last_stage; ++stage) {
+    run_stage(static_cast<compile_stage>(stage), _job);
+  }
+  compile_result result = take_result(_job);
+  _arena.reset();
+  return result;
+}
+
+void compiler_pipeline::run_stage(compile_stage stage, compile_job &job) {
+  if (!job.error.empty()) {
+    return;
+  }
+
+  static_assert(compile_stage_size <= metrics::max_timers,
+                "every stage needs a timer");
+#ifdef PL0_METRICS
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+#endif
+
+  try {
+    switch (stage) {
+    case stage_lex:
+      lex(job);
+      break;
+    case stage_validate:
+      validate(job);
+      break;
+    case stage_tree:
+      build_tree(job);
+      break;
+    case stage_generate:
+      generate(job);
+      break;
+    case stage_optimize:
+      optimize(job);
+      break;
+    case stage_output:
+      write_output(job);
+      break;
+    default:
+      throw logic_error("unexpected stage");
+    }
+  } catch (const std::exception &e) {
+    job.valid = false;
+    job.error = job.input_name + ": " + e.what();
+    if (job.memory != nullptr) {
+      // a failed stage may still hold nodes of the arena
+      _lexical_analyzer.clear();
+      _semantic_analyzer.clear();
+    }
+  }
+
+#ifdef PL0_METRICS
+  _metrics.add_time(stage, stage_name(stage),
+                    std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count());
+#endif
+}
+
+void compiler_pipeline::reset_job(compile_job &job, const string &input_name,
+                                  const string &output_stem,
+                                  const string &function_name) {
+  job.input_name = input_name;
+  job.output_stem = output_stem;
+  job.function_name = function_name;
+  job.in_memory = false;
+  job.preloaded = false;
+  job.expression.clear();
+  job.cached = false;
+  // the pairs are replaced by `lex`, their nodes go back to the lexer
+  job.tokens.clear();
+  job.valid = false;
+  job.root.reset();
+  job.value = 0;
+  job.parsed.clear();
+  job.optimized.clear();
+  job.folded_count = 0;
+  job.identity_count = 0;
+  job.reduced_count = 0;
+  job.eliminated_count = 0;
+  job.removed_count = 0;
+  job.statistics.clear();
+  job.error.clear();
+}
+
+void compiler_pipeline::release_job(compile_job &job) {
+  if (job.memory == nullptr) {
+    return;
+  }
+  job.pairs = lexical_list();
+  job.root.reset();
+}
+
+compile_result compiler_pipeline::take_result(compile_job &job) {
+  compile_result result;
+  result.valid = job.valid && job.error.empty();
+  result.value = job.value;
+  result.quadruples = job.parsed;
+  result.statistics.swap(job.statistics);
+  result.error.swap(job.error);
+  // the tree is not needed any more
+  job.root.reset();
+  release_job(job);
+  return result;
+}
+
+const char *compiler_pipeline::stage_name(compile_stage stage) {
+  static const char *const names[compile_stage_size] = {
+      "lex", "validate", "tree", "generate", "optimize", "output"};
+  return stage < compile_stage_size ? names[stage] : "unknown";
+}
+
+void compiler_pipeline::lex(compile_job &job) {
+  // read text and parse it into {Token, Lexeme} pairs
+  _lexical_analyzer.set_arena(job.memory);
+  _lexical_analyzer.clear();
+  if (!job.in_memory && !job.preloaded) {
+    ifstream fin(job.input_name);
+    if (!fin.is_open()) {
+      throw ios_base::failure("file " + job.input_name + " open failed");
+    }
+    job.expression.assign(std::istreambuf_iterator<char>(fin),
+                          std::istreambuf_iterator<char>());
+  }
+  PL0_METRIC(_metrics.add(metric_files, 1));
+  PL0_METRIC(_metrics.add(metric_bytes_read, job.expression.size()));
+  _lexical_analyzer.read_text(job.expression);
+  job.expression = _lexical_analyzer.get_expression();
+
+  // the text as the lexer sees it is the key of the cache
+  compile_cache *results = cache();
+  if (results != nullptr && results->load(job.expression, job)) {
+    job.cached = true;
+    return;
+  }
+
+  _lexical_analyzer.parse_text();
+  job.pairs.swap(_lexical_analyzer.get_list());
+  PL0_METRIC(_metrics.add(metric_tokens, job.pairs.size()));
+  PL0_METRIC(_metrics.add(metric_regex_passes,
+                          _lexical_analyzer.get_regex_pass_count()));
+}
+
+void compiler_pipeline::validate(compile_job &job) {
+  if (job.cached) {
+    return;
+  }
+
+  _slr1.clear();
+  job.valid = _slr1.parse(job.pairs);
+  PL0_METRIC(_metrics.add(metric_shifts, _slr1.get_shift_count()));
+  PL0_METRIC(_metrics.add(metric_reductions, _slr1.get_reduction_count()));
+}
+
+void compiler_pipeline::build_tree(compile_job &job) {
+  if (!job.valid || job.cached) {
+    return;
+  }
+
+  // transform {Token, Lexem} into {Lexem}
+  job.tokens.clear();
+  transform(job.pairs.begin(), job.pairs.end(), back_inserter(job.tokens),
+            [](const lexical_pair &pair) -> Token { return pair.second; });
+
+  // construct semantic tree
+  _semantic_analyzer.set_arena(job.memory);
+  _semantic_analyzer.clear();
+  _semantic_analyzer.construct_tree(job.tokens);
+  job.root = _semantic_analyzer.get_root();
+  PL0_METRIC(_metrics.add(metric_ast_nodes, job.root->get_size()));
+  job.value = _semantic_analyzer.evaluate();
+  _semantic_analyzer.clear();
+}
+
+void compiler_pipeline::generate(compile_job &job) {
+  if (!job.valid || job.cached) {
+    return;
+  }
+
+  // transform semantic tree into quadruple
+  _intermediate_code_generator.clear();
+  _intermediate_code_generator.generate_quadruples(job.root);
+  job.parsed = _intermediate_code_generator.get_quadruples();
+  PL0_METRIC(_metrics.add(metric_quadruples_parsed, job.parsed.size()));
+  job.root.reset();
+}
+
+void compiler_pipeline::optimize(compile_job &job) {
+  if (job.cached) {
+    return;
+  }
+  compile_cache *results = cache();
+  if (!job.valid) {
+    if (results != nullptr) {
+      results->store(job.expression, job);
+    }
+    return;
+  }
+
+  // optimize quadruples with the enabled passes
+  _algebraic_simplifier.clear();
+  _dag_optimizer.clear();
+  _dead_code_eliminator.clear();
+  job.optimized = job.parsed;
+  _pass_manager.run(job.optimized);
+  PL0_METRIC(_metrics.add(metric_quadruples_optimized, job.optimized.size()));
+  if (_options.pass_statistics) {
+    ostringstream statistics;
+    statistics << job.input_name << ":" << endl;
+    _pass_manager.print_statistics(statistics);
+    job.statistics = statistics.str();
+  }
+  job.folded_count = _algebraic_simplifier.get_folded_count();
+  job.identity_count = _algebraic_simplifier.get_identity_count();
+  job.reduced_count = _algebraic_simplifier.get_reduced_count();
+  job.eliminated_count = _dag_optimizer.get_eliminated_count();
+  job.removed_count = _dead_code_eliminator.get_removed_count();
+
+  // execute the optimized quadruples, they must agree with the AST
+  int executed = _quadruple_interpreter.execute(job.optimized);
+  if (executed != job.value) {
+    throw logic_error("optimized quadruples of " + job.input_name +
+                      " evaluate to " + to_string(executed) + " instead of " +
+                      to_string(job.value));
+  }
+
+  if (results != nullptr) {
+    results->store(job.expression, job);
+  }
+}
+
+void compiler_pipeline::write_output(compile_job &job) {
+  static const string delimiter_line(80, '-');
+  const string output_name =
+      job.in_memory ? string() : job.output_stem + ".txt";
+  // a preloaded job leaves `<stem>.txt` to the caller, which writes it
+  const bool write_text = !job.in_memory && !job.preloaded;
+
+  _output.clear();
+  if (!job.valid) {
+    _output << job.input_name << " is not valid\n";
+    if (write_text) {
+      _output.write_file(output_name);
+    }
+    if (!job.in_memory) {
+      PL0_METRIC(_metrics.add(metric_bytes_written, _output.size()));
+    }
+    return;
+  }
+
+  // dump quadruples in the binary format, they can be mapped back with
+  // `quadruple_file`
+  if (_options.emit_binary && !job.in_memory) {
+    quadruple_file::write(job.output_stem + ".qir", job.parsed);
+    quadruple_file::write(job.output_stem + ".opt.qir", job.optimized);
+    PL0_METRIC(_metrics.add(metric_bytes_written,
+                            2 * sizeof(quadruple_file_header) +
+                                (job.parsed.size() + job.optimized.size()) *
+                                    sizeof(quadruple_record)));
+  }
+
+  // compile optimized quadruples into a function `int <function_name>()`
+  if (_options.emit_assembly && !job.in_memory) {
+    ofstream fasm(job.output_stem + ".s");
+    if (!fasm.is_open()) {
+      throw ios_base::failure("assembly file for " + output_name +
+                              " open failed");
+    }
+    _assembly_generator.read_origin_nodes(job.optimized);
+    _assembly_generator.allocate_registers();
+    _assembly_generator.generate_assembly(job.function_name);
+    fasm << _assembly_generator.get_assembly();
+    PL0_METRIC(_metrics.add(metric_bytes_written,
+                            _assembly_generator.get_assembly().size()));
+  }
+
+  _output << "Read expression: " << job.expression << '\n';
+  _output << delimiter_line << '\n';
+  _output << "Tokens: \n";
+  for (const auto &token : job.pairs) {
+    _output << "( " << token.first << ", " << token.second << " )\n";
+  }
+  _output << delimiter_line << '\n';
+  _output << "Parsed quadruples: \n";
+  print_quadruples(_output, job.parsed);
+  _output << delimiter_line << '\n';
+  _output << "Optimized quadruples: \n";
+  print_quadruples(_output, job.optimized);
+  _output << "Folded operations: " << job.folded_count
+          << ", identities: " << job.identity_count
+          << ", strength reductions: " << job.reduced_count << '\n';
+  _output << "Eliminated common subexpressions: " << job.eliminated_count
+          << '\n';
+  _output << "Removed dead quadruples: " << job.removed_count << '\n';
+  _output << delimiter_line << '\n';
+  _output << "Expression result: " << job.value << '\n';
+
+  // the whole file is written at once
+  if (write_text) {
+    _output.write_file(output_name);
+  }
+  if (!job.in_memory) {
+    PL0_METRIC(_metrics.add(metric_bytes_written, _output.size()));
+  }
+}
+
+compile_cache *compiler_pipeline::cache() const {
+  // pass statistics are only there when the passes run
+  return _options.pass_statistics ? nullptr : _options.cache;
+}
+
+void compiler_pipeline::print_quadruples(output_buffer &out,
+                                         const vector<quadruple> &quads) {
+  for (const auto &quad : quads) {
+    out << quad;
+  }
+}
+
+vector<string> compiler_pipeline::expand_paths(const vector<string> &patterns) {
+  vector<string> paths;
+
+  for (const string &pattern : patterns) {
+#ifdef __unix__
+    glob_t matches;
+    if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+      paths.insert(paths.end(), matches.gl_pathv,
+                   matches.gl_pathv + matches.gl_pathc);
+      globfree(&matches);
+      continue;
+    }
+    globfree(&matches);
+#endif
+    paths.push_back(pattern);
+  }
+
+  return paths;
+}
+
+string compiler_pipeline::output_stem(const string &output_directory,
+                                      const string &input_name) {
+  string stem = input_name.substr(input_name.find_last_of("/\\") + 1);
+  size_t extension = stem.find_last_of('.');
+  if (extension != string::npos && extension != 0) {
+    stem.erase(extension);
+  }
+  // only the numbered inputs of the test files are renamed
+  if (stem.size() > 5 && stem.compare(0, 5, "input") == 0 &&
+      stem.find_first_not_of("0123456789", 5) == string::npos) {
+    stem.replace(0, 5, "output");
+  }
+
+  if (output_directory.empty()) {
+    return stem;
+  }
+  char last = output_directory.back();
+  return output_directory + (last == '/' || last == '\\' ? "" : "/") + stem;
+}
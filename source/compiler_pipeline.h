@@ -0,0 +1,334 @@
+/**
+ * @file compiler_pipeline.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief All stages of the compiler bundled for compiling one file at a time
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_COMPILER_PIPELINE_H
+#define LIB_7CXX_COMPILER_PIPELINE_H
+
+#include "DAG_optimizer.h"
+#include "algebraic_simplifier.h"
+#include "arena.h"
+#include "assembly_generator.h"
+#include "dead_code_eliminator.h"
+#include "intermediate_code_generator.h"
+#include "lexical_analyzer.h"
+#include "metrics.h"
+#include "output_buffer.h"
+#include "pass_manager.h"
+#include "quadruple_interpreter.h"
+#include "semantic_analyzer.h"
+#include "slr1.h"
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+using quadruple = intermediate_code_generator::quadruple;
+
+using std::list;
+using std::shared_ptr;
+using std::size_t;
+using std::string;
+using std::vector;
+
+class compile_cache;
+
+/**
+ * @brief Options shared by all pipelines of a run
+ */
+struct compile_options {
+  vector<string> disabled_passes; // Passes to skip
+  bool verify = true;             // Verify quadruples between passes
+  bool pass_statistics = false;   // Collect the statistics of every pass
+  bool emit_assembly = false;     // Write `<stem>.s`
+  bool emit_binary = false;       // Write `<stem>.qir` and `<stem>.opt.qir`
+  bool inline_constants = true;   // Numbers are operands of quadruples
+  compile_cache *cache = nullptr; // Results of earlier runs, may be null
+  string table_file =             // The SLR(1) analysis table
+      analysis_table_row_reader::default_file_name();
+  bool allocation_free = false;   // Scan expressions and build trees on
+                                  // kept memory, see `compiler_pipeline`
+  bool use_arenas = false;        // Take the transient data of every file
+                                  // from an arena, see `compile_job`
+};
+
+/**
+ * @brief The result of compiling one file
+ */
+struct compile_result {
+  bool valid = false;           // The expression is valid
+  int value = 0;                // The value of the expression
+  vector<quadruple> quadruples; // Parsed quadruples
+  string statistics;            // Pass statistics, if collected
+  string error;                 // Why the file failed, empty on success
+};
+
+/**
+ * @brief The stages a file goes through, in order
+ */
+enum compile_stage {
+  stage_lex,          // read the file and parse it into tokens
+  stage_validate,     // judge the tokens with the SLR(1) parser
+  stage_tree,         // construct and evaluate the semantic tree
+  stage_generate,     // generate quadruples
+  stage_optimize,     // run the passes and check the optimized quadruples
+  stage_output,       // write the output files
+  compile_stage_size  // the size of this enum
+};
+
+/**
+ * @brief A file on its way through the stages, every stage fills in its part.
+ * A job is reused for the next file, its buffers keep their capacity.
+ *
+ * If the job has an arena, the token pairs and the semantic tree are taken
+ * from it. Once `release_job` has dropped them, the arena can be reset, which
+ * tears the transient data of the file down at once.
+ */
+struct compile_job {
+  size_t index = 0;                  // The index of the file in a run
+  string input_name;                 // The name of the input file
+  bool in_memory = false;            // The text is in `expression`, and the
+                                     // output is kept in memory
+  bool preloaded = false;            // The text is in `expression`, and
+                                     // `<stem>.txt` is left to the caller
+  string output_stem;                // The output files without extension
+  string function_name;              // The function in the assembly
+  string expression;                 // The expression read
+  bool cached = false;               // The results came from the cache
+  lexical_list pairs;                // {Token, Lexeme} pairs
+  vector<Token> tokens;              // Tokens
+  bool valid = false;                // The expression is valid
+  shared_ptr<ASTNode> root;          // The semantic tree
+  int value = 0;                     // The value of the expression
+  vector<quadruple> parsed;          // Parsed quadruples
+  vector<quadruple> optimized;       // Optimized quadruples
+  unsigned int folded_count = 0;     // Folded operations
+  unsigned int identity_count = 0;   // Rewritten identities
+  unsigned int reduced_count = 0;    // Strength reductions
+  unsigned int eliminated_count = 0; // Eliminated common subexpressions
+  size_t removed_count = 0;          // Removed dead quadruples
+  string statistics;                 // Pass statistics, if collected
+  string error;                      // Why the file failed, empty on success
+  arena *memory = nullptr;           // Arena of the transient data, kept by
+                                     // `reset_job`, may be null
+};
+
+/**
+ * @brief One instance of every stage, from the lexical analyzer to the
+ * backends. A pipeline compiles one file at a time and keeps its stages, and
+ * their buffers, between files; pipelines share nothing, so every thread
+ * compiles with its own one.
+ *
+ * With `allocation_free`, expressions are scanned without regex searches and
+ * their trees are built in a node pool, so every stage works on memory kept
+ * from earlier files: once a job has gone through an expression, compiling
+ * another one no bigger, up to the optimized quadruples and the output text,
+ * does not allocate. Texts the scanner leaves to the regex patterns, the
+ * cache and the files written still allocate.
+ */
+class compiler_pipeline {
+public:
+  /**
+   * @brief Construct a new pipeline
+   * @param options The options
+   * @throw std::invalid_argument A disabled pass does not exist
+   * @throw std::ios_base::failure The analysis table cannot be read
+   */
+  explicit compiler_pipeline(const compile_options &options);
+
+  compiler_pipeline(const compiler_pipeline &) = delete;
+
+  /**
+   * @brief Compile a file and write `<stem>.txt`, plus the assembly and binary
+   * files if they are enabled
+   * @param input_name The name of the input file
+   * @param output_stem The name of the output files without extension
+   * @param function_name The name of the function in the assembly
+   * @return The result, failures are reported in `error` instead of thrown
+   */
+  compile_result compile(const string &input_name, const string &output_stem,
+                         const string &function_name);
+
+  /**
+   * @brief Compile a text without touching the file system, the output text
+   * is left in `get_output()`
+   * @param name The name of the text, used in messages
+   * @param text The text
+   * @param last_stage The last stage to run, `stage_optimize` skips formatting
+   * the output
+   * @return The result, failures are reported in `error` instead of thrown
+   */
+  compile_result compile_text(const string &name, const string &text,
+                              compile_stage last_stage = stage_output);
+
+  /**
+   * @brief Compile a file whose text has been read already. The text of
+   * `<stem>.txt` is left in `get_output()` for the caller to write, the
+   * assembly and binary files are written if they are enabled.
+   * @param input_name The name of the input file
+   * @param text The text of the file
+   * @param output_stem The name of the output files without extension
+   * @param function_name The name of the function in the assembly
+   * @return The result, failures are reported in `error` instead of thrown
+   */
+  compile_result compile_loaded(const string &input_name, const string &text,
+                                const string &output_stem,
+                                const string &function_name);
+
+  /**
+   * @brief Get the output text of the last compiled text
+   * @return The output buffer
+   */
+  inline const output_buffer &get_output() const { return _output; }
+
+  /**
+   * @brief Run one stage on a job. A failure is recorded in `error` of the
+   * job, and later stages skip a failed job.
+   * @param stage The stage
+   * @param job The job
+   */
+  void run_stage(compile_stage stage, compile_job &job);
+
+  /**
+   * @brief Prepare a job for a new file
+   * @param job The job
+   * @param input_name The name of the input file
+   * @param output_stem The name of the output files without extension
+   * @param function_name The name of the function in the assembly
+   */
+  static void reset_job(compile_job &job, const string &input_name,
+                        const string &output_stem, const string &function_name);
+
+  /**
+   * @brief Drop what a job holds in its arena, after which the arena can be
+   * reset; a job without an arena is left alone
+   * @param job The job
+   */
+  static void release_job(compile_job &job);
+
+  /**
+   * @brief Take the result out of a finished job, and release it
+   * @param job The job
+   * @return The result
+   */
+  static compile_result take_result(compile_job &job);
+
+  /**
+   * @brief Get the name of a stage
+   * @param stage The stage
+   * @return The name
+   */
+  static const char *stage_name(compile_stage stage);
+
+  /**
+   * @brief Get the counters and timers of all files compiled so far, they are
+   * all zero in builds without metrics
+   * @return The metrics
+   */
+  inline const metrics &get_metrics() const { return _metrics; }
+
+  /**
+   * @brief Get the names of the passes
+   * @return The names in running order
+   */
+  inline vector<string> get_pass_names() const {
+    return _pass_manager.get_pass_names();
+  }
+
+  /**
+   * @brief Print quadruples, one `( op, a, b, T )` per line
+   * @param out The output buffer
+   * @param quads The quadruples
+   */
+  static void print_quadruples(output_buffer &out,
+                               const vector<quadruple> &quads);
+
+  /**
+   * @brief Expand paths and glob patterns, in the given order. Matches of a
+   * pattern are sorted, a pattern without matches is kept as a path.
+   * @param patterns The paths and patterns
+   * @return The paths
+   */
+  static vector<string> expand_paths(const vector<string> &patterns);
+
+  /**
+   * @brief Get the output stem of an input file: its name without directory
+   * and extension. `input<n>`, with n made of digits only, becomes
+   * `output<n>`, other names are kept
+   * @param output_directory The output directory
+   * @param input_name The name of the input file
+   * @return The stem
+   */
+  static string output_stem(const string &output_directory,
+                            const string &input_name);
+
+private:
+  /**
+   * @brief Read the input file and parse it into tokens, or take all results
+   * up to the optimized quadruples from the cache
+   * @param job The job
+   */
+  void lex(compile_job &job);
+
+  /**
+   * @brief Judge if the expression is valid
+   * @param job The job
+   */
+  void validate(compile_job &job);
+
+  /**
+   * @brief Construct the semantic tree and evaluate it
+   * @param job The job
+   */
+  void build_tree(compile_job &job);
+
+  /**
+   * @brief Transform the semantic tree into quadruples
+   * @param job The job
+   */
+  void generate(compile_job &job);
+
+  /**
+   * @brief Optimize the quadruples with the enabled passes, and execute them
+   * to check them against the semantic tree; the results are then stored in
+   * the cache
+   * @param job The job
+   */
+  void optimize(compile_job &job);
+
+  /**
+   * @brief Write the output file, and the assembly and binary files if they
+   * are enabled
+   * @param job The job
+   */
+  void write_output(compile_job &job);
+
+  /**
+   * @brief Get the cache, unless it is disabled or cannot be used
+   * @return The cache, or null
+   */
+  compile_cache *cache() const;
+
+private:
+  compile_options _options;                                 // Options
+  lexical_analyzer _lexical_analyzer;                       // Lexical analyzer
+  slr1 _slr1;                                               // SLR1 parser
+  semantic_analyzer _semantic_analyzer;                     // Semantic analyzer
+  intermediate_code_generator _intermediate_code_generator; // Code generator
+  algebraic_simplifier _algebraic_simplifier;               // Simplifier
+  DAG_optimizer _dag_optimizer;                             // DAG optimizer
+  dead_code_eliminator _dead_code_eliminator;               // DCE
+  assembly_generator _assembly_generator;                   // x86-64 backend
+  quadruple_interpreter _quadruple_interpreter;             // Interpreter
+  pass_manager _pass_manager;                               // Passes
+  compile_job _job;                                         // For `compile`
+  arena _arena;                                             // For `_job`
+  output_buffer _output;                                    // Output file
+  metrics _metrics;                                         // Metrics
+};
+
+#endif // LIB_7CXX_COMPILER_PIPELINE_H
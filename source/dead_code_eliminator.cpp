@@ -0,0 +1,71 @@
+#include "dead_code_eliminator.h"
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * @brief Judge if an item is a tmp
+ * @param item The item
+ * @return true The item is a tmp
+ * @return false The item is a number or empty
+ */
+static inline bool is_tmp(const quadruple::item &item) {
+  return item.first == quadruple::T || item.first == quadruple::optimized;
+}
+
+void dead_code_eliminator::eliminate_dead_code() {
+  mark_live();
+  renumber();
+}
+
+void dead_code_eliminator::mark_live() {
+  _live.assign(_origin_nodes.size(), false);
+  if (_origin_nodes.empty()) {
+    return;
+  }
+
+  // the result of the expression is used by whoever evaluates it
+  _used.clear();
+  _used.emplace(_origin_nodes.back().count, true);
+
+  for (size_t index = _origin_nodes.size(); index-- > 0;) {
+    const quadruple &quad = _origin_nodes[index];
+    if (_used.find(quad.count) == nullptr) {
+      continue;
+    }
+
+    _live[index] = true;
+    if (is_tmp(quad.operand1)) {
+      _used.emplace(quad.operand1, true);
+    }
+    if (is_tmp(quad.operand2)) {
+      _used.emplace(quad.operand2, true);
+    }
+  }
+}
+
+void dead_code_eliminator::renumber() {
+  int next = 1;
+
+  for (size_t index = 0; index < _origin_nodes.size(); ++index) {
+    if (!_live[index]) {
+      continue;
+    }
+
+    const quadruple &quad = _origin_nodes[index];
+    quadruple::item count(quad.count.first, next++);
+    _compacted_nodes.push_back(
+        {quad.op, rename(quad.operand1), rename(quad.operand2), count});
+    _renumbered[quad.count] = count;
+  }
+}
+
+quadruple::item
+dead_code_eliminator::rename(const quadruple::item &item) const {
+  if (!is_tmp(item)) {
+    return item;
+  }
+  const quadruple::item *renumbered = _renumbered.find(item);
+  return renumbered != nullptr ? *renumbered : item;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file dead_code_eliminator.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Dead code elimination and dense tmp renumbering
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_DEAD_CODE_ELIMINATOR_H
+#define LIB_7CXX_DEAD_CODE_ELIMINATOR_H
+
+#include "DAG_optimizer.h"
+#include "intermediate_code_generator.h"
+#include "open_hash_map.h"
+
+#include <cstddef>
+#include <vector>
+
+using std::size_t;
+using std::vector;
+
+/**
+ * @brief Remove quadruples whose results are never used, then renumber the
+ * remaining tmps as 1, 2, ..., n in order of definition.
+ *
+ * The result of the last quadruple is the value of the expression, so it is
+ * always live. After renumbering, a tmp array of `get_temp_count() + 1`
+ * entries can be indexed by tmp number directly.
+ */
+class dead_code_eliminator {
+public:
+  /**
+   * @brief Read origin nodes from vector
+   * @param nodes nodes
+   */
+  inline void read_origin_nodes(const vector<quadruple> &nodes) {
+    clear();
+    _origin_nodes = nodes;
+  }
+
+  /**
+   * @brief Eliminate dead quadruples and renumber the tmps
+   */
+  void eliminate_dead_code();
+
+  /**
+   * @brief Get the remaining quadruples
+   * @return The remaining quadruples
+   */
+  inline const vector<quadruple> &get_compacted() const {
+    return _compacted_nodes;
+  }
+
+  /**
+   * @brief Get the number of removed quadruples
+   * @return The number of removed quadruples
+   */
+  inline size_t get_removed_count() const {
+    return _origin_nodes.size() - _compacted_nodes.size();
+  }
+
+  /**
+   * @brief Get the number of tmps after renumbering, which is also the
+   * largest tmp number
+   * @return The number of tmps
+   */
+  inline size_t get_temp_count() const { return _compacted_nodes.size(); }
+
+  /**
+   * @brief Clear all data, ready for next elimination
+   */
+  inline void clear() {
+    _origin_nodes.clear();
+    _compacted_nodes.clear();
+    _live.clear();
+    _used.clear();
+    _renumbered.clear();
+  }
+
+private:
+  /**
+   * @brief Mark the quadruples whose results are used, from back to front
+   */
+  void mark_live();
+
+  /**
+   * @brief Copy the live quadruples with renumbered tmps
+   */
+  void renumber();
+
+  /**
+   * @brief Get the renumbered item
+   * @param item The origin item
+   * @return The renumbered tmp, or the item itself if it is not a tmp
+   */
+  quadruple::item rename(const quadruple::item &item) const;
+
+private:
+  vector<quadruple> _origin_nodes;                             // Origin nodes
+  vector<quadruple> _compacted_nodes;                          // Live nodes
+  vector<bool> _live;                                          // Liveness
+  open_hash_map<quadruple::item, bool> _used;                  // Used tmps
+  open_hash_map<quadruple::item, quadruple::item> _renumbered; // New names
+};
+
+#endif // LIB_7CXX_DEAD_CODE_ELIMINATOR_H
@@ -0,0 +1,137 @@
+#include "expression_generator.h"
+
+#include <cstdlib>
+#include <string>
+
+using std::to_string;
+
+// a term or a sum never leaves this range, far below the limits of `int`
+static const int64_t value_bound = 1 << 24;
+
+expression_generator::expression_generator(const generator_options &options,
+                                           uint64_t seed)
+    : _options(options), _seed(seed),
+      _mix_total(options.mix[0] + options.mix[1] + options.mix[2] +
+                 options.mix[3]) {
+  if (_mix_total == 0) {
+    // no weights at all is an even mix
+    for (unsigned int &weight : _options.mix) {
+      weight = 1;
+    }
+    _mix_total = 4;
+  }
+}
+
+int expression_generator::generate(uint64_t index, string &text) {
+  _state = _seed ^ (index * 0x9e3779b97f4a7c15ull);
+  text.clear();
+  return static_cast<int>(expression(text, _options.size, 0));
+}
+
+uint64_t expression_generator::next() {
+  uint64_t z = (_state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+char expression_generator::pick_operator() {
+  static const char operators[4] = {'+', '-', '*', '/'};
+  uint64_t pick = below(_mix_total);
+  for (int op = 0; op < 4; ++op) {
+    if (pick < _options.mix[op]) {
+      return operators[op];
+    }
+    pick -= _options.mix[op];
+  }
+  return '+';
+}
+
+int64_t expression_generator::expression(string &out, size_t budget,
+                                         size_t depth) {
+  size_t end = out.size() + budget;
+  string term, next_factor;
+  int64_t sum = 0;
+  char term_sign = '+';
+  bool first = true;
+
+  int64_t term_value = factor(term, budget, depth);
+  while (out.size() + term.size() < end) {
+    char op = pick_operator();
+    next_factor.clear();
+    size_t left = end - out.size() - term.size();
+    int64_t value = factor(next_factor, left > 3 ? left - 3 : 1, depth);
+
+    if (op == '*' || op == '/') {
+      if (op == '*' && std::llabs(term_value * value) > value_bound) {
+        op = '/';
+      }
+      if (op == '/' && value == 0) {
+        next_factor = to_string(1 + below(9));
+        value = next_factor[0] - '0';
+      }
+      term += ' ';
+      term += op;
+      term += ' ';
+      term += next_factor;
+      term_value = op == '*' ? term_value * value : term_value / value;
+      continue;
+    }
+
+    // `+` or `-` closes the term, its sign keeps the sum in range
+    if (!first) {
+      if (std::llabs(sum + (term_sign == '+' ? term_value : -term_value)) >
+          value_bound) {
+        term_sign = term_sign == '+' ? '-' : '+';
+      }
+      out += ' ';
+      out += term_sign;
+      out += ' ';
+    }
+    out += term;
+    sum += term_sign == '+' ? term_value : -term_value;
+    first = false;
+    term.swap(next_factor);
+    term_value = value;
+    term_sign = op;
+  }
+
+  if (!first) {
+    if (std::llabs(sum + (term_sign == '+' ? term_value : -term_value)) >
+        value_bound) {
+      term_sign = term_sign == '+' ? '-' : '+';
+    }
+    out += ' ';
+    out += term_sign;
+    out += ' ';
+  }
+  out += term;
+  return sum + (term_sign == '+' ? term_value : -term_value);
+}
+
+int64_t expression_generator::factor(string &out, size_t budget,
+                                     size_t depth) {
+  if (depth < _options.depth && budget > 8 &&
+      chance(_options.parentheses)) {
+    out += '(';
+    int64_t value = expression(out, budget / 2, depth + 1);
+    out += ')';
+    return value;
+  }
+
+  if (chance(_options.identifiers)) {
+    // no reserved word starts with these letters, the rest are letters and
+    // digits
+    static const char first_letters[] = "afghjklmnqsuxyz";
+    out += first_letters[below(sizeof(first_letters) - 1)];
+    for (size_t length = below(6); length > 0; --length) {
+      uint64_t pick = below(36);
+      out += static_cast<char>(pick < 26 ? 'a' + pick : '0' + (pick - 26));
+    }
+    return 1;
+  }
+
+  int64_t value = static_cast<int64_t>(below(100));
+  out += to_string(value);
+  return value;
+}
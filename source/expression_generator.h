@@ -0,0 +1,110 @@
+/**
+ * @file expression_generator.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Seeded generator of synthetic PL/0 expressions for benchmarks
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_EXPRESSION_GENERATOR_H
+#define LIB_7CXX_EXPRESSION_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using std::int64_t;
+using std::size_t;
+using std::string;
+using std::uint64_t;
+
+/**
+ * @brief The shape of generated expressions
+ */
+struct generator_options {
+  size_t size = 32;                   // Bytes of an expression, roughly
+  size_t depth = 3;                   // Deepest nesting of parentheses
+  unsigned int mix[4] = {4, 4, 2, 1}; // Weights of `+`, `-`, `*` and `/`
+  double parentheses = 0.2;           // Chance a factor is parenthesized
+  double identifiers = 0;             // Chance a factor is an identifier
+};
+
+/**
+ * @brief Generates expressions of the PL/0 grammar accepted by the parser.
+ *
+ * An expression depends only on the seed and its index, so a workload of any
+ * size is generated one expression at a time and is the same on every run.
+ * Divisors are never zero and values stay far from overflowing an `int`, so
+ * every expression without identifiers compiles and evaluates.
+ */
+class expression_generator {
+public:
+  /**
+   * @brief Construct a new generator
+   * @param options The shape of the expressions
+   * @param seed The seed
+   */
+  expression_generator(const generator_options &options, uint64_t seed);
+
+  /**
+   * @brief Generate an expression
+   * @param index The index of the expression
+   * @param text The expression, its capacity is reused
+   * @return The value of the expression, identifiers count as 1
+   */
+  int generate(uint64_t index, string &text);
+
+private:
+  /**
+   * @brief Get the next pseudo-random number, splitmix64
+   * @return The number
+   */
+  uint64_t next();
+
+  /**
+   * @brief Get a pseudo-random number below a bound
+   * @param bound The bound, greater than 0
+   * @return The number
+   */
+  inline uint64_t below(uint64_t bound) { return next() % bound; }
+
+  /**
+   * @brief Get true with a chance
+   * @param chance The chance, from 0 to 1
+   * @return The outcome
+   */
+  inline bool chance(double chance) {
+    return (next() >> 11) * (1.0 / 9007199254740992.0) < chance;
+  }
+
+  /**
+   * @brief Pick an operator by the weights of the mix
+   * @return The operator
+   */
+  char pick_operator();
+
+  /**
+   * @brief Append an expression of terms joined by `+` and `-`
+   * @param out The text
+   * @param budget The bytes to spend
+   * @param depth The nesting of parentheses around it
+   * @return The value
+   */
+  int64_t expression(string &out, size_t budget, size_t depth);
+
+  /**
+   * @brief Append a factor: a number, an identifier or a parenthesized
+   * expression
+   * @param out The text
+   * @param budget The bytes the factor may spend
+   * @param depth The nesting of parentheses around it
+   * @return The value
+   */
+  int64_t factor(string &out, size_t budget, size_t depth);
+
+private:
+  generator_options _options; // Shape of the expressions
+  uint64_t _seed;             // Seed of the workload
+  uint64_t _state = 0;        // State of the current expression
+  unsigned int _mix_total;    // Sum of the weights
+};
+
+#endif // LIB_7CXX_EXPRESSION_GENERATOR_H
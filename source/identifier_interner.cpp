@@ -0,0 +1,12 @@
+#include "identifier_interner.h"
+
+identifier_id identifier_interner::intern(const string &name) {
+  // most identifiers are uses of names already declared
+  if (const identifier_id *id = _ids.find(name)) {
+    return *id;
+  }
+  identifier_id id = static_cast<identifier_id>(_names.size());
+  _ids.emplace(name, id);
+  _names.push_back(name);
+  return id;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file identifier_interner.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Map every distinct identifier to a small integer
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_IDENTIFIER_INTERNER_H
+#define LIB_7CXX_IDENTIFIER_INTERNER_H
+
+#include "open_hash_map.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using std::size_t;
+using std::string;
+using std::uint32_t;
+using std::vector;
+
+/**
+ * @brief The id of an interned identifier, the ids are numbered from 0 in
+ * the order the identifiers are first seen
+ */
+typedef uint32_t identifier_id;
+
+/**
+ * @brief Interns identifiers, so that the stages after the scanner compare
+ * and hash names as integers.
+ *
+ * The scanner interns every identifier once, when it is read; the string
+ * is hashed only there. `clear` keeps the table for the next program.
+ */
+class identifier_interner {
+public:
+  /**
+   * @brief Intern an identifier
+   * @param name The identifier
+   * @return Its id, the same one every time the name is interned
+   */
+  identifier_id intern(const string &name);
+
+  /**
+   * @brief Get the identifier of an id
+   * @param id The id, returned by `intern`
+   * @return The identifier
+   */
+  inline const string &get_name(identifier_id id) const { return _names[id]; }
+
+  /**
+   * @brief Get the number of distinct identifiers
+   * @return The number, which is also the next id
+   */
+  inline size_t size() const { return _names.size(); }
+
+  /**
+   * @brief Forget all identifiers, the ids start from 0 again
+   */
+  inline void clear() {
+    _ids.clear();
+    _names.clear();
+  }
+
+private:
+  open_hash_map<string, identifier_id> _ids; // Ids of the identifiers
+  vector<string> _names;                     // Identifiers by id
+};
+
+#endif // LIB_7CXX_IDENTIFIER_INTERNER_H
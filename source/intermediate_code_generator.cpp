@@ -10,36 +10,65 @@ using std::make_pair;
 using std::to_string;
 using item = intermediate_code_generator::quadruple::item;
 
+const char intermediate_code_generator::quadruple::shift_left;
+
 item intermediate_code_generator::generate_quadruples(
     const shared_ptr<ASTNode> &node) {
-  {
-    // Leaf node (operand)
-    if (node->get_left() == nullptr && node->get_right() == nullptr) {
-      quadruple quad;
-      quad.op = '=';
-      quad.operand1 = make_pair(quadruple::number, node->get_val());
-      quad.operand2 = make_pair(quadruple::empty, 0);
-      quad.count = make_pair(quadruple::T, _count++);
+  // every node produces at most one quadruple
+  _quadruples.reserve(_quadruples.size() + node->get_size());
+
+  _work.clear();
+  _values.clear();
+  _work.push_back({node.get(), false});
 
-      _quadruples.push_back(quad);
+  while (!_work.empty()) {
+    work_item work = _work.back();
+    _work.pop_back();
+    const ASTNode *current = work.node;
 
-      return quad.count;
+    // Leaf node (operand)
+    if (current->get_left() == nullptr && current->get_right() == nullptr) {
+      if (_inline_constants && current != node.get()) {
+        _values.push_back(make_pair(quadruple::number, current->get_val()));
+      } else {
+        _values.push_back(generate_number(current->get_val()));
+      }
+      continue;
     }
 
-    item left_child = generate_quadruples(node->get_left());
-    item right_child = generate_quadruples(node->get_right());
-    int count = _count++;
+    // visit the left child, then the right child, then the node
+    if (!work.expanded) {
+      _work.push_back({current, true});
+      _work.push_back({current->get_right().get(), false});
+      _work.push_back({current->get_left().get(), false});
+      continue;
+    }
 
     quadruple quad;
-    quad.op = node->get_op();
-    quad.count = make_pair(quadruple::T, count);
-    quad.operand1 = left_child;
-    quad.operand2 = right_child;
+    quad.op = current->get_op();
+    quad.operand2 = _values.back();
+    _values.pop_back();
+    quad.operand1 = _values.back();
+    _values.pop_back();
+    quad.count = make_pair(quadruple::T, _count++);
 
     _quadruples.push_back(quad);
-
-    return quad.count;
+    _values.push_back(quad.count);
   }
+
+  return _values.back();
+}
+
+item intermediate_code_generator::generate_number(int value) {
+  quadruple quad;
+  quad.op = '=';
+  quad.operand1 = make_pair(quadruple::number, value);
+  quad.operand2 = make_pair(quadruple::empty, 0);
+  quad.count = make_pair(quadruple::T, _count++);
+
+  _quadruples.push_back(quad);
+
+  return quad.count;
 }
 
 string intermediate_code_generator::quadruple::item2str(item i) {
@@ -74,3 +103,23 @@ intermediate_code_generator::quadruple::str2item(const string &str) {
     return {quadruple::type::number, stoi(str)};
   }
 }
+
+string intermediate_code_generator::quadruple::op2str(char op) {
+  switch (op) {
+  case '=':
+    return ":=";
+  case quadruple::shift_left:
+    return "<<";
+  default:
+    return string(1, op);
+  }
+}
+
+char intermediate_code_generator::quadruple::str2op(const string &str) {
+  if (str == ":=") {
+    return '=';
+  } else if (str == "<<") {
+    return quadruple::shift_left;
+  }
+  return str[0];
+}
@@ -19,7 +19,9 @@ using std::string;
 class intermediate_code_generator {
  public:
   /**
-   * @brief Quadruple
+   * @brief Quadruple. The stages, the passes, the interpreter, the cache and
+   * the binary files all exchange quadruples as one `vector<quadruple>`,
+   * which the accessors hand out by const reference instead of copying
    */
   struct quadruple {
     enum type {
@@ -30,10 +32,32 @@ class intermediate_code_generator {
     };
     typedef pair<type, int> item;
 
+    /**
+     * @brief The operator of the shift-left produced by strength reduction.
+     * It is no character of PL/0, so no operator or relation is mistaken for
+     * it
+     */
+    static const char shift_left = 'S';
+
     static string item2str(item i);
 
     static quadruple::item str2item(const string &str);
 
+    /**
+     * @brief Convert an operator into its printed form, `=` is printed as
+     * `:=` and `shift_left` as `<<`
+     * @param op The operator
+     * @return The printed operator
+     */
+    static string op2str(char op);
+
+    /**
+     * @brief Convert a printed operator back into an operator
+     * @param str The printed operator
+     * @return The operator
+     */
+    static char str2op(const string &str);
+
     char op;       // Operator
     item operand1; // Operand 1
     item operand2; // Operand 2
@@ -42,17 +66,30 @@ class intermediate_code_generator {
 
  public:
   /**
-   * @brief Generate quadruples
+   * @brief Generate quadruples in postorder, without recursion. The output is
+   * reserved up front from the size of the tree.
    * @param node The ASTNode tree node
    * @return The count of the quadruple
    */
   quadruple::item generate_quadruples(const shared_ptr<ASTNode> &node);
 
+  /**
+   * @brief Choose how numbers are generated. By default every number gets
+   * its own `(:=, n, , Tk)`; with inline constants the number is used as the
+   * operand directly, which saves about half of the quadruples.
+   * @param inline_constants Whether to inline numbers into operations
+   */
+  inline void set_inline_constants(bool inline_constants) {
+    this->_inline_constants = inline_constants;
+  }
+
   /**
    * @brief Get quadruples
    * @return All quadruples
    */
-  inline vector<quadruple> get_quadruples() { return this->_quadruples; }
+  inline const vector<quadruple> &get_quadruples() const {
+    return this->_quadruples;
+  }
 
   /**
    * @brief Clear quadruples
@@ -63,8 +100,27 @@ class intermediate_code_generator {
   }
 
  private:
-  int _count = 1;                // start from 1
-  vector<quadruple> _quadruples; // All quadruples
+  /**
+   * @brief A node waiting on the work stack
+   */
+  struct work_item {
+    const ASTNode *node; // The node
+    bool expanded;       // Whether its children are already pushed
+  };
+
+  /**
+   * @brief Generate the `:=` quadruple of a number
+   * @param value The number
+   * @return The tmp holding the number
+   */
+  quadruple::item generate_number(int value);
+
+ private:
+  int _count = 1;                  // start from 1
+  bool _inline_constants = false;  // use numbers as operands directly
+  vector<quadruple> _quadruples;   // All quadruples
+  vector<work_item> _work;         // Work stack of the postorder traversal
+  vector<quadruple::item> _values; // Value stack of the postorder traversal
 };
 
 #endif // LIB_5CXX_INTERMEDIATE_CODE_GENERATOR_H
@@ -2,6 +2,7 @@
 #include "regex_pattern.h"
 #include "str_opekit.h"
 
+#include <cctype>
 #include <list>
 #include <regex>
 #include <string>
@@ -15,36 +16,40 @@ using std::smatch;
 using std::sregex_iterator;
 using std::string;
 
-string lexical_analyzer::read_text(ifstream &fin) {
-  string text, line;
+const string &lexical_analyzer::read_text(ifstream &fin) {
+  string line;
 
+  this->_text.clear();
   while (fin.good()) {
     std::getline(fin, line);
-    text += line;
+    this->_text += line;
   }
 
-  read_text_common(text);
+  read_text_common();
 
   return this->_text;
 }
 
-string lexical_analyzer::read_text(const string &str) {
-  string text = str;
+const string &lexical_analyzer::read_text(const string &str) {
+  this->_text = str;
 
-  read_text_common(text);
+  read_text_common();
 
   return this->_text;
 }
 
-void lexical_analyzer::read_text_common(string &text) {
-  _parsed_pairs.clear();
+void lexical_analyzer::read_text_common() {
+  clear();
 
-  replace_all(text, "\n", "");
-  str_tolower(text);
-  this->_text = text;
+  replace_all(this->_text, "\n", "");
+  str_tolower(this->_text);
 }
 
-list<lexical_pair> lexical_analyzer::parse_text() {
+lexical_list &lexical_analyzer::parse_text() {
+  if (_scanner && scan_text()) {
+    return this->_parsed_pairs;
+  }
+
   this->_parsed_pairs.push_back({"", _text});
 
   parse_with_patterns();
@@ -80,6 +85,7 @@ void lexical_analyzer::parse_with_pattern(regex reg_pattern) {
 
     while (true) {
       text = iterator->second;
+      PL0_METRIC(++_regex_pass_count);
       regex_search(text, match_result, reg_pattern);
       if (match_result.empty() || match_result[0].str() == text) {
         break;
@@ -96,11 +102,15 @@ void lexical_analyzer::parse_with_pattern(regex reg_pattern) {
                                    make_pair("", strip(new_string_pre)));
       }
 
-      this->_parsed_pairs.insert(iterator, make_pair(token, matched_string));
+      auto matched = this->_parsed_pairs.insert(
+          iterator, make_pair(token, matched_string));
 
       if (!is_all_whitespace(new_string_post)) {
         iterator = this->_parsed_pairs.insert(
             iterator, make_pair("", strip(new_string_post)));
+      } else {
+        // nothing left behind the match, never step onto `end()`
+        iterator = matched;
       }
     }
   }
@@ -180,3 +190,159 @@ void lexical_analyzer::token_mark_identifier() {
     }
   }
 }
+
+/**
+ * @brief Judge if a character may start an identifier, after `str_tolower`
+ * @param c The character
+ * @return true It is a letter
+ * @return false It is not a letter
+ */
+static inline bool is_letter(char c) { return c >= 'a' && c <= 'z'; }
+
+/**
+ * @brief Judge if a character may continue an identifier, like `\w`
+ * @param c The character
+ * @return true It is a letter, a digit or `_`
+ * @return false It is something else
+ */
+static inline bool is_word(char c) {
+  return is_letter(c) || (c >= '0' && c <= '9') || c == '_';
+}
+
+/**
+ * @brief Judge if a character is split off by the paren and operator
+ * patterns
+ * @param c The character
+ * @return true It is a parenthesis or an operator of an expression
+ * @return false It is something else
+ */
+static inline bool is_single(char c) {
+  return c == '(' || c == ')' || c == '+' || c == '-' || c == '*' || c == '/';
+}
+
+/**
+ * @brief Judge if a character is a white space, like `strip` sees it
+ * @param c The character
+ * @return true It is a white space
+ * @return false It is something else
+ */
+static inline bool is_space(char c) {
+  return isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+bool lexical_analyzer::scan_text() {
+  // only the paren, operator and identifier patterns can match these texts,
+  // the others need `=`, `#`, `<`, `>`, `:`, `;`, `.` or one of the words
+  static const char *const pattern_words[] = {"odd", "call", "begin", "read",
+                                              "write"};
+  for (char c : this->_text) {
+    if (!is_word(c) && !is_single(c) &&
+        (static_cast<unsigned char>(c) >= 0x80 || !is_space(c))) {
+      return false;
+    }
+  }
+  for (const char *word : pattern_words) {
+    if (this->_text.find(word) != string::npos) {
+      return false;
+    }
+  }
+
+  // parentheses and operators are lexemes of their own, the chunks between
+  // them are split by the identifier pattern
+  size_t begin = 0;
+  for (size_t index = 0; index < this->_text.size(); ++index) {
+    if (is_single(this->_text[index])) {
+      scan_chunk(begin, index);
+      append_lexeme(&this->_text[index], 1);
+      begin = index + 1;
+    }
+  }
+  scan_chunk(begin, this->_text.size());
+
+  // a blank text stays one empty lexeme
+  if (this->_parsed_pairs.empty()) {
+    append_lexeme("", 0);
+  }
+
+  lexical_pair &marker = append_pair();
+  marker.first = "acc";
+  marker.second = "#";
+  return true;
+}
+
+void lexical_analyzer::scan_chunk(size_t begin, size_t end) {
+  const char *text = this->_text.data();
+
+  // every piece is stripped, blank ones are dropped
+  while (begin < end && is_space(text[begin])) {
+    ++begin;
+  }
+  while (end > begin && is_space(text[end - 1])) {
+    --end;
+  }
+
+  while (begin < end) {
+    size_t letter = begin;
+    while (letter < end && !is_letter(text[letter])) {
+      ++letter;
+    }
+    if (letter == end) {
+      append_lexeme(text + begin, end - begin);
+      return;
+    }
+
+    // `[A-Za-z]\w{0,9}`, the text before it is a lexeme of its own
+    size_t word_end = letter + 1;
+    while (word_end < end && word_end - letter < 10 &&
+           is_word(text[word_end])) {
+      ++word_end;
+    }
+    size_t before_end = letter;
+    while (before_end > begin && is_space(text[before_end - 1])) {
+      --before_end;
+    }
+    if (before_end > begin) {
+      append_lexeme(text + begin, before_end - begin);
+    }
+    append_lexeme(text + letter, word_end - letter);
+
+    begin = word_end;
+    while (begin < end && is_space(text[begin])) {
+      ++begin;
+    }
+  }
+}
+
+void lexical_analyzer::append_lexeme(const char *lexeme, size_t size) {
+  lexical_pair &pair = append_pair();
+  pair.second.assign(lexeme, size);
+
+  // the same order as `parse_text` marks the tokens
+  pair.first.clear();
+  decltype(reserved.begin()) ite;
+  if (ite = reserved.find(pair.second), ite != reserved.end()) {
+    pair.first = ite->second;
+  }
+  if (ite = operators.find(pair.second), ite != operators.end()) {
+    pair.first = ite->second;
+  }
+  if (ite = delimiters.find(pair.second), ite != delimiters.end()) {
+    pair.first = ite->second;
+  }
+  if (size > 0 && is_digit(pair.second)) {
+    pair.first = "number";
+  }
+  if (pair.first.empty()) {
+    pair.first = "ident";
+  }
+}
+
+lexical_pair &lexical_analyzer::append_pair() {
+  if (this->_spare_pairs.empty()) {
+    this->_parsed_pairs.emplace_back();
+  } else {
+    this->_parsed_pairs.splice(this->_parsed_pairs.end(), this->_spare_pairs,
+                               this->_spare_pairs.begin());
+  }
+  return this->_parsed_pairs.back();
+}
@@ -7,7 +7,9 @@
 #ifndef LIB_2CXX_LEXICAL_ANALYZER_H
 #define LIB_2CXX_LEXICAL_ANALYZER_H
 
+#include "arena.h"
 #include "lexemes.h"
+#include "metrics.h"
 #include "regex_pattern.h"
 
 #include <fstream>
@@ -18,6 +20,11 @@
 using std::ifstream;
 using std::list;
 
+/**
+ * @brief {Token, Lexeme} pairs, the nodes may come from an arena
+ */
+typedef list<lexical_pair, arena_allocator<lexical_pair>> lexical_list;
+
 /**
  * @brief The parser for PL/0 language
  * @warning You must call `read_text` before you call `parse_text`!
@@ -28,24 +35,44 @@ public:
    * @brief Read program text from a file
    *
    * @param fin A `ifstream` object
-   * @return string The processed text.
+   * @return const string& The processed text.
    */
-  string read_text(ifstream &fin);
+  const string &read_text(ifstream &fin);
 
   /**
    * @brief Read program text from a string
    *
    * @param str A string.
-   * @return string The processed text.
+   * @return const string& The processed text.
    */
-  string read_text(const string &str);
+  const string &read_text(const string &str);
 
   /**
    * @brief Parse the program text
    *
-   * @return list<lexical_pair> Parsed lexical pairs.
+   * @return lexical_list& Parsed lexical pairs.
+   */
+  lexical_list &parse_text();
+
+  /**
+   * @brief Parse expressions with the hand-written scanner instead of the
+   * regex patterns.
+   *
+   * Expressions made of numbers, identifiers, `+ - * /`, parentheses and
+   * spaces, without the words the statement patterns look for (`odd`,
+   * `call`, `begin`, `read`, `write`), give the same pairs as with the
+   * patterns, in one pass and without a regex search; every other text still
+   * goes through the patterns. The scanned list ends with the end marker of
+   * the parser, `{"acc", "#"}`. Its nodes are not freed by `clear` but kept
+   * for the next text, so scanning a text no longer than an earlier one does
+   * not allocate.
+   *
+   * @param scanner Whether to use the scanner
    */
-  list<lexical_pair> parse_text();
+  inline void set_scanner(bool scanner) {
+    _scanner = scanner;
+    _spare_pairs.clear();
+  }
 
   /**
    * @brief Get the expression
@@ -55,22 +82,85 @@ public:
 
   /**
    * @brief Get the parsed list
-   * @return list<lexical_pair> Parsed lexical pairs.
+   * @return lexical_list Parsed lexical pairs.
    */
-  inline list<lexical_pair> &get_list() { return _parsed_pairs; }
+  inline lexical_list &get_list() { return _parsed_pairs; }
+
+  /**
+   * @brief Take the nodes of the parsed list from an arena, until another one
+   * is set. The nodes of an arena are freed by `clear` instead of being kept
+   * for the scanner, so nothing of the arena stays in the analyzer.
+   * @param memory The arena, or null for the heap
+   */
+  inline void set_arena(arena *memory) {
+    arena_allocator<lexical_pair> allocator(memory);
+    if (_parsed_pairs.get_allocator() != allocator) {
+      _parsed_pairs = lexical_list(allocator);
+    }
+    if (_spare_pairs.get_allocator() != allocator) {
+      _spare_pairs = lexical_list(allocator);
+    }
+    _arena = memory;
+  }
+
+  /**
+   * @brief Get the number of regex searches run since the last `clear`,
+   * counted only in builds with metrics
+   * @return The number of searches
+   */
+  inline size_t get_regex_pass_count() const { return _regex_pass_count; }
 
   /**
    * @brief Clear the parsed list, to run next parse.
    */
-  inline void clear() { this->_parsed_pairs.clear(); };
+  inline void clear() {
+    if (_scanner && _arena == nullptr) {
+      _spare_pairs.splice(_spare_pairs.end(), _parsed_pairs);
+    } else {
+      this->_parsed_pairs.clear();
+    }
+    _regex_pass_count = 0;
+  };
 
 private:
   /**
-   * @brief The common operation for function `read_text`
-   * @param text The string to be processed
+   * @brief The common operation for function `read_text`, on the text read
    * @return none
    */
-  inline void read_text_common(string &text);
+  inline void read_text_common();
+
+  /**
+   * @brief Parse the text with the hand-written scanner
+   *
+   * @return true The text is parsed
+   * @return false The text needs the regex patterns, nothing is parsed
+   */
+  bool scan_text();
+
+  /**
+   * @brief Scan the text between two operators or parentheses into
+   * identifiers and the rest, like the identifier pattern splits it
+   *
+   * @param begin The first character
+   * @param end The character after the last one
+   */
+  void scan_chunk(size_t begin, size_t end);
+
+  /**
+   * @brief Append a lexeme to the list, on a spare node if there is one, and
+   * mark its token like the `token_mark_*` functions
+   *
+   * @param lexeme The lexeme
+   * @param size The size of the lexeme
+   */
+  void append_lexeme(const char *lexeme, size_t size);
+
+  /**
+   * @brief Append an empty pair to the list, on a spare node if there is one
+   *
+   * @return lexical_pair& The pair
+   */
+  lexical_pair &append_pair();
 
   /**
    * @brief Parse every item in the list with the specific regex pattern.
@@ -115,8 +205,12 @@ private:
   void token_mark_identifier();
 
 private:
-  list<lexical_pair> _parsed_pairs;
+  lexical_list _parsed_pairs;
   string _text;
+  size_t _regex_pass_count = 0; // regex searches since the last `clear`
+  bool _scanner = false;        // scan expressions without the patterns
+  lexical_list _spare_pairs;    // nodes kept for the scanner
+  arena *_arena = nullptr;      // arena of the parsed list, null for the heap
 };
 
 #endif //! LIB_2CXX_LEXICAL_ANALYZER_H
@@ -0,0 +1,153 @@
+#include "compile_protocol.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+typedef chrono::steady_clock loadgen_clock;
+
+/**
+ * @brief Get a percentile of sorted latencies
+ * @param sorted The latencies, sorted
+ * @param percent The percentile
+ * @return The latency
+ */
+static double percentile(const vector<double> &sorted, double percent) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t rank = static_cast<size_t>(percent / 100 * (sorted.size() - 1) + 0.5);
+  return sorted[rank];
+}
+
+int main(int argc, char *argv[]) {
+  // <socket>: the path of the server socket
+  // -c <n>: the number of concurrent clients, 4 by default
+  // -n <n>: the number of requests of every client, 1000 by default
+  // -e <expression>: the expression to send
+  // --compile: send compile requests instead of evaluate requests
+  // --shutdown: stop the server afterwards
+  string socket_path;
+  size_t client_count = 4;
+  size_t request_count = 1000;
+  string expression = "(6+3)*3-(5+13)*2";
+  char kind = compile_protocol::request_evaluate;
+  bool shutdown = false;
+  for (int index = 1; index < argc; ++index) {
+    string arg = argv[index];
+    if (arg == "-c" && index + 1 < argc) {
+      client_count = stoul(argv[++index]);
+    } else if (arg == "-n" && index + 1 < argc) {
+      request_count = stoul(argv[++index]);
+    } else if (arg == "-e" && index + 1 < argc) {
+      expression = argv[++index];
+    } else if (arg == "--compile") {
+      kind = compile_protocol::request_compile;
+    } else if (arg == "--shutdown") {
+      shutdown = true;
+    } else if (socket_path.empty() && !arg.empty() && arg[0] != '-') {
+      socket_path = arg;
+    } else {
+      cerr << "unknown option: " << arg << endl;
+      return 1;
+    }
+  }
+  if (socket_path.empty()) {
+    cerr << "usage: pl0_loadgen <socket> [-c clients] [-n requests] "
+            "[-e expression] [--compile] [--shutdown]"
+         << endl;
+    return 1;
+  }
+
+  // every client sends its requests one after another and records the
+  // latency of each of them
+  vector<vector<double>> latencies(client_count);
+  vector<size_t> failures(client_count, 0);
+  vector<string> errors(client_count);
+  loadgen_clock::time_point start = loadgen_clock::now();
+  vector<thread> clients;
+  for (size_t client = 0; client < client_count; ++client) {
+    clients.emplace_back([&, client]() {
+      try {
+        int fd = compile_protocol::connect_to(socket_path);
+        string response;
+        char status = 0;
+        latencies[client].reserve(request_count);
+        for (size_t index = 0; index < request_count; ++index) {
+          loadgen_clock::time_point sent = loadgen_clock::now();
+          compile_protocol::send_frame(fd, kind, expression.data(),
+                                       expression.size());
+          if (!compile_protocol::receive_frame(fd, status, response)) {
+            throw ios_base::failure("server closed the connection");
+          }
+          latencies[client].push_back(
+              chrono::duration<double>(loadgen_clock::now() - sent).count());
+          if (status != compile_protocol::response_ok) {
+            ++failures[client];
+          }
+        }
+#ifdef __unix__
+        ::close(fd);
+#endif
+      } catch (const exception &e) {
+        errors[client] = e.what();
+      }
+    });
+  }
+  for (thread &t : clients) {
+    t.join();
+  }
+  double seconds =
+      chrono::duration<double>(loadgen_clock::now() - start).count();
+
+  vector<double> all;
+  size_t failed = 0;
+  for (size_t client = 0; client < client_count; ++client) {
+    all.insert(all.end(), latencies[client].begin(), latencies[client].end());
+    failed += failures[client];
+    if (!errors[client].empty()) {
+      cerr << "client " << client << ": " << errors[client] << endl;
+    }
+  }
+  sort(all.begin(), all.end());
+
+  cout << fixed << setprecision(1);
+  cout << "requests:   " << all.size() << " (" << failed << " not ok)" << endl;
+  cout << "throughput: " << (seconds > 0 ? all.size() / seconds : 0)
+       << " requests/s" << endl;
+  cout << "p50:        " << percentile(all, 50) * 1e6 << " us" << endl;
+  cout << "p99:        " << percentile(all, 99) * 1e6 << " us" << endl;
+  cout << "max:        " << (all.empty() ? 0 : all.back() * 1e6) << " us"
+       << endl;
+
+  if (shutdown) {
+    try {
+      int fd = compile_protocol::connect_to(socket_path);
+      string response;
+      char status = 0;
+      compile_protocol::send_frame(fd, compile_protocol::request_shutdown,
+                                   nullptr, 0);
+      compile_protocol::receive_frame(fd, status, response);
+#ifdef __unix__
+      ::close(fd);
+#endif
+    } catch (const exception &e) {
+      cerr << "shutdown: " << e.what() << endl;
+      return 1;
+    }
+  }
+
+  return failed == 0 && all.size() == client_count * request_count ? 0 : 1;
+}
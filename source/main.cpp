@@ -1,119 +1,726 @@
-#include "lexical_analyzer.h"
-#include "semantic_analyzer.h"
-#include "slr1.h"
-#include "intermediate_code_generator.h"
+#include "batch_io.h"
+#include "compile_cache.h"
+#include "compile_server.h"
+#include "compiler_pipeline.h"
 #include "DAG_optimizer.h"
+#include "output_buffer.h"
+#include "pcode_compiler.h"
+#include "pcode_vm.h"
+#include "pipelined_compiler.h"
+#include "quadruple_file.h"
+#include "quadruple_interpreter.h"
+#include "record_reader.h"
 #include "regex_pattern.h"
+#include "thread_pool.h"
 
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 using namespace std;
 
+#ifndef _PRINT_REGEX_
+/**
+ * @brief Compile files on a pool, reading the inputs and writing the outputs
+ * in batches. Every batch is read at once, compiled concurrently, and its
+ * `.txt` outputs are written at once; an input the batch cannot read goes
+ * through the pipeline's own reading, which reports it as before.
+ * @param pool The pool
+ * @param pipelines One pipeline per worker, and one for the waiting thread
+ * @param inputs The input files
+ * @param stems The output stems
+ * @param results The results, in input order
+ * @throw std::ios_base::failure io_uring stopped working
+ */
+static void compile_batched(thread_pool &pool,
+                            vector<unique_ptr<compiler_pipeline>> &pipelines,
+                            const vector<string> &inputs,
+                            const vector<string> &stems,
+                            vector<compile_result> &results) {
+  const size_t batch_size = 4 * batch_io::files_in_flight;
+  batch_io batchIo;
+  vector<batch_file> reads;
+  vector<batch_file> writes;
+  for (size_t first = 0; first < inputs.size(); first += batch_size) {
+    size_t count = min(batch_size, inputs.size() - first);
+    reads.resize(count);
+    writes.resize(count);
+    for (size_t offset = 0; offset < count; ++offset) {
+      reads[offset].name = inputs[first + offset];
+    }
+    batchIo.read_files(reads);
+
+    task_group group(pool);
+    for (size_t offset = 0; offset < count; ++offset) {
+      group.run([&, first, offset]() {
+        size_t index = first + offset;
+        compiler_pipeline &pipeline = *pipelines[pool.worker_index()];
+        string function_name = "pl0_expression" + to_string(index + 1);
+        batch_file &output = writes[offset];
+        output.name.clear();
+        if (!reads[offset].error.empty()) {
+          results[index] =
+              pipeline.compile(inputs[index], stems[index], function_name);
+          return;
+        }
+
+        results[index] = pipeline.compile_loaded(
+            inputs[index], reads[offset].data, stems[index], function_name);
+        if (results[index].error.empty()) {
+          output.name = stems[index] + ".txt";
+          output.data.assign(pipeline.get_output().data(),
+                             pipeline.get_output().size());
+        }
+      });
+    }
+    group.wait();
+
+    batchIo.write_files(writes);
+    for (size_t offset = 0; offset < count; ++offset) {
+      if (!writes[offset].error.empty()) {
+        compile_result &result = results[first + offset];
+        result.valid = false;
+        result.error = inputs[first + offset] + ": " +
+                       ios_base::failure(writes[offset].error).what();
+      }
+    }
+  }
+}
+
+/**
+ * @brief Compile every record of a file, see `record_reader`, and write one
+ * line per record to `<stem>.txt`: `<record>\t<value>`, or
+ * `<record>\terror\t<why>` for a record which fails, without stopping the
+ * others. The file is streamed in blocks, the records of a block are
+ * compiled concurrently.
+ * @param pool The pool
+ * @param pipelines One pipeline per worker, and one for the waiting thread
+ * @param input The input file
+ * @param stem The output stem
+ * @return The result of the file, which fails only if the file cannot be
+ * read or written
+ */
+static compile_result
+compile_records(thread_pool &pool,
+                vector<unique_ptr<compiler_pipeline>> &pipelines,
+                const string &input, const string &stem) {
+  const size_t block_size = 4096; // records read at once
+  const size_t task_size = 64;    // records compiled by one task
+  const string output_name = stem + ".txt";
+  compile_result result;
+  try {
+    ifstream fin(input);
+    if (!fin.is_open()) {
+      throw ios_base::failure("file " + input + " open failed");
+    }
+    ofstream fout(output_name, ios_base::binary | ios_base::trunc);
+    if (!fout.is_open()) {
+      throw ios_base::failure("file " + output_name + " open failed");
+    }
+
+    record_reader reader(fin);
+    vector<input_record> records;
+    vector<compile_result> recordResults;
+    output_buffer recordOutput;
+    size_t count;
+    while ((count = reader.read(records, block_size)) > 0) {
+      recordResults.resize(count);
+      task_group group(pool);
+      for (size_t first = 0; first < count; first += task_size) {
+        group.run([&, first]() {
+          compiler_pipeline &pipeline = *pipelines[pool.worker_index()];
+          size_t last = min(first + task_size, count);
+          for (size_t index = first; index < last; ++index) {
+            const input_record &record = records[index];
+            recordResults[index] = pipeline.compile_text(
+                input + ":" + to_string(record.line), record.text,
+                stage_optimize);
+          }
+        });
+      }
+      group.wait();
+
+      recordOutput.clear();
+      for (size_t index = 0; index < count; ++index) {
+        const input_record &record = records[index];
+        const compile_result &recordResult = recordResults[index];
+        recordOutput << record.number << '\t';
+        if (!recordResult.error.empty()) {
+          recordOutput << "error\t" << recordResult.error;
+        } else if (!recordResult.valid) {
+          recordOutput << "error\t" << input << ':' << record.line
+                       << " is not valid";
+        } else {
+          recordOutput << recordResult.value;
+        }
+        recordOutput << '\n';
+      }
+      fout.write(recordOutput.data(),
+                 static_cast<streamsize>(recordOutput.size()));
+      if (!fout) {
+        throw ios_base::failure("file " + output_name + " write failed");
+      }
+    }
+    if (reader.failed()) {
+      throw ios_base::failure("file " + input + " read failed");
+    }
+    result.valid = true;
+  } catch (const ios_base::failure &e) {
+    result.error = input + ": " + e.what();
+  }
+  return result;
+}
+
+/**
+ * @brief Compile PL/0 programs to p-code, write the listing of every program
+ * to `<stem>.pcode` and run the programs one after another; `read` and
+ * `write` use the standard input and output.
+ * @param inputs The programs
+ * @param stems The output stems
+ * @param superinstructions Fuse common sequences in the VM
+ * @return 0 if every program compiled and ran, otherwise 1
+ */
+static int run_programs(const vector<string> &inputs,
+                        const vector<string> &stems, bool superinstructions) {
+  pcode_compiler pcodeCompiler;
+  pcode_vm pcodeVm(pcode_vm::default_stack_size, superinstructions);
+  int status = 0;
+  for (size_t index = 0; index < inputs.size(); ++index) {
+    try {
+      ifstream fin(inputs[index]);
+      if (!fin.is_open()) {
+        throw ios_base::failure("file " + inputs[index] + " open failed");
+      }
+      string program((istreambuf_iterator<char>(fin)),
+                     istreambuf_iterator<char>());
+
+      const vector<pcode_instruction> &code = pcodeCompiler.compile(program);
+      output_buffer listing;
+      print_pcode(listing, code);
+      listing.write_file(stems[index] + ".pcode");
+
+      pcodeVm.load(code);
+      pcodeVm.run(cin, cout);
+    } catch (const exception &e) {
+      cout.flush();
+      cerr << inputs[index] << ": " << e.what() << endl;
+      status = 1;
+    }
+  }
+  return status;
+}
+
+/**
+ * @brief Map quadruple files written by `--emit-binary`, optimize their
+ * quadruples with the DAG optimizer, run the optimized ones and write both to
+ * `<stem>.qir.txt`
+ * @param inputs The quadruple files
+ * @param stems The output stems
+ * @return 0 if every file was loaded and run, otherwise 1
+ */
+static int load_binaries(const vector<string> &inputs,
+                         const vector<string> &stems) {
+  const string delimiter_line(80, '-');
+  DAG_optimizer dagOptimizer;
+  quadruple_interpreter quadrupleInterpreter;
+  int status = 0;
+  for (size_t index = 0; index < inputs.size(); ++index) {
+    try {
+      quadruple_file quadrupleFile(inputs[index]);
+      dagOptimizer.read_origin_nodes(quadrupleFile);
+      dagOptimizer.optimize_quadruples();
+      const vector<quadruple> &optimized = dagOptimizer.get_optimized();
+      int value = quadrupleInterpreter.execute(optimized);
+
+      output_buffer output;
+      output << "Loaded quadruples: " << quadrupleFile.size() << '\n';
+      output << delimiter_line << '\n';
+      output << "Optimized quadruples: \n";
+      compiler_pipeline::print_quadruples(output, optimized);
+      output << "Eliminated common subexpressions: "
+             << dagOptimizer.get_eliminated_count() << '\n';
+      output << delimiter_line << '\n';
+      output << "Expression result: " << value << '\n';
+      output.write_file(stems[index] + ".qir.txt");
+    } catch (const exception &e) {
+      cerr << inputs[index] << ": " << e.what() << endl;
+      status = 1;
+    }
+  }
+  return status;
+}
+
+/**
+ * @brief Parse the number of an option
+ * @param option The option
+ * @param value The number, decimal digits only
+ * @return The number
+ * @throw std::invalid_argument The value is not a number or is too large
+ */
+static size_t parse_count(const string &option, const string &value) {
+  if (value.empty() || value.find_first_not_of("0123456789") != string::npos) {
+    throw invalid_argument(option + " needs a number instead of \"" + value +
+                           "\"");
+  }
+  try {
+    return stoul(value);
+  } catch (const out_of_range &) {
+    throw invalid_argument(option + " " + value + " is too large");
+  }
+}
+
+/**
+ * @brief Parse the worker counts of the stages of the pipelined mode
+ * @param option The option, used in messages
+ * @param value A comma-separated list of `<stage>=<n>`
+ * @return The workers of every stage, indexed by `compile_stage`
+ * @throw std::invalid_argument A stage does not exist, or a count is not a
+ * positive number
+ */
+static vector<size_t> parse_stage_workers(const string &option,
+                                          const string &value) {
+  vector<size_t> workers(compile_stage_size, 1);
+  size_t begin = 0;
+  while (begin <= value.size()) {
+    size_t end = value.find(',', begin);
+    if (end == string::npos) {
+      end = value.size();
+    }
+    string item = value.substr(begin, end - begin);
+    size_t equal = item.find('=');
+    if (equal == string::npos) {
+      throw invalid_argument(option + " needs <stage>=<n> instead of \"" +
+                             item + "\"");
+    }
+    string name = item.substr(0, equal);
+    int stage = 0;
+    while (stage < compile_stage_size &&
+           name != compiler_pipeline::stage_name(
+                       static_cast<compile_stage>(stage))) {
+      ++stage;
+    }
+    if (stage == compile_stage_size) {
+      throw invalid_argument(option + ": unknown stage " + name);
+    }
+    workers[stage] = parse_count(option, item.substr(equal + 1));
+    if (workers[stage] == 0) {
+      throw invalid_argument(option + ": the stage " + name +
+                             " needs at least one worker");
+    }
+    begin = end + 1;
+  }
+  return workers;
+}
+#endif
+
 int main(int argc, char *argv[]) {
   const string delimiter_line(80, '-');
 #ifndef _PRINT_REGEX_
   const char *BASE_INPUT_FILENAME_PRE = "../test_files/input";
+  const char *BASE_PROGRAM_FILENAME_PRE = "../test_files/program";
   const char *BASE_FILENAME_POST = ".txt";
-  const char *BASE_OUTPUT_FILENAME_PRE = "../output/output";
 
-  ifstream fin;   // input file stream
-  ofstream fout;  // output file stream
+  compile_options options;     // options of every pipeline
+  vector<string> patterns;     // input paths and glob patterns
+  string output_directory = "../output";
+  size_t thread_count = 0;     // 0 means one per hardware thread
+  size_t queue_capacity = 64;  // files in flight in the pipelined mode
+  vector<size_t> stage_workers; // workers of every stage, one by default
+  bool batch = false;
+  string batch_output;         // the output of --batch
+  bool pipelined = false;
+  bool batched_io = false;     // read and write the files in batches
+  bool records = false;        // every line or `;` record is an expression
+  bool run = false;            // the inputs are PL/0 programs to run
+  bool fused = true;           // run p-code with superinstructions
+  bool load_binary = false;    // the inputs are quadruple files
+  string socket_path;          // serve requests on this socket
+  string cache_directory;      // cache results in this directory
+  size_t cache_megabytes = 64; // size limit of the cache
+  string metrics_file;         // write the metrics of the run here
+  string metrics_format = "json";
 
-  lexical_analyzer lexicalAnalyzer;                       // lexical analyzer
-  semantic_analyzer semanticAnalyzer;                     // semantic analyzer
-  slr1 slr1;                                              // SLR1 parser
-  intermediate_code_generator intermediateCodeGenerator;  // intermediate code generator
-  DAG_optimizer dagOptimizer;                             // DAG optimizer
+  // <input>...: input paths or glob patterns, input1..10 under
+  //   ../test_files by default
+  // -o <directory>: the output directory, ../output by default
+  // -j <n>: compile with n threads, one per hardware thread by default
+  // --disable-pass <name>: skip a pass
+  // --no-verify: do not verify quadruples between passes
+  // --pass-statistics: print the statistics of every pass
+  // --emit-assembly: write the optimized quadruples as x86-64 assembly
+  // --emit-binary: write the parsed and optimized quadruples as binary files
+  // --classic-quadruples: generate a `:=` quadruple for every number
+  // --allocation-free: scan expressions without regex searches and keep the
+  //   memory of every stage for the next file
+  // --arena: take the tokens and the tree of every file from an arena, which
+  //   is reset once the file is done
+  // --batch: also optimize all files together, sharing common computations
+  // --batch-output <file>: the output of --batch, output_batch.txt in the
+  //   output directory by default; it must not be the output of an input
+  // --pipelined: run every stage on its own thread instead of running every
+  //   file on a thread, and print the utilization of the stages
+  // --batched-io: read the inputs and write the outputs in batches, with
+  //   io_uring where the kernel has it; not with --pipelined
+  // --records: compile every line, and every `;`-separated part of a line,
+  //   of an input as an expression of its own, and write one result line per
+  //   record; not with --batch, --batched-io or --pipelined
+  // --run: the inputs are whole PL/0 programs, program1..2 under
+  //   ../test_files by default; compile every one to p-code, write it to
+  //   <stem>.pcode and run it, reading from the standard input and writing
+  //   to the standard output; only with -o and --no-superinstructions
+  // --no-superinstructions: run every p-code instruction on its own
+  // --load-binary: the inputs are quadruple files written by --emit-binary,
+  //   *.qir in the output directory by default; map every one, optimize and
+  //   run its quadruples and write them to <stem>.qir.txt; only with -o
+  // --queue-capacity <n>: the files in flight in the pipelined mode
+  // --stage-workers <stage>=<n>[,...]: run a stage of the pipelined mode on
+  //   n threads, e.g. tree=2,optimize=2; the stages are lex, validate, tree,
+  //   generate, optimize and output
+  // --serve <socket>: serve compile requests on a Unix domain socket with
+  //   -j pipelines, instead of compiling files
+  // --cache <directory>: take unchanged inputs from, and store new results
+  //   in, a cache directory
+  // --cache-size <MiB>: the size limit of the cache, 64 MiB by default
+  // --metrics <file>: write the counters and timers of the stages, `-` for
+  //   the standard output; needs a build with PL0_METRICS
+  // --metrics-format <json|prometheus>: the format of the metrics, json by
+  //   default
+  try {
+    for (int index = 1; index < argc; ++index) {
+      string arg = argv[index];
+      if (arg == "-o" && index + 1 < argc) {
+        output_directory = argv[++index];
+      } else if (arg == "-j" && index + 1 < argc) {
+        thread_count = parse_count(arg, argv[++index]);
+      } else if (arg == "--disable-pass" && index + 1 < argc) {
+        options.disabled_passes.push_back(argv[++index]);
+      } else if (arg == "--no-verify") {
+        options.verify = false;
+      } else if (arg == "--pass-statistics") {
+        options.pass_statistics = true;
+      } else if (arg == "--emit-assembly") {
+        options.emit_assembly = true;
+      } else if (arg == "--emit-binary") {
+        options.emit_binary = true;
+      } else if (arg == "--classic-quadruples") {
+        options.inline_constants = false;
+      } else if (arg == "--allocation-free") {
+        options.allocation_free = true;
+      } else if (arg == "--arena") {
+        options.use_arenas = true;
+      } else if (arg == "--batch") {
+        batch = true;
+      } else if (arg == "--batch-output" && index + 1 < argc) {
+        batch_output = argv[++index];
+      } else if (arg == "--pipelined") {
+        pipelined = true;
+      } else if (arg == "--batched-io") {
+        batched_io = true;
+      } else if (arg == "--records") {
+        records = true;
+      } else if (arg == "--run") {
+        run = true;
+      } else if (arg == "--no-superinstructions") {
+        fused = false;
+      } else if (arg == "--load-binary") {
+        load_binary = true;
+      } else if (arg == "--queue-capacity" && index + 1 < argc) {
+        queue_capacity = parse_count(arg, argv[++index]);
+      } else if (arg == "--stage-workers" && index + 1 < argc) {
+        stage_workers = parse_stage_workers(arg, argv[++index]);
+      } else if (arg == "--serve" && index + 1 < argc) {
+        socket_path = argv[++index];
+      } else if (arg == "--cache" && index + 1 < argc) {
+        cache_directory = argv[++index];
+      } else if (arg == "--cache-size" && index + 1 < argc) {
+        cache_megabytes = parse_count(arg, argv[++index]);
+      } else if (arg == "--metrics" && index + 1 < argc) {
+        metrics_file = argv[++index];
+      } else if (arg == "--metrics-format" && index + 1 < argc) {
+        metrics_format = argv[++index];
+      } else if (!arg.empty() && arg[0] == '-') {
+        throw invalid_argument("unknown option: " + arg);
+      } else {
+        patterns.push_back(arg);
+      }
+    }
+  } catch (const invalid_argument &e) {
+    cerr << e.what() << endl;
+    cerr << "usage: pl0_compiler [-o directory] [-j n] [options] "
+            "[input...]"
+         << endl;
+    return 1;
+  }
 
-  vector<Token> tokens; // tokens
+  if (!metrics_file.empty() && !metrics::enabled()) {
+    cerr << "metrics are not collected by this build, configure it with "
+            "-DPL0_METRICS=ON"
+         << endl;
+    return 1;
+  }
+  if (metrics_format != "json" && metrics_format != "prometheus") {
+    cerr << "unknown metrics format: " << metrics_format << endl;
+    return 1;
+  }
+  if (batched_io && pipelined) {
+    cerr << "--batched-io cannot be combined with --pipelined" << endl;
+    return 1;
+  }
+  if (records && (batch || batched_io || pipelined)) {
+    cerr << "--records cannot be combined with --batch, --batched-io or "
+            "--pipelined"
+         << endl;
+    return 1;
+  }
+
+  if (run && (batch || batched_io || pipelined || records ||
+              !socket_path.empty() || !cache_directory.empty() ||
+              !metrics_file.empty())) {
+    cerr << "--run cannot be combined with the options of expressions" << endl;
+    return 1;
+  }
+  if (load_binary && (run || !fused || batch || batched_io || pipelined ||
+                      records || !socket_path.empty() ||
+                      !cache_directory.empty() || !metrics_file.empty())) {
+    cerr << "--load-binary cannot be combined with other modes" << endl;
+    return 1;
+  }
 
-  for (size_t count = 1; count <= 10; ++count) {
-    // generate filename and open file
-    string file_name_input =
-            BASE_INPUT_FILENAME_PRE + to_string(count) + BASE_FILENAME_POST;
-    string file_name_output =
-            BASE_OUTPUT_FILENAME_PRE + to_string(count) + BASE_FILENAME_POST;
+  // the cache is shared by all pipelines
+  unique_ptr<compile_cache> compileCache;
+  if (!cache_directory.empty()) {
+    try {
+      compileCache.reset(new compile_cache(
+          cache_directory, static_cast<uint64_t>(cache_megabytes) << 20,
+          options));
+    } catch (const ios_base::failure &e) {
+      cerr << e.what() << endl;
+      return 1;
+    }
+    options.cache = compileCache.get();
+  }
 
-    fin.open(file_name_input);
-    if (!fin.is_open()) {
-      throw ios_base::failure("file " + file_name_input + " open failed");
+  // the pipelines stay warm between requests, until a client stops the
+  // server
+  if (!socket_path.empty()) {
+    try {
+      compile_server compileServer(options, socket_path, thread_count);
+      compileServer.run();
+    } catch (const invalid_argument &e) {
+      cerr << e.what() << endl;
+      return 1;
+    } catch (const ios_base::failure &e) {
+      cerr << e.what() << endl;
+      return 1;
     }
+    return 0;
+  }
 
-    fout.open(file_name_output);
-    if (!fout.is_open()) {
-      throw ios_base::failure("file " + file_name_output + " open failed");
-    }
-
-    // read text and parse it into {Token, Lexeme} pairs
-    lexicalAnalyzer.clear();
-    lexicalAnalyzer.read_text(fin);
-    lexicalAnalyzer.parse_text();
-
-    // judge if the expression is valid
-    slr1.clear();
-    bool is_valid = slr1.parse(lexicalAnalyzer.get_list());
-    if (!is_valid) {
-      fout << file_name_input << " is not valid" << endl;
-      continue;
-    }
-
-    // transform {Token, Lexem} into {Lexem}
-    tokens.clear();
-    transform(lexicalAnalyzer.get_list().begin(),
-              lexicalAnalyzer.get_list().end(), back_inserter(tokens),
-              [](const lexical_pair &pair) -> Token { return pair.second; });
-
-    // construct semantic tree
-    semanticAnalyzer.clear();
-    semanticAnalyzer.construct_tree(tokens);
-
-    // transform semantic tree into quadruple
-    intermediateCodeGenerator.clear();
-    intermediateCodeGenerator.generate_quadruples(semanticAnalyzer.get_root());
-
-    // optimize quadruple with DAG
-    dagOptimizer.clear();
-    dagOptimizer.read_origin_nodes(intermediateCodeGenerator.get_quadruples());
-    dagOptimizer.optimize_quadruples();
-
-    fout << "Read expression: " << lexicalAnalyzer.get_expression() << endl;
-    fout << delimiter_line << endl;
-    fout << "Tokens: " << endl;
-    for (const auto &token: lexicalAnalyzer.get_list()) {
-      fout << "( " << token.first << ", " << token.second << " )" << endl;
-    }
-    fout << delimiter_line << endl;
-    fout << "Parsed quadruples: " << endl;
-    for (const auto &quad: intermediateCodeGenerator.get_quadruples()) {
-      fout << "( " << (quad.op == '=' ? ":=" : string(1, quad.op)) << ", "
-           << intermediate_code_generator::quadruple::item2str(quad.operand1)
-           << ", "
-           << intermediate_code_generator::quadruple::item2str(quad.operand2)
-           << ", "
-           << intermediate_code_generator::quadruple::item2str(quad.count)
-           << " )" << endl;
-    }
-    fout << delimiter_line << endl;
-    fout << "Optimized quadruples: " << endl;
-    for (auto &quad: dagOptimizer.get_optimized()) {
-      fout << "( " << (quad.op == '=' ? ":=" : string(1, quad.op)) << ", "
-           << intermediate_code_generator::quadruple::item2str(quad.operand1)
-           << ", "
-           << intermediate_code_generator::quadruple::item2str(quad.operand2)
-           << ", "
-           << intermediate_code_generator::quadruple::item2str(quad.count)
-           << " )" << endl;
-    }
-    fout << delimiter_line << endl;
-    fout << "Expression result: " << semanticAnalyzer.evaluate() << endl;
-
-    tokens.clear();
-    fout.close();
-    fin.close();
+  if (patterns.empty() && load_binary) {
+    char last = output_directory.empty() ? '/' : output_directory.back();
+    patterns.push_back(output_directory +
+                       (last == '/' || last == '\\' ? "" : "/") + "*.qir");
+  } else if (patterns.empty() && run) {
+    for (size_t count = 1; count <= 2; ++count) {
+      patterns.push_back(BASE_PROGRAM_FILENAME_PRE + to_string(count) +
+                         BASE_FILENAME_POST);
+    }
+  } else if (patterns.empty()) {
+    for (size_t count = 1; count <= 10; ++count) {
+      patterns.push_back(BASE_INPUT_FILENAME_PRE + to_string(count) +
+                         BASE_FILENAME_POST);
+    }
+  }
+  vector<string> inputs = compiler_pipeline::expand_paths(patterns);
+
+  // every output file is named after its input, they must not collide
+  vector<string> stems;
+  set<string> used_stems;
+  for (const string &input : inputs) {
+    stems.push_back(compiler_pipeline::output_stem(output_directory, input));
+    if (!used_stems.insert(stems.back()).second) {
+      cerr << "duplicate output: " << stems.back() << BASE_FILENAME_POST
+           << endl;
+      return 1;
+    }
+  }
+  if (batch && batch_output.empty()) {
+    batch_output =
+        compiler_pipeline::output_stem(output_directory, "output_batch") +
+        BASE_FILENAME_POST;
   }
+  for (size_t index = 0; batch && index < stems.size(); ++index) {
+    if (stems[index] + BASE_FILENAME_POST == batch_output) {
+      cerr << "the batch output " << batch_output << " is the output of "
+           << inputs[index] << ", choose another one with --batch-output"
+           << endl;
+      return 1;
+    }
+  }
+
+  // the programs share the standard input and output, so they run one
+  // after another
+  if (run) {
+    return run_programs(inputs, stems, fused);
+  }
+  if (load_binary) {
+    return load_binaries(inputs, stems);
+  }
+
+  vector<compile_result> results;
+  metrics runMetrics; // merged metrics of all pipelines
+  try {
+    if (pipelined) {
+      // the stages hand the files to each other over lock-free queues
+      pipelined_compiler pipelinedCompiler(options, queue_capacity,
+                                           stage_workers);
+      results = pipelinedCompiler.run(inputs, stems);
+      pipelinedCompiler.print_utilization(cout);
+      runMetrics = pipelinedCompiler.get_metrics();
+    } else {
+      // one pipeline per worker, and one for the main thread which helps
+      // while it waits
+      thread_pool pool(thread_count);
+      vector<unique_ptr<compiler_pipeline>> pipelines;
+      for (size_t index = 0; index <= pool.size(); ++index) {
+        pipelines.emplace_back(new compiler_pipeline(options));
+      }
+
+      // compile concurrently, the results are kept in input order
+      results.resize(inputs.size());
+      if (records) {
+        // the records of a file are compiled concurrently, the files one
+        // after another
+        for (size_t index = 0; index < inputs.size(); ++index) {
+          results[index] =
+              compile_records(pool, pipelines, inputs[index], stems[index]);
+        }
+      } else if (batched_io) {
+        compile_batched(pool, pipelines, inputs, stems, results);
+      } else {
+        task_group group(pool);
+        for (size_t index = 0; index < inputs.size(); ++index) {
+          group.run([&, index]() {
+            compiler_pipeline &pipeline = *pipelines[pool.worker_index()];
+            results[index] =
+                pipeline.compile(inputs[index], stems[index],
+                                 "pl0_expression" + to_string(index + 1));
+          });
+        }
+        group.wait();
+      }
+      for (const auto &pipeline : pipelines) {
+        runMetrics.merge(pipeline->get_metrics());
+      }
+    }
+  } catch (const invalid_argument &e) {
+    cerr << e.what() << endl;
+    return 1;
+  } catch (const ios_base::failure &e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  int status = 0;
+  for (const compile_result &result : results) {
+    cout << result.statistics;
+    if (!result.error.empty()) {
+      cerr << result.error << endl;
+      status = 1;
+    }
+  }
+  if (compileCache) {
+    compileCache->print_statistics(cout);
+  }
+
+  if (!metrics_file.empty()) {
+    ofstream metricsFile;
+    if (metrics_file != "-") {
+      metricsFile.open(metrics_file);
+      if (!metricsFile.is_open()) {
+        cerr << "file " << metrics_file << " open failed" << endl;
+        return 1;
+      }
+    }
+    ostream &metricsOut = metrics_file == "-" ? cout : metricsFile;
+    if (metrics_format == "json") {
+      runMetrics.print_json(metricsOut);
+    } else {
+      runMetrics.print_prometheus(metricsOut);
+    }
+  }
+
+  // value numbers of the batch are shared by all files, the prelude is run
+  // once and keeps its tmps, then every file runs its own quadruples against
+  // them; a file whose quadruples do not evaluate to its result is an error
+  if (batch) {
+    DAG_optimizer batchOptimizer;
+    quadruple_interpreter quadrupleInterpreter;
+    vector<size_t> batch_files; // files added to the batch
+
+    batchOptimizer.begin_batch();
+    for (size_t index = 0; index < results.size(); ++index) {
+      if (results[index].valid) {
+        batchOptimizer.add_to_batch(results[index].quadruples);
+        batch_files.push_back(index);
+      }
+    }
+    batchOptimizer.finish_batch();
+    const vector<quadruple> &prelude = batchOptimizer.get_batch_prelude();
+
+    bool prelude_run = true;
+    try {
+      quadrupleInterpreter.execute_prelude(prelude);
+    } catch (const exception &e) {
+      cerr << "batch prelude: " << e.what() << endl;
+      prelude_run = false;
+      status = 1;
+    }
+
+    output_buffer batchOutput;
+
+    size_t total = prelude.size();
+    batchOutput << "Shared quadruples: \n";
+    compiler_pipeline::print_quadruples(batchOutput, prelude);
+    for (size_t index = 0; index < batchOptimizer.get_batch_size(); ++index) {
+      const vector<quadruple> &quads = batchOptimizer.get_batch_expression(index);
+      const string &file_name_input = inputs[batch_files[index]];
+      int result = results[batch_files[index]].value;
+
+      if (prelude_run) {
+        try {
+          int executed = quadrupleInterpreter.execute_continued(quads);
+          if (executed != result) {
+            cerr << file_name_input << ": batch quadruples evaluate to "
+                 << executed << " instead of " << result << endl;
+            status = 1;
+          }
+        } catch (const exception &e) {
+          cerr << file_name_input << ": batch quadruples: " << e.what()
+               << endl;
+          status = 1;
+        }
+      }
+
+      batchOutput << delimiter_line << '\n';
+      batchOutput << file_name_input << ": \n";
+      compiler_pipeline::print_quadruples(batchOutput, quads);
+      batchOutput << "Expression result: " << result << '\n';
+      total += quads.size();
+    }
+    batchOutput << delimiter_line << '\n';
+    batchOutput << "Total quadruples: " << total << '\n';
+    batchOutput << "Eliminated common subexpressions: "
+                << batchOptimizer.get_eliminated_count() << '\n';
+    batchOutput.write_file(batch_output);
+  }
+
+  return status;
 #else
   for (const auto& p : regstrs) {
     cout << p.first << ":\n" << p.second << endl;
@@ -0,0 +1,110 @@
+#include "metrics.h"
+
+#include <ios>
+#include <iomanip>
+
+const size_t metrics::max_timers;
+
+void metrics::merge(const metrics &other) {
+  for (int counter = 0; counter < metric_counter_size; ++counter) {
+    _counters[counter] += other._counters[counter];
+  }
+  for (size_t timer = 0; timer < max_timers; ++timer) {
+    if (other._timer_names[timer] != nullptr) {
+      _timer_names[timer] = other._timer_names[timer];
+    }
+    _seconds[timer] += other._seconds[timer];
+    _calls[timer] += other._calls[timer];
+  }
+}
+
+void metrics::clear() {
+  for (int counter = 0; counter < metric_counter_size; ++counter) {
+    _counters[counter] = 0;
+  }
+  for (size_t timer = 0; timer < max_timers; ++timer) {
+    _timer_names[timer] = nullptr;
+    _seconds[timer] = 0;
+    _calls[timer] = 0;
+  }
+}
+
+void metrics::print_json(ostream &out) const {
+  std::ios_base::fmtflags flags = out.flags();
+  out << std::fixed << std::setprecision(9);
+
+  out << "{\n  \"stages\": {";
+  const char *separator = "\n";
+  for (size_t timer = 0; timer < max_timers; ++timer) {
+    if (_timer_names[timer] == nullptr) {
+      continue;
+    }
+    out << separator << "    \"" << _timer_names[timer]
+        << "\": {\"seconds\": " << _seconds[timer]
+        << ", \"calls\": " << _calls[timer] << "}";
+    separator = ",\n";
+  }
+  out << "\n  },\n  \"counters\": {";
+  separator = "\n";
+  for (int counter = 0; counter < metric_counter_size; ++counter) {
+    out << separator << "    \""
+        << counter_name(static_cast<metric_counter>(counter))
+        << "\": " << _counters[counter];
+    separator = ",\n";
+  }
+  out << "\n  }\n}\n";
+
+  out.flags(flags);
+}
+
+void metrics::print_prometheus(ostream &out) const {
+  std::ios_base::fmtflags flags = out.flags();
+  out << std::fixed << std::setprecision(9);
+
+  out << "# HELP pl0_stage_seconds_total Time spent in a compiler stage.\n"
+      << "# TYPE pl0_stage_seconds_total counter\n";
+  for (size_t timer = 0; timer < max_timers; ++timer) {
+    if (_timer_names[timer] != nullptr) {
+      out << "pl0_stage_seconds_total{stage=\"" << _timer_names[timer]
+          << "\"} " << _seconds[timer] << '\n';
+    }
+  }
+  out << "# HELP pl0_stage_calls_total Files run through a compiler stage.\n"
+      << "# TYPE pl0_stage_calls_total counter\n";
+  for (size_t timer = 0; timer < max_timers; ++timer) {
+    if (_timer_names[timer] != nullptr) {
+      out << "pl0_stage_calls_total{stage=\"" << _timer_names[timer] << "\"} "
+          << _calls[timer] << '\n';
+    }
+  }
+  for (int counter = 0; counter < metric_counter_size; ++counter) {
+    const char *name = counter_name(static_cast<metric_counter>(counter));
+    out << "# TYPE pl0_" << name << "_total counter\n"
+        << "pl0_" << name << "_total " << _counters[counter] << '\n';
+  }
+
+  out.flags(flags);
+}
+
+const char *metrics::counter_name(metric_counter counter) {
+  static const char *const names[metric_counter_size] = {
+      "files",
+      "tokens",
+      "regex_passes",
+      "slr_shifts",
+      "slr_reductions",
+      "ast_nodes",
+      "quadruples_parsed",
+      "quadruples_optimized",
+      "bytes_read",
+      "bytes_written"};
+  return counter < metric_counter_size ? names[counter] : "unknown";
+}
+
+bool metrics::enabled() {
+#ifdef PL0_METRICS
+  return true;
+#else
+  return false;
+#endif
+}
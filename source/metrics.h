@@ -0,0 +1,130 @@
+/**
+ * @file metrics.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Counters and timers of the compiler stages
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_METRICS_H
+#define LIB_7CXX_METRICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+using std::ostream;
+using std::size_t;
+using std::uint64_t;
+
+/**
+ * `PL0_METRIC(statement)` runs the statement only in builds with the CMake
+ * option PL0_METRICS, otherwise the statement is not compiled at all.
+ */
+#ifdef PL0_METRICS
+#define PL0_METRIC(statement) statement
+#else
+#define PL0_METRIC(statement)
+#endif
+
+/**
+ * @brief The counted events
+ */
+enum metric_counter {
+  metric_files,                // Compiled files
+  metric_tokens,               // Tokens produced by the lexer
+  metric_regex_passes,         // Regex searches run by the lexer
+  metric_shifts,               // Shifts of the SLR(1) parser
+  metric_reductions,           // Reductions of the SLR(1) parser
+  metric_ast_nodes,            // Nodes of the semantic trees
+  metric_quadruples_parsed,    // Quadruples generated
+  metric_quadruples_optimized, // Quadruples left after the passes
+  metric_bytes_read,           // Bytes of input files
+  metric_bytes_written,        // Bytes of output files
+  metric_counter_size          // The size of this enum
+};
+
+/**
+ * @brief Counters and timers of one pipeline. Pipelines share nothing, so
+ * every pipeline counts on its own without atomics, and the metrics of a run
+ * are the merged metrics of its pipelines.
+ */
+class metrics {
+public:
+  /**
+   * @brief The largest number of timers
+   */
+  static const size_t max_timers = 8;
+
+  /**
+   * @brief Add to a counter
+   * @param counter The counter
+   * @param count The amount
+   */
+  inline void add(metric_counter counter, uint64_t count) {
+    _counters[counter] += count;
+  }
+
+  /**
+   * @brief Add a measured interval to a timer
+   * @param timer The index of the timer
+   * @param name The name of the timer, a string literal
+   * @param seconds The interval
+   */
+  inline void add_time(size_t timer, const char *name, double seconds) {
+    _timer_names[timer] = name;
+    _seconds[timer] += seconds;
+    ++_calls[timer];
+  }
+
+  /**
+   * @brief Get a counter
+   * @param counter The counter
+   * @return The count
+   */
+  inline uint64_t get(metric_counter counter) const {
+    return _counters[counter];
+  }
+
+  /**
+   * @brief Add all counters and timers of other metrics
+   * @param other The metrics
+   */
+  void merge(const metrics &other);
+
+  /**
+   * @brief Reset all counters and timers
+   */
+  void clear();
+
+  /**
+   * @brief Print the metrics as a JSON object
+   * @param out The output stream
+   */
+  void print_json(ostream &out) const;
+
+  /**
+   * @brief Print the metrics in the Prometheus text exposition format
+   * @param out The output stream
+   */
+  void print_prometheus(ostream &out) const;
+
+  /**
+   * @brief Get the name of a counter
+   * @param counter The counter
+   * @return The name
+   */
+  static const char *counter_name(metric_counter counter);
+
+  /**
+   * @brief Check if metrics are compiled in
+   * @return true The build collects metrics
+   */
+  static bool enabled();
+
+private:
+  uint64_t _counters[metric_counter_size] = {}; // Counters
+  const char *_timer_names[max_timers] = {};    // Names, null if unused
+  double _seconds[max_timers] = {};             // Seconds of every timer
+  uint64_t _calls[max_timers] = {};             // Intervals of every timer
+};
+
+#endif // LIB_7CXX_METRICS_H
@@ -0,0 +1,63 @@
+#include "node_pool.h"
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// blocks are aligned like anything `operator new` returns
+static const size_t block_alignment = alignof(std::max_align_t);
+
+// blocks of the first chunk, every later chunk doubles
+static const size_t first_chunk_blocks = 64;
+
+void *node_pool::allocate(size_t size) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_block_size == 0) {
+    size_t block_size = size < sizeof(free_block) ? sizeof(free_block) : size;
+    _block_size = (block_size + block_alignment - 1) / block_alignment *
+                  block_alignment;
+  }
+  if (size > _block_size) {
+    return ::operator new(size);
+  }
+
+  if (_free == nullptr) {
+    grow();
+  }
+  free_block *block = _free;
+  _free = block->next;
+  return block;
+}
+
+void node_pool::deallocate(void *block, size_t size) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (size > _block_size) {
+    ::operator delete(block);
+    return;
+  }
+
+  free_block *freed = static_cast<free_block *>(block);
+  freed->next = _free;
+  _free = freed;
+}
+
+size_t node_pool::get_block_count() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _block_count;
+}
+
+void node_pool::grow() {
+  size_t blocks = _block_count == 0 ? first_chunk_blocks : _block_count;
+  unique_ptr<char[]> memory(new char[blocks * _block_size]);
+  _chunks.push_back(std::move(memory));
+  char *chunk = _chunks.back().get();
+
+  // the blocks are linked from the last one, so they are handed out in order
+  for (size_t index = blocks; index-- > 0;) {
+    free_block *block =
+        reinterpret_cast<free_block *>(chunk + index * _block_size);
+    block->next = _free;
+    _free = block;
+  }
+  _block_count += blocks;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file node_pool.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Free list of equally sized blocks for the nodes of semantic trees
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_NODE_POOL_H
+#define LIB_7CXX_NODE_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+using std::shared_ptr;
+using std::size_t;
+using std::unique_ptr;
+using std::vector;
+
+/**
+ * @brief Blocks of one size, carved from chunks which are kept until the pool
+ * is destroyed. A freed block goes onto a free list and is handed out again,
+ * so once the pool has grown to the largest tree, building and releasing
+ * trees never reaches the heap.
+ *
+ * The block size is taken from the first allocation; a request for more is
+ * passed on to `operator new`. A tree may be released by another thread than
+ * the one which built it, so the free list is guarded by a mutex.
+ */
+class node_pool {
+public:
+  node_pool() = default;
+
+  node_pool(const node_pool &) = delete;
+
+  /**
+   * @brief Allocate a block
+   * @param size The size wanted
+   * @return The block
+   * @throw std::bad_alloc Out of memory
+   */
+  void *allocate(size_t size);
+
+  /**
+   * @brief Free a block
+   * @param block The block
+   * @param size The size it was allocated with
+   */
+  void deallocate(void *block, size_t size);
+
+  /**
+   * @brief Get the number of blocks carved so far
+   * @return The number of blocks, free or in use
+   */
+  size_t get_block_count();
+
+private:
+  /**
+   * @brief A free block, linked to the next free one
+   */
+  struct free_block {
+    free_block *next; // The next free block
+  };
+
+  /**
+   * @brief Carve a new chunk into free blocks, each chunk is twice the
+   * previous one
+   */
+  void grow();
+
+private:
+  std::mutex _mutex;                  // Guards everything below
+  size_t _block_size = 0;             // Size of a block, 0 before the first
+  free_block *_free = nullptr;        // Free list
+  vector<unique_ptr<char[]>> _chunks; // Carved chunks
+  size_t _block_count = 0;            // Blocks in all chunks
+};
+
+/**
+ * @brief A standard allocator drawing single objects from a `node_pool`,
+ * for `std::allocate_shared`. Copies share the pool and keep it alive, so a
+ * node may outlive whoever created the pool.
+ *
+ * @tparam T The type of the objects
+ */
+template <typename T> class node_allocator {
+public:
+  typedef T value_type;
+
+  /**
+   * @brief Construct an allocator on a pool
+   * @param pool The pool
+   */
+  explicit node_allocator(const shared_ptr<node_pool> &pool) : _pool(pool) {}
+
+  /**
+   * @brief Construct an allocator for another type on the same pool
+   * @param other The other allocator
+   */
+  template <typename U>
+  node_allocator(const node_allocator<U> &other) : _pool(other.get_pool()) {}
+
+  /**
+   * @brief Allocate objects
+   * @param count The number of objects
+   * @return The memory
+   */
+  inline T *allocate(size_t count) {
+    return static_cast<T *>(_pool->allocate(count * sizeof(T)));
+  }
+
+  /**
+   * @brief Free objects
+   * @param objects The memory
+   * @param count The number of objects
+   */
+  inline void deallocate(T *objects, size_t count) {
+    _pool->deallocate(objects, count * sizeof(T));
+  }
+
+  /**
+   * @brief Get the pool
+   * @return The pool
+   */
+  inline const shared_ptr<node_pool> &get_pool() const { return _pool; }
+
+private:
+  shared_ptr<node_pool> _pool; // The pool
+};
+
+template <typename T, typename U>
+inline bool operator==(const node_allocator<T> &a,
+                       const node_allocator<U> &b) {
+  return a.get_pool() == b.get_pool();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const node_allocator<T> &a,
+                       const node_allocator<U> &b) {
+  return !(a == b);
+}
+
+#endif // LIB_7CXX_NODE_POOL_H
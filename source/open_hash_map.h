@@ -0,0 +1,204 @@
+/**
+ * @file open_hash_map.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Open addressing hash map which keeps its memory between uses
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_OPEN_HASH_MAP_H
+#define LIB_7CXX_OPEN_HASH_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+using std::size_t;
+using std::uint64_t;
+using std::vector;
+
+/**
+ * @brief A hash map with linear probing in one flat array of slots.
+ *
+ * Passes fill a map for every expression and clear it afterwards, and a
+ * `std::unordered_map` allocates a node for every insertion and frees it on
+ * `clear`. Here the slots are allocated only when the map grows; `clear`
+ * keeps them and is O(1): every slot carries the generation it was filled
+ * in, and clearing starts a new generation, so the slots of the old one read
+ * as empty. Elements cannot be erased one by one.
+ *
+ * @tparam Key The type of the keys, default constructible and copyable
+ * @tparam Value The type of the values, default constructible and copyable
+ * @tparam Hash The hash function of the keys
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class open_hash_map {
+public:
+  /**
+   * @brief Find the value of a key
+   * @param key The key
+   * @return The value, or null if the key is not in the map
+   */
+  inline Value *find(const Key &key) {
+    if (_size == 0) {
+      return nullptr;
+    }
+    slot &found = _slots[probe(key)];
+    return found.generation == _generation ? &found.value : nullptr;
+  }
+
+  /**
+   * @brief Find the value of a key
+   * @param key The key
+   * @return The value, or null if the key is not in the map
+   */
+  inline const Value *find(const Key &key) const {
+    if (_size == 0) {
+      return nullptr;
+    }
+    const slot &found = _slots[probe(key)];
+    return found.generation == _generation ? &found.value : nullptr;
+  }
+
+  /**
+   * @brief Insert a key unless it is in the map already
+   * @param key The key
+   * @param value The value
+   * @return true The key is inserted
+   * @return false The key is in the map, its value is kept
+   */
+  inline bool emplace(const Key &key, const Value &value) {
+    slot &found = find_or_insert(key);
+    if (found.generation == _generation) {
+      return false;
+    }
+    fill(found, key, value);
+    return true;
+  }
+
+  /**
+   * @brief Get the value of a key, a default constructed value is inserted if
+   * the key is not in the map
+   * @param key The key
+   * @return The value
+   */
+  inline Value &operator[](const Key &key) {
+    slot &found = find_or_insert(key);
+    if (found.generation != _generation) {
+      fill(found, key, Value());
+    }
+    return found.value;
+  }
+
+  /**
+   * @brief Get the number of keys
+   * @return The number of keys
+   */
+  inline size_t size() const { return _size; }
+
+  /**
+   * @brief Judge if the map is empty
+   * @return true There is no key
+   * @return false There are keys
+   */
+  inline bool empty() const { return _size == 0; }
+
+  /**
+   * @brief Remove all keys, the slots are kept for the next use
+   */
+  inline void clear() {
+    if (_size == 0) {
+      return;
+    }
+    _size = 0;
+    if (++_generation == 0) {
+      // the generations wrapped around, forget all of them at once
+      for (slot &s : _slots) {
+        s.generation = 0;
+      }
+      _generation = 1;
+    }
+  }
+
+private:
+  /**
+   * @brief A slot of the table
+   */
+  struct slot {
+    unsigned int generation = 0; // The generation it was filled in
+    Key key;                     // The key
+    Value value;                 // The value
+  };
+
+  /**
+   * @brief Find the slot of a key, or the empty slot it goes into
+   * @param key The key
+   * @return The index of the slot
+   */
+  inline size_t probe(const Key &key) const {
+    // Fibonacci hashing spreads hashes of consecutive tmps over the table
+    size_t index = static_cast<size_t>(
+        (static_cast<uint64_t>(Hash()(key)) * 0x9e3779b97f4a7c15ull) >>
+        _shift);
+    while (_slots[index].generation == _generation &&
+           !(_slots[index].key == key)) {
+      index = (index + 1) & (_slots.size() - 1);
+    }
+    return index;
+  }
+
+  /**
+   * @brief Find the slot of a key, growing the table first if an insertion
+   * would fill more than half of it
+   * @param key The key
+   * @return The slot, filled in the current generation if the key is found
+   */
+  inline slot &find_or_insert(const Key &key) {
+    if (2 * (_size + 1) > _slots.size()) {
+      grow();
+    }
+    return _slots[probe(key)];
+  }
+
+  /**
+   * @brief Fill an empty slot
+   * @param s The slot
+   * @param key The key
+   * @param value The value
+   */
+  inline void fill(slot &s, const Key &key, const Value &value) {
+    s.generation = _generation;
+    s.key = key;
+    s.value = value;
+    ++_size;
+  }
+
+  /**
+   * @brief Double the table and insert the keys again
+   */
+  void grow() {
+    vector<slot> old;
+    old.swap(_slots);
+    unsigned int old_generation = _generation;
+
+    _slots.resize(old.empty() ? 16 : 2 * old.size());
+    _shift = 64;
+    for (size_t size = _slots.size(); size > 1; size >>= 1) {
+      --_shift;
+    }
+    _generation = 1;
+    _size = 0;
+    for (const slot &s : old) {
+      if (s.generation == old_generation) {
+        fill(_slots[probe(s.key)], s.key, s.value);
+      }
+    }
+  }
+
+private:
+  vector<slot> _slots;          // The table, its size is a power of two
+  unsigned int _generation = 1; // Slots of other generations are empty
+  size_t _size = 0;             // The number of keys
+  unsigned int _shift = 64;     // Shift taking a hash to an index
+};
+
+#endif // LIB_7CXX_OPEN_HASH_MAP_H
@@ -0,0 +1,116 @@
+#include "output_buffer.h"
+
+#include <cerrno>
+#include <fstream>
+#include <ios>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using std::ios_base;
+using std::ofstream;
+
+output_buffer &output_buffer::operator<<(int value) {
+  // the magnitude of INT_MIN does not fit in an int
+  return value < 0
+             ? append_integer(0ULL - static_cast<unsigned long long>(value),
+                              true)
+             : append_integer(static_cast<unsigned long long>(value), false);
+}
+
+output_buffer &output_buffer::operator<<(unsigned int value) {
+  return append_integer(value, false);
+}
+
+output_buffer &output_buffer::operator<<(unsigned long value) {
+  return append_integer(value, false);
+}
+
+output_buffer &output_buffer::operator<<(unsigned long long value) {
+  return append_integer(value, false);
+}
+
+output_buffer &output_buffer::operator<<(const quadruple::item &item) {
+  switch (item.first) {
+  case quadruple::number:
+    return *this << item.second;
+  case quadruple::T:
+  case quadruple::optimized:
+    return *this << 'T' << item.second;
+  case quadruple::empty:
+  default:
+    return *this;
+  }
+}
+
+output_buffer &output_buffer::operator<<(const quadruple &quad) {
+  *this << "( ";
+  switch (quad.op) {
+  case '=':
+    *this << ":=";
+    break;
+  case quadruple::shift_left:
+    *this << "<<";
+    break;
+  default:
+    *this << quad.op;
+  }
+  return *this << ", " << quad.operand1 << ", " << quad.operand2 << ", "
+               << quad.count << " )\n";
+}
+
+output_buffer &output_buffer::append_integer(unsigned long long value,
+                                             bool negative) {
+  // digits are produced from the lowest one, at the end of the array
+  char digits[24];
+  char *first = digits + sizeof(digits);
+  do {
+    *--first = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  if (negative) {
+    *--first = '-';
+  }
+  return append(first, static_cast<size_t>(digits + sizeof(digits) - first));
+}
+
+void output_buffer::write_file(const string &file_name) const {
+#ifdef __unix__
+  int fd = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw ios_base::failure("file " + file_name + " open failed");
+  }
+
+  // a regular file takes everything at once, loop only for short writes
+  const char *data = _data.data();
+  size_t remaining = _data.size();
+  while (remaining > 0) {
+    ssize_t written = ::write(fd, data, remaining);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ::close(fd);
+      throw ios_base::failure("file " + file_name + " write failed");
+    }
+    data += written;
+    remaining -= static_cast<size_t>(written);
+  }
+
+  if (::close(fd) != 0) {
+    throw ios_base::failure("file " + file_name + " write failed");
+  }
+#else
+  ofstream fout(file_name, ios_base::binary | ios_base::trunc);
+  if (!fout.is_open()) {
+    throw ios_base::failure("file " + file_name + " open failed");
+  }
+  fout.write(_data.data(), static_cast<std::streamsize>(_data.size()));
+  if (!fout) {
+    throw ios_base::failure("file " + file_name + " write failed");
+  }
+#endif
+}
@@ -0,0 +1,152 @@
+/**
+ * @file output_buffer.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Reusable byte buffer for formatting output files
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_OUTPUT_BUFFER_H
+#define LIB_7CXX_OUTPUT_BUFFER_H
+
+#include "intermediate_code_generator.h"
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using quadruple = intermediate_code_generator::quadruple;
+
+using std::size_t;
+using std::string;
+using std::vector;
+
+/**
+ * @brief Format text into a byte buffer and write it to a file at once.
+ *
+ * The buffer keeps its capacity after `clear`, and numbers are converted in
+ * place, so formatting allocates nothing once the buffer has grown to the
+ * size of the largest file. The text is the same as the one written by
+ * `std::ostream`, with `'\n'` in place of `std::endl`.
+ */
+class output_buffer {
+public:
+  /**
+   * @brief Append a string
+   * @param str The string
+   * @return The buffer
+   */
+  inline output_buffer &operator<<(const string &str) {
+    return append(str.data(), str.size());
+  }
+
+  /**
+   * @brief Append a C string
+   * @param str The string
+   * @return The buffer
+   */
+  inline output_buffer &operator<<(const char *str) {
+    return append(str, std::strlen(str));
+  }
+
+  /**
+   * @brief Append a character
+   * @param c The character
+   * @return The buffer
+   */
+  inline output_buffer &operator<<(char c) {
+    _data.push_back(c);
+    return *this;
+  }
+
+  /**
+   * @brief Append a number in decimal
+   * @param value The number
+   * @return The buffer
+   */
+  output_buffer &operator<<(int value);
+
+  /**
+   * @brief Append a number in decimal
+   * @param value The number
+   * @return The buffer
+   */
+  output_buffer &operator<<(unsigned int value);
+
+  /**
+   * @brief Append a number in decimal
+   * @param value The number
+   * @return The buffer
+   */
+  output_buffer &operator<<(unsigned long value);
+
+  /**
+   * @brief Append a number in decimal
+   * @param value The number
+   * @return The buffer
+   */
+  output_buffer &operator<<(unsigned long long value);
+
+  /**
+   * @brief Append an item the same way as `quadruple::item2str`
+   * @param item The item
+   * @return The buffer
+   */
+  output_buffer &operator<<(const quadruple::item &item);
+
+  /**
+   * @brief Append a quadruple as a line `( op, a, b, T )`
+   * @param quad The quadruple
+   * @return The buffer
+   */
+  output_buffer &operator<<(const quadruple &quad);
+
+  /**
+   * @brief Append bytes
+   * @param data The bytes
+   * @param size The number of bytes
+   * @return The buffer
+   */
+  inline output_buffer &append(const char *data, size_t size) {
+    _data.insert(_data.end(), data, data + size);
+    return *this;
+  }
+
+  /**
+   * @brief Write the buffer into a file, replacing its content, with a single
+   * `write` where possible
+   * @param file_name The name of the file
+   * @throw std::ios_base::failure The file cannot be written
+   */
+  void write_file(const string &file_name) const;
+
+  /**
+   * @brief Get the formatted bytes
+   * @return The first byte
+   */
+  inline const char *data() const { return _data.data(); }
+
+  /**
+   * @brief Get the number of formatted bytes
+   * @return The number of bytes
+   */
+  inline size_t size() const { return _data.size(); }
+
+  /**
+   * @brief Clear the buffer, the capacity is kept
+   */
+  inline void clear() { _data.clear(); }
+
+private:
+  /**
+   * @brief Append the decimal digits of a number
+   * @param value The magnitude of the number
+   * @param negative Whether a minus sign goes first
+   * @return The buffer
+   */
+  output_buffer &append_integer(unsigned long long value, bool negative);
+
+private:
+  vector<char> _data; // The formatted bytes
+};
+
+#endif // LIB_7CXX_OUTPUT_BUFFER_H
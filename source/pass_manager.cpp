@@ -0,0 +1,160 @@
+#include "pass_manager.h"
+#include "DAG_optimizer.h"
+
+#include <chrono>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::logic_error;
+using std::setw;
+using std::to_string;
+
+void pass_manager::add_pass(const string &name, pass_function pass,
+                            bool enabled) {
+  for (const auto &p : _passes) {
+    if (p.name == name) {
+      throw logic_error("Duplicated pass: " + name);
+    }
+  }
+  _passes.push_back({name, std::move(pass), enabled});
+}
+
+bool pass_manager::set_enabled(const string &name, bool enabled) {
+  for (auto &p : _passes) {
+    if (p.name == name) {
+      p.enabled = enabled;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Describe where a malformed quadruple is, only built for the message
+ * @param index The index of the quadruple
+ * @param stage The stage that produced it
+ * @return The description
+ */
+static string location(size_t index, const string &stage) {
+  return "quadruple " + to_string(index + 1) + " after " + stage;
+}
+
+void pass_manager::run(vector<quadruple> &quads) {
+  if (_verify) {
+    verify(quads, "input");
+  }
+
+  // the entries of the last run are overwritten, their names keep their
+  // capacity
+  size_t count = 0;
+  for (const auto &p : _passes) {
+    if (!p.enabled) {
+      continue;
+    }
+
+    if (count == _statistics.size()) {
+      _statistics.emplace_back();
+    }
+    pass_statistics &statistics = _statistics[count++];
+    statistics.name = p.name;
+    statistics.quadruples_in = quads.size();
+    statistics.temps_in = count_temps(quads);
+
+    auto start = std::chrono::steady_clock::now();
+    p.function(quads);
+    auto end = std::chrono::steady_clock::now();
+
+    statistics.seconds = std::chrono::duration<double>(end - start).count();
+    statistics.quadruples_out = quads.size();
+    statistics.temps_out = count_temps(quads);
+
+    if (_verify) {
+      verify(quads, p.name);
+    }
+  }
+  _statistics.resize(count);
+}
+
+void pass_manager::print_statistics(ostream &out) const {
+  out << std::left << setw(28) << "pass" << std::right << setw(12) << "time(us)"
+      << setw(10) << "quad-in" << setw(10) << "quad-out" << setw(10)
+      << "tmp-in" << setw(10) << "tmp-out" << '\n';
+  for (const auto &s : _statistics) {
+    out << std::left << setw(28) << s.name << std::right << setw(12)
+        << std::fixed << std::setprecision(1) << s.seconds * 1e6 << setw(10)
+        << s.quadruples_in << setw(10) << s.quadruples_out << setw(10)
+        << s.temps_in << setw(10) << s.temps_out << '\n';
+  }
+}
+
+vector<string> pass_manager::get_pass_names() const {
+  vector<string> names;
+  for (const auto &p : _passes) {
+    names.push_back(p.name);
+  }
+  return names;
+}
+
+void pass_manager::verify(const vector<quadruple> &quads,
+                          const string &stage) {
+  // tmps defined so far, with the index of the defining quadruple
+  _temps.clear();
+
+  for (size_t index = 0; index < quads.size(); ++index) {
+    const quadruple &quad = quads[index];
+
+    // operator and operand shapes
+    bool operand2_empty = quad.operand2.first == quadruple::empty;
+    switch (quad.op) {
+    case '=':
+      if (!operand2_empty) {
+        throw logic_error("Assignment with two operands in " +
+                          location(index, stage));
+      }
+      break;
+    case '+':
+    case '-':
+    case '*':
+    case '/':
+    case quadruple::shift_left:
+      if (operand2_empty || quad.operand1.first == quadruple::empty) {
+        throw logic_error("Missing operand in " + location(index, stage));
+      }
+      break;
+    default:
+      throw logic_error(string("Unknown operator ") + quad.op + " in " +
+                        location(index, stage));
+    }
+
+    // operands must be numbers or defined tmps
+    for (const quadruple::item *operand : {&quad.operand1, &quad.operand2}) {
+      if ((operand->first == quadruple::T ||
+           operand->first == quadruple::optimized) &&
+          _temps.find(*operand) == nullptr) {
+        throw logic_error("Use of undefined " + quadruple::item2str(*operand) +
+                          " in " + location(index, stage));
+      }
+    }
+
+    // results must be fresh tmps
+    if (quad.count.first != quadruple::T &&
+        quad.count.first != quadruple::optimized) {
+      throw logic_error("Result is not a tmp in " + location(index, stage));
+    }
+    if (!_temps.emplace(quad.count, index)) {
+      throw logic_error("Redefinition of " + quadruple::item2str(quad.count) +
+                        " in " + location(index, stage));
+    }
+  }
+}
+
+size_t pass_manager::count_temps(const vector<quadruple> &quads) {
+  _temps.clear();
+  for (size_t index = 0; index < quads.size(); ++index) {
+    _temps.emplace(quads[index].count, index);
+  }
+  return _temps.size();
+}
@@ -0,0 +1,135 @@
+/**
+ * @file pass_manager.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Ordered pipeline of optimization passes over quadruples
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_PASS_MANAGER_H
+#define LIB_7CXX_PASS_MANAGER_H
+
+#include "DAG_optimizer.h"
+#include "intermediate_code_generator.h"
+#include "open_hash_map.h"
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using quadruple = intermediate_code_generator::quadruple;
+
+using std::ostream;
+using std::size_t;
+using std::string;
+using std::vector;
+
+/**
+ * @brief Run a configurable, ordered list of passes over quadruples.
+ *
+ * Every enabled pass is timed and the numbers of quadruples and tmps before
+ * and after it are recorded. If verification is on, the quadruples are
+ * checked after every pass, so a broken pass is reported by its name.
+ */
+class pass_manager {
+public:
+  /**
+   * @brief A pass rewrites the quadruples in place
+   */
+  typedef std::function<void(vector<quadruple> &)> pass_function;
+
+  /**
+   * @brief The statistics of one run of one pass
+   */
+  struct pass_statistics {
+    string name;            // The name of the pass
+    double seconds;         // Wall time
+    size_t quadruples_in;   // Quadruple count before the pass
+    size_t quadruples_out;  // Quadruple count after the pass
+    size_t temps_in;        // Tmp count before the pass
+    size_t temps_out;       // Tmp count after the pass
+  };
+
+public:
+  /**
+   * @brief Append a pass to the pipeline
+   * @param name The unique name of the pass
+   * @param pass The pass
+   * @param enabled Whether the pass runs
+   */
+  void add_pass(const string &name, pass_function pass, bool enabled = true);
+
+  /**
+   * @brief Enable or disable a pass
+   * @param name The name of the pass
+   * @param enabled Whether the pass runs
+   * @return true The pass is found
+   * @return false There is no pass with the name
+   */
+  bool set_enabled(const string &name, bool enabled);
+
+  /**
+   * @brief Turn the verification between passes on or off
+   * @param verify Whether to verify
+   */
+  inline void set_verify(bool verify) { _verify = verify; }
+
+  /**
+   * @brief Run all enabled passes in order
+   * @param quads The quadruples, rewritten in place
+   */
+  void run(vector<quadruple> &quads);
+
+  /**
+   * @brief Get the statistics of the last run
+   * @return One entry per enabled pass, in running order
+   */
+  inline const vector<pass_statistics> &get_statistics() const {
+    return _statistics;
+  }
+
+  /**
+   * @brief Print the statistics of the last run as a table
+   * @param out The output stream
+   */
+  void print_statistics(ostream &out) const;
+
+  /**
+   * @brief Get the names of all passes, in running order
+   * @return The names
+   */
+  vector<string> get_pass_names() const;
+
+  /**
+   * @brief Check that quadruples are well formed: valid operators, tmps as
+   * results, every tmp defined once and before it is used
+   * @param quads The quadruples
+   * @param stage The stage that produced them, used in the error message
+   * @throw std::logic_error The quadruples are malformed
+   */
+  void verify(const vector<quadruple> &quads, const string &stage);
+
+  /**
+   * @brief Count the distinct tmps defined by quadruples
+   * @param quads The quadruples
+   * @return The number of tmps
+   */
+  size_t count_temps(const vector<quadruple> &quads);
+
+private:
+  /**
+   * @brief A pass in the pipeline
+   */
+  struct pass {
+    string name;            // The name of the pass
+    pass_function function; // The pass
+    bool enabled;           // Whether the pass runs
+  };
+
+  vector<pass> _passes;                // The pipeline
+  vector<pass_statistics> _statistics; // The statistics of the last run
+  bool _verify = true;                 // Verify between passes
+  open_hash_map<quadruple::item, size_t> _temps; // Scratch table of tmps
+};
+
+#endif // LIB_7CXX_PASS_MANAGER_H
@@ -0,0 +1,16 @@
+#include "pcode.h"
+
+#include <cstddef>
+
+using std::size_t;
+
+void print_pcode(output_buffer &out, const vector<pcode_instruction> &code) {
+  static const char *const names[pcode_function_size] = {
+      "LIT", "OPR", "LOD", "STO", "CAL", "INT", "JMP", "JPC", "RED", "WRT"};
+
+  for (size_t index = 0; index < code.size(); ++index) {
+    const pcode_instruction &ins = code[index];
+    out << static_cast<unsigned long>(index) << '\t' << names[ins.function]
+        << ' ' << ins.level << ", " << ins.address << '\n';
+  }
+}
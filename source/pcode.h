@@ -0,0 +1,73 @@
+/**
+ * @file pcode.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief The instruction set of the PL/0 stack machine
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_PCODE_H
+#define LIB_7CXX_PCODE_H
+
+#include "output_buffer.h"
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * @brief The function of a p-code instruction
+ */
+enum pcode_function {
+  pcode_lit,          // LIT 0, a: push the number a
+  pcode_opr,          // OPR 0, a: operation a on the top of the stack
+  pcode_lod,          // LOD l, a: push the variable at a, l levels out
+  pcode_sto,          // STO l, a: pop into the variable at a, l levels out
+  pcode_cal,          // CAL l, a: call the procedure at a, l levels out
+  pcode_int,          // INT 0, a: allocate a words for the frame
+  pcode_jmp,          // JMP 0, a: jump to a
+  pcode_jpc,          // JPC 0, a: pop, and jump to a if it is 0
+  pcode_red,          // RED l, a: read a number into the variable at a
+  pcode_wrt,          // WRT 0, 0: pop, and write it on a line
+  pcode_function_size // the size of this enum
+};
+
+/**
+ * @brief The operation of an OPR instruction, numbered as by Wirth
+ */
+enum pcode_operation {
+  opr_ret = 0,  // return from the procedure
+  opr_neg = 1,  // negate
+  opr_add = 2,  // add
+  opr_sub = 3,  // subtract
+  opr_mul = 4,  // multiply
+  opr_div = 5,  // divide
+  opr_odd = 6,  // 1 if odd, else 0
+  opr_eql = 8,  // =
+  opr_neq = 9,  // #
+  opr_lss = 10, // <
+  opr_geq = 11, // >=
+  opr_gtr = 12, // >
+  opr_leq = 13  // <=
+};
+
+/**
+ * @brief An instruction of the classic PL/0 stack machine.
+ *
+ * A frame starts with three link words: the static link to the frame of
+ * the enclosing procedure, the dynamic link to the frame of the caller and
+ * the return address. Variables are addressed from the start of the frame,
+ * so the first one is at 3.
+ */
+struct pcode_instruction {
+  pcode_function function; // The function
+  int level;               // The level difference, for LOD, STO, CAL, RED
+  int address;             // The number, operation, address or size
+};
+
+/**
+ * @brief Write p-code as a listing, one numbered instruction per line
+ * @param out The output
+ * @param code The p-code
+ */
+void print_pcode(output_buffer &out, const vector<pcode_instruction> &code);
+
+#endif // LIB_7CXX_PCODE_H
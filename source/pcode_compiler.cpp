@@ -0,0 +1,390 @@
+#include "pcode_compiler.h"
+
+#include <cctype>
+#include <climits>
+
+using std::to_string;
+
+const int pcode_compiler::max_level;
+
+const vector<pcode_instruction> &pcode_compiler::compile(const string &text) {
+  _text = &text;
+  _position = 0;
+  _line = 1;
+  _line_start = 0;
+  _identifiers.clear();
+  _symbols.clear();
+  _code.clear();
+
+  next();
+  block(0, nullptr);
+  expect("period");
+  if (!_token.empty()) {
+    throw error("unexpected \"" + _lexeme + "\" after the end of the program");
+  }
+  return _code;
+}
+
+void pcode_compiler::next() {
+  const string &text = *_text;
+  while (_position < text.size() &&
+         isspace(static_cast<unsigned char>(text[_position]))) {
+    if (text[_position++] == '\n') {
+      ++_line;
+      _line_start = _position;
+    }
+  }
+  _token_line = _line;
+  _token_column = _position - _line_start + 1;
+  if (_position == text.size()) {
+    _token.clear();
+    _lexeme.clear();
+    return;
+  }
+
+  size_t start = _position;
+  unsigned char c = static_cast<unsigned char>(text[_position]);
+  if (isalpha(c)) {
+    while (_position < text.size() &&
+           (isalnum(static_cast<unsigned char>(text[_position])) ||
+            text[_position] == '_')) {
+      ++_position;
+    }
+    _lexeme.assign(text, start, _position - start);
+    auto keyword = reserved.find(_lexeme);
+    if (keyword != reserved.end()) {
+      _token = keyword->second;
+    } else if (_lexeme.size() > 10) {
+      throw error("identifier \"" + _lexeme + "\" is longer than 10 characters");
+    } else {
+      _token = "ident";
+      _identifier = _identifiers.intern(_lexeme);
+    }
+    return;
+  }
+
+  if (isdigit(c)) {
+    long long value = 0;
+    while (_position < text.size() &&
+           isdigit(static_cast<unsigned char>(text[_position]))) {
+      value = 10 * value + (text[_position++] - '0');
+      if (value > INT_MAX) {
+        throw error("number is larger than " + to_string(INT_MAX));
+      }
+    }
+    _lexeme.assign(text, start, _position - start);
+    _token = "number";
+    _number = static_cast<int>(value);
+    return;
+  }
+
+  // two-character operators first, so `<=` is not read as `<`
+  if (_position + 1 < text.size()) {
+    auto op = operators.find(text.substr(_position, 2));
+    if (op != operators.end()) {
+      _position += 2;
+      _lexeme = op->first;
+      _token = op->second;
+      return;
+    }
+  }
+  _lexeme.assign(1, text[_position]);
+  auto op = operators.find(_lexeme);
+  if (op != operators.end()) {
+    ++_position;
+    _token = op->second;
+    return;
+  }
+  auto delimiter = delimiters.find(_lexeme);
+  if (delimiter != delimiters.end()) {
+    ++_position;
+    _token = delimiter->second;
+    return;
+  }
+  throw error("unknown character \"" + _lexeme + "\"");
+}
+
+void pcode_compiler::expect(const Token &token) {
+  if (_token != token) {
+    throw error("expected " + token + " instead of " +
+                (_token.empty() ? string("the end of the program")
+                                : "\"" + _lexeme + "\""));
+  }
+  next();
+}
+
+identifier_id pcode_compiler::expect_identifier() {
+  identifier_id name = _identifier;
+  expect("ident");
+  return name;
+}
+
+void pcode_compiler::block(int level, symbol *owner) {
+  if (level > max_level) {
+    throw error("procedures are nested deeper than " + to_string(max_level) +
+                " levels");
+  }
+  int frame_size = 3; // static link, dynamic link, return address
+
+  // callers of the procedure call the jump over its procedures
+  size_t jump = emit(pcode_jmp, 0, 0);
+  if (owner != nullptr) {
+    owner->value = static_cast<int>(jump);
+  }
+  _symbols.push_scope();
+
+  if (_token == "constsym") {
+    do {
+      next();
+      identifier_id name = expect_identifier();
+      expect("eql");
+      if (_token != "number") {
+        throw error("expected a number for constant \"" +
+                    _identifiers.get_name(name) + "\"");
+      }
+      declare(name, symbol_constant, level, _number);
+      next();
+    } while (_token == "comma");
+    expect("semicolon");
+  }
+
+  if (_token == "varsym") {
+    do {
+      next();
+      if (_token == "ident") {
+        declare(_identifier, symbol_variable, level, frame_size++);
+      }
+      expect("ident");
+    } while (_token == "comma");
+    expect("semicolon");
+  }
+
+  while (_token == "proceduresym") {
+    next();
+    symbol *procedure = nullptr;
+    if (_token == "ident") {
+      procedure = declare(_identifier, symbol_procedure, level, 0);
+    }
+    expect("ident");
+    expect("semicolon");
+    block(level + 1, procedure);
+    expect("semicolon");
+  }
+
+  _code[jump].address = static_cast<int>(_code.size());
+  emit(pcode_int, 0, frame_size);
+  statement(level);
+  emit(pcode_opr, 0, opr_ret);
+
+  _symbols.pop_scope();
+}
+
+void pcode_compiler::statement(int level) {
+  if (_token == "ident") {
+    const symbol &target = lookup();
+    if (target.kind != symbol_variable) {
+      throw error("cannot assign to \"" + _lexeme + "\", it is not a variable");
+    }
+    int difference = level - target.level;
+    int address = target.value;
+    next();
+    expect("becomes");
+    expression(level);
+    emit(pcode_sto, difference, address);
+  } else if (_token == "callsym") {
+    next();
+    if (_token == "ident") {
+      const symbol &callee = lookup();
+      if (callee.kind != symbol_procedure) {
+        throw error("cannot call \"" + _lexeme + "\", it is not a procedure");
+      }
+      emit(pcode_cal, level - callee.level, callee.value);
+    }
+    expect("ident");
+  } else if (_token == "beginsym") {
+    next();
+    statement(level);
+    while (_token == "semicolon") {
+      next();
+      statement(level);
+    }
+    expect("endsym");
+  } else if (_token == "ifsym") {
+    next();
+    condition(level);
+    expect("thensym");
+    size_t branch = emit(pcode_jpc, 0, 0);
+    statement(level);
+    if (_token == "elsesym") {
+      next();
+      size_t jump = emit(pcode_jmp, 0, 0);
+      _code[branch].address = static_cast<int>(_code.size());
+      statement(level);
+      _code[jump].address = static_cast<int>(_code.size());
+    } else {
+      _code[branch].address = static_cast<int>(_code.size());
+    }
+  } else if (_token == "whilesym") {
+    next();
+    size_t start = _code.size();
+    condition(level);
+    expect("dosym");
+    size_t branch = emit(pcode_jpc, 0, 0);
+    statement(level);
+    emit(pcode_jmp, 0, static_cast<int>(start));
+    _code[branch].address = static_cast<int>(_code.size());
+  } else if (_token == "readsym") {
+    next();
+    expect("lparen");
+    for (;;) {
+      if (_token == "ident") {
+        const symbol &target = lookup();
+        if (target.kind != symbol_variable) {
+          throw error("cannot read \"" + _lexeme + "\", it is not a variable");
+        }
+        emit(pcode_red, level - target.level, target.value);
+      }
+      expect("ident");
+      if (_token != "comma") {
+        break;
+      }
+      next();
+    }
+    expect("rparen");
+  } else if (_token == "writesym") {
+    next();
+    expect("lparen");
+    expression(level);
+    emit(pcode_wrt, 0, 0);
+    while (_token == "comma") {
+      next();
+      expression(level);
+      emit(pcode_wrt, 0, 0);
+    }
+    expect("rparen");
+  }
+  // anything else is the empty statement, its follower is checked by the
+  // caller
+}
+
+void pcode_compiler::condition(int level) {
+  if (_token == "oddsym") {
+    next();
+    expression(level);
+    emit(pcode_opr, 0, opr_odd);
+    return;
+  }
+
+  expression(level);
+  pcode_operation relation;
+  if (_token == "eql") {
+    relation = opr_eql;
+  } else if (_token == "neq") {
+    relation = opr_neq;
+  } else if (_token == "lss") {
+    relation = opr_lss;
+  } else if (_token == "geq") {
+    relation = opr_geq;
+  } else if (_token == "gtr") {
+    relation = opr_gtr;
+  } else if (_token == "leq") {
+    relation = opr_leq;
+  } else {
+    throw error("expected a relation instead of " +
+                (_token.empty() ? string("the end of the program")
+                                : "\"" + _lexeme + "\""));
+  }
+  next();
+  expression(level);
+  emit(pcode_opr, 0, relation);
+}
+
+void pcode_compiler::expression(int level) {
+  if (_token == "plus" || _token == "minus") {
+    bool negate = _token == "minus";
+    next();
+    term(level);
+    if (negate) {
+      emit(pcode_opr, 0, opr_neg);
+    }
+  } else {
+    term(level);
+  }
+
+  while (_token == "plus" || _token == "minus") {
+    pcode_operation operation = _token == "plus" ? opr_add : opr_sub;
+    next();
+    term(level);
+    emit(pcode_opr, 0, operation);
+  }
+}
+
+void pcode_compiler::term(int level) {
+  factor(level);
+  while (_token == "times" || _token == "slash") {
+    pcode_operation operation = _token == "times" ? opr_mul : opr_div;
+    next();
+    factor(level);
+    emit(pcode_opr, 0, operation);
+  }
+}
+
+void pcode_compiler::factor(int level) {
+  if (_token == "ident") {
+    const symbol &operand = lookup();
+    switch (operand.kind) {
+    case symbol_constant:
+      emit(pcode_lit, 0, operand.value);
+      break;
+    case symbol_variable:
+      emit(pcode_lod, level - operand.level, operand.value);
+      break;
+    case symbol_procedure:
+    default:
+      throw error("procedure \"" + _lexeme + "\" is not a value");
+    }
+    next();
+  } else if (_token == "number") {
+    emit(pcode_lit, 0, _number);
+    next();
+  } else if (_token == "lparen") {
+    next();
+    expression(level);
+    expect("rparen");
+  } else {
+    throw error("expected a factor instead of " +
+                (_token.empty() ? string("the end of the program")
+                                : "\"" + _lexeme + "\""));
+  }
+}
+
+symbol *pcode_compiler::declare(identifier_id name, symbol_kind kind,
+                                int level, int value) {
+  symbol declared;
+  declared.kind = kind;
+  declared.level = level;
+  declared.value = value;
+  symbol *found = _symbols.declare(name, declared);
+  if (found == nullptr) {
+    throw error("\"" + _identifiers.get_name(name) + "\" is declared twice");
+  }
+  return found;
+}
+
+const symbol &pcode_compiler::lookup() const {
+  const symbol *found = _symbols.lookup(_identifier);
+  if (found == nullptr) {
+    throw error("\"" + _lexeme + "\" is not declared");
+  }
+  return *found;
+}
+
+size_t pcode_compiler::emit(pcode_function function, int level, int address) {
+  _code.push_back({function, level, address});
+  return _code.size() - 1;
+}
+
+invalid_argument pcode_compiler::error(const string &message) const {
+  return invalid_argument("line " + to_string(_token_line) + ", column " +
+                          to_string(_token_column) + ": " + message);
+}
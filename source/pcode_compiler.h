@@ -0,0 +1,182 @@
+/**
+ * @file pcode_compiler.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Compile whole PL/0 programs to p-code
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_PCODE_COMPILER_H
+#define LIB_7CXX_PCODE_COMPILER_H
+
+#include "identifier_interner.h"
+#include "lexemes.h"
+#include "pcode.h"
+#include "symbol_table.h"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::invalid_argument;
+using std::size_t;
+using std::string;
+using std::vector;
+
+/**
+ * @brief A recursive-descent compiler from PL/0 programs to p-code.
+ *
+ * The grammar is the one of `regex_pattern.h`:
+ *
+ *     program    = block "." .
+ *     block      = ["const" ident "=" number {"," ident "=" number} ";"]
+ *                  ["var" ident {"," ident} ";"]
+ *                  {"procedure" ident ";" block ";"} statement .
+ *     statement  = [ident ":=" expression | "call" ident
+ *                  | "begin" statement {";" statement} "end"
+ *                  | "if" condition "then" statement ["else" statement]
+ *                  | "while" condition "do" statement
+ *                  | "read" "(" ident {"," ident} ")"
+ *                  | "write" "(" expression {"," expression} ")"] .
+ *     condition  = "odd" expression | expression relation expression .
+ *
+ * Expressions are those of the expression compiler. Every procedure is a
+ * level deeper than the block it is declared in, and reaches the variables
+ * of the enclosing blocks through static links. The code of a block starts
+ * with a jump over the code of its procedures, which is also the address
+ * its callers call.
+ *
+ * Identifiers are interned as they are scanned, and every block is a scope
+ * of a `symbol_table`, so names are declared and looked up by their ids.
+ */
+class pcode_compiler {
+public:
+  /**
+   * @brief Compile a program
+   * @param text The program
+   * @return The p-code, valid until the next program is compiled
+   * @throw std::invalid_argument The program is not valid, the message
+   * tells the line and the column
+   */
+  const vector<pcode_instruction> &compile(const string &text);
+
+  /**
+   * @brief Get the p-code of the last program
+   * @return The p-code
+   */
+  inline const vector<pcode_instruction> &get_code() const { return _code; }
+
+  /**
+   * @brief The deepest nesting of procedures
+   */
+  static const int max_level = 255;
+
+private:
+  /**
+   * @brief Scan the next token into `_token` and `_lexeme`, and the id of an
+   * identifier into `_identifier`
+   * @throw std::invalid_argument An unknown character or a bad number
+   */
+  void next();
+
+  /**
+   * @brief Consume a token
+   * @param token The expected token
+   * @throw std::invalid_argument The current token is another one
+   */
+  void expect(const Token &token);
+
+  /**
+   * @brief Consume an identifier
+   * @return The id of the identifier
+   * @throw std::invalid_argument The current token is not an identifier
+   */
+  identifier_id expect_identifier();
+
+  /**
+   * @brief Compile a block
+   * @param level The level of the block
+   * @param owner The symbol of the procedure, null for the main program
+   */
+  void block(int level, symbol *owner);
+
+  /**
+   * @brief Compile a statement
+   * @param level The level of the block
+   */
+  void statement(int level);
+
+  /**
+   * @brief Compile a condition, leaving 1 or 0 on the stack
+   * @param level The level of the block
+   */
+  void condition(int level);
+
+  /**
+   * @brief Compile an expression, leaving its value on the stack
+   * @param level The level of the block
+   */
+  void expression(int level);
+
+  /**
+   * @brief Compile a term
+   * @param level The level of the block
+   */
+  void term(int level);
+
+  /**
+   * @brief Compile a factor
+   * @param level The level of the block
+   */
+  void factor(int level);
+
+  /**
+   * @brief Declare a name in the current block
+   * @param name The id of the name
+   * @param kind What it names
+   * @param level The level of the block
+   * @param value The value, the address or the code address
+   * @return The symbol, valid until the next declaration in the block
+   * @throw std::invalid_argument The name is declared twice in the block
+   */
+  symbol *declare(identifier_id name, symbol_kind kind, int level, int value);
+
+  /**
+   * @brief Find the innermost declaration of the current identifier
+   * @return The symbol
+   * @throw std::invalid_argument The name is not declared
+   */
+  const symbol &lookup() const;
+
+  /**
+   * @brief Append an instruction
+   * @param function The function
+   * @param level The level difference
+   * @param address The number, operation, address or size
+   * @return The address of the instruction
+   */
+  size_t emit(pcode_function function, int level, int address);
+
+  /**
+   * @brief Build the exception of an error at the current token
+   * @param message What is wrong
+   * @return The exception
+   */
+  invalid_argument error(const string &message) const;
+
+private:
+  const string *_text = nullptr;    // The program
+  size_t _position = 0;             // The next character
+  size_t _line = 1;                 // The line of the next character
+  size_t _line_start = 0;           // The first character of the line
+  size_t _token_line = 1;           // The line of the current token
+  size_t _token_column = 1;         // The column of the current token
+  Token _token;                     // The current token, empty at the end
+  Lexeme _lexeme;                   // The current lexeme
+  int _number = 0;                  // The value of a number token
+  identifier_id _identifier = 0;    // The id of an identifier token
+  identifier_interner _identifiers; // Identifiers of the program
+  symbol_table _symbols;            // Names visible in the current block
+  vector<pcode_instruction> _code;  // The p-code
+};
+
+#endif // LIB_7CXX_PCODE_COMPILER_H
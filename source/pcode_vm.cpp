@@ -0,0 +1,675 @@
+#include "pcode_vm.h"
+
+#include <climits>
+#include <ios>
+#include <stdexcept>
+#include <string>
+
+using std::domain_error;
+using std::ios_base;
+using std::logic_error;
+using std::runtime_error;
+using std::to_string;
+
+// computed gotos are an extension of GCC, which Clang has too
+#if defined(__GNUC__)
+#define PL0_THREADED_DISPATCH
+#endif
+
+// output is flushed once this many bytes are pending
+static const size_t flush_size = 1 << 16;
+
+static inline int vm_add(int left, int right) {
+  return static_cast<int>(static_cast<unsigned int>(left) +
+                          static_cast<unsigned int>(right));
+}
+
+static inline int vm_sub(int left, int right) {
+  return static_cast<int>(static_cast<unsigned int>(left) -
+                          static_cast<unsigned int>(right));
+}
+
+static inline int vm_mul(int left, int right) {
+  return static_cast<int>(static_cast<unsigned int>(left) *
+                          static_cast<unsigned int>(right));
+}
+
+static inline int vm_div(int left, int right) {
+  if (right == 0) {
+    throw domain_error("Division by zero");
+  }
+  if (left == INT_MIN && right == -1) {
+    return INT_MIN;
+  }
+  return left / right;
+}
+
+/**
+ * @brief Follow static links
+ * @param stack The stack
+ * @param frame The current frame
+ * @param level The level difference
+ * @return The frame `level` levels out
+ */
+static inline int *frame_at(int *stack, int *frame, unsigned int level) {
+  while (level-- > 0) {
+    frame = stack + frame[0];
+  }
+  return frame;
+}
+
+// The arithmetic operations: forms, name, function
+#define PL0_VM_ARITHMETIC(X, F)                                                \
+  X(F, add, vm_add)                                                            \
+  X(F, sub, vm_sub)                                                            \
+  X(F, mul, vm_mul)                                                            \
+  X(F, div, vm_div)
+
+// The relations: forms, name, C++ operator
+#define PL0_VM_RELATIONS(X, F)                                                 \
+  X(F, eql, ==)                                                                \
+  X(F, neq, !=)                                                                \
+  X(F, lss, <)                                                                 \
+  X(F, geq, >=)                                                                \
+  X(F, gtr, >)                                                                 \
+  X(F, leq, <=)
+
+// An arithmetic operation alone, after a load or a number on the stack,
+// after two loads, and all of them followed by a store
+#define PL0_VM_ARITHMETIC_FORMS(F, name, function)                             \
+  F(name) F(lod_##name) F(lit_##name) F(lod_lod_##name) F(lod_lit_##name)      \
+  F(name##_sto) F(lod_lod_##name##_sto) F(lod_lit_##name##_sto)
+
+// A relation alone, followed by a JPC, and after two loads followed by a JPC
+#define PL0_VM_RELATION_FORMS(F, name, op)                                     \
+  F(name) F(name##_jpc) F(lod_lod_##name##_jpc) F(lod_lit_##name##_jpc)
+
+// Every opcode
+#define PL0_VM_OPCODES(F)                                                      \
+  F(halt) F(lit) F(lod) F(sto) F(cal) F(int) F(jmp) F(jpc) F(red) F(wrt)      \
+  F(ret) F(neg) F(odd) F(odd_jpc) F(lit_sto) F(lod_sto)                        \
+  PL0_VM_ARITHMETIC(PL0_VM_ARITHMETIC_FORMS, F)                                \
+  PL0_VM_RELATIONS(PL0_VM_RELATION_FORMS, F)
+
+#define PL0_VM_OPCODE(name) op_##name,
+
+/**
+ * @brief The opcodes of the loaded instructions
+ */
+enum vm_opcode { PL0_VM_OPCODES(PL0_VM_OPCODE) vm_opcode_size };
+
+/**
+ * @brief The opcodes of an arithmetic operation, see
+ * `PL0_VM_ARITHMETIC_FORMS`
+ */
+struct arithmetic_opcodes {
+  int operation;
+  vm_opcode plain, lod, lit, lod_lod, lod_lit, sto, lod_lod_sto, lod_lit_sto;
+};
+
+/**
+ * @brief The opcodes of a relation, see `PL0_VM_RELATION_FORMS`
+ */
+struct relation_opcodes {
+  int operation;
+  vm_opcode plain, jpc, lod_lod_jpc, lod_lit_jpc;
+};
+
+#define PL0_VM_ARITHMETIC_ENTRY(F, name, function)                             \
+  {opr_##name,           op_##name,           op_lod_##name,                   \
+   op_lit_##name,        op_lod_lod_##name,   op_lod_lit_##name,               \
+   op_##name##_sto,      op_lod_lod_##name##_sto,                              \
+   op_lod_lit_##name##_sto},
+
+#define PL0_VM_RELATION_ENTRY(F, name, op)                                     \
+  {opr_##name, op_##name, op_##name##_jpc, op_lod_lod_##name##_jpc,            \
+   op_lod_lit_##name##_jpc},
+
+static const arithmetic_opcodes arithmetic_table[] = {
+    PL0_VM_ARITHMETIC(PL0_VM_ARITHMETIC_ENTRY, _)};
+
+static const relation_opcodes relation_table[] = {
+    PL0_VM_RELATIONS(PL0_VM_RELATION_ENTRY, _)};
+
+/**
+ * @brief Find the opcodes of an arithmetic operation
+ * @param ins A p-code instruction
+ * @return The opcodes, null if it is not an arithmetic OPR
+ */
+static const arithmetic_opcodes *find_arithmetic(const pcode_instruction &ins) {
+  if (ins.function == pcode_opr) {
+    for (const arithmetic_opcodes &opcodes : arithmetic_table) {
+      if (opcodes.operation == ins.address) {
+        return &opcodes;
+      }
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Find the opcodes of a relation
+ * @param ins A p-code instruction
+ * @return The opcodes, null if it is not a relation OPR
+ */
+static const relation_opcodes *find_relation(const pcode_instruction &ins) {
+  if (ins.function == pcode_opr) {
+    for (const relation_opcodes &opcodes : relation_table) {
+      if (opcodes.operation == ins.address) {
+        return &opcodes;
+      }
+    }
+  }
+  return nullptr;
+}
+
+const size_t pcode_vm::default_stack_size;
+
+pcode_vm::pcode_vm(size_t stack_size, bool superinstructions)
+    : _superinstructions(superinstructions),
+      _stack(stack_size < 4 ? 4 : stack_size) {}
+
+void pcode_vm::load(const vector<pcode_instruction> &code) {
+  _instructions.clear();
+  _superinstruction_count = 0;
+  if (code.empty()) {
+    throw logic_error("No p-code to load");
+  }
+
+  // check the p-code, and find how deep the stack of an expression gets
+  const int size = static_cast<int>(code.size());
+  int depth = 0;
+  int max_depth = 0;
+  for (int index = 0; index < size; ++index) {
+    const pcode_instruction &ins = code[index];
+    if (ins.level < 0 || ins.level > UINT16_MAX ||
+        (ins.address < 0 && ins.function != pcode_lit)) {
+      throw logic_error("Bad operand at " + to_string(index));
+    }
+    switch (ins.function) {
+    case pcode_lit:
+    case pcode_lod:
+      ++depth;
+      break;
+    case pcode_sto:
+    case pcode_wrt:
+      --depth;
+      break;
+    case pcode_jmp:
+    case pcode_jpc:
+    case pcode_cal:
+      if (ins.address >= size) {
+        throw logic_error("Jump out of the p-code at " + to_string(index));
+      }
+      depth -= ins.function == pcode_jpc;
+      break;
+    case pcode_int:
+      if (ins.address < 3) {
+        throw logic_error("Frame without links at " + to_string(index));
+      }
+      depth = 0;
+      break;
+    case pcode_opr:
+      if (find_arithmetic(ins) != nullptr || find_relation(ins) != nullptr) {
+        --depth;
+      } else if (ins.address != opr_ret && ins.address != opr_neg &&
+                 ins.address != opr_odd) {
+        throw logic_error("Unknown operation at " + to_string(index));
+      }
+      break;
+    case pcode_red:
+      break;
+    default:
+      throw logic_error("Unknown function at " + to_string(index));
+    }
+    if (depth < 0) {
+      throw logic_error("Pop from an empty stack at " + to_string(index));
+    }
+    max_depth = depth > max_depth ? depth : max_depth;
+  }
+
+  // calls and jumps to a jump go where that jump goes, the bound of the
+  // steps stops at loops of jumps
+  vector<pcode_instruction> threaded(code);
+  for (pcode_instruction &ins : threaded) {
+    if (ins.function == pcode_jmp || ins.function == pcode_jpc ||
+        ins.function == pcode_cal) {
+      for (int step = 0;
+           step < size && code[ins.address].function == pcode_jmp; ++step) {
+        ins.address = code[ins.address].address;
+      }
+    }
+  }
+
+  // a superinstruction must not swallow an instruction which is jumped to
+  // or returned to
+  vector<bool> entries(code.size(), false);
+  entries[0] = true;
+  for (int index = 0; index < size; ++index) {
+    const pcode_instruction &ins = threaded[index];
+    if (ins.function == pcode_jmp || ins.function == pcode_jpc ||
+        ins.function == pcode_cal) {
+      entries[ins.address] = true;
+    }
+    if (ins.function == pcode_cal && index + 1 < size) {
+      entries[index + 1] = true;
+    }
+  }
+
+  vector<int> loaded_at(code.size(), -1);
+  for (size_t index = 0; index < code.size();) {
+    loaded_at[index] = static_cast<int>(_instructions.size());
+    instruction loaded = {};
+    loaded.target = -1;
+    size_t length =
+        _superinstructions ? fuse(threaded, entries, index, loaded) : 0;
+    if (length > 0) {
+      ++_superinstruction_count;
+      _instructions.push_back(loaded);
+      index += length;
+      continue;
+    }
+
+    const pcode_instruction &ins = threaded[index];
+    uint16_t level = static_cast<uint16_t>(ins.level);
+    switch (ins.function) {
+    case pcode_lit:
+      loaded.op = op_lit;
+      loaded.value = ins.address;
+      break;
+    case pcode_lod:
+      loaded.op = op_lod;
+      loaded.level = level;
+      loaded.address = ins.address;
+      break;
+    case pcode_sto:
+      loaded.op = op_sto;
+      loaded.store_level = level;
+      loaded.store_address = ins.address;
+      break;
+    case pcode_cal:
+      loaded.op = op_cal;
+      loaded.level = level;
+      loaded.target = ins.address;
+      break;
+    case pcode_int:
+      // the frame, the deepest expression, and the links of a call
+      loaded.op = op_int;
+      loaded.address = ins.address;
+      loaded.value = ins.address + max_depth + 3;
+      break;
+    case pcode_jmp:
+      loaded.op = op_jmp;
+      loaded.target = ins.address;
+      break;
+    case pcode_jpc:
+      loaded.op = op_jpc;
+      loaded.target = ins.address;
+      break;
+    case pcode_red:
+      loaded.op = op_red;
+      loaded.store_level = level;
+      loaded.store_address = ins.address;
+      break;
+    case pcode_wrt:
+      loaded.op = op_wrt;
+      break;
+    case pcode_opr:
+    default:
+      if (const arithmetic_opcodes *opcodes = find_arithmetic(ins)) {
+        loaded.op = opcodes->plain;
+      } else if (const relation_opcodes *opcodes = find_relation(ins)) {
+        loaded.op = opcodes->plain;
+      } else if (ins.address == opr_ret) {
+        loaded.op = op_ret;
+      } else if (ins.address == opr_neg) {
+        loaded.op = op_neg;
+      } else {
+        loaded.op = op_odd;
+      }
+    }
+    _instructions.push_back(loaded);
+    ++index;
+  }
+
+  instruction halt = {};
+  halt.op = op_halt;
+  halt.target = -1;
+  _instructions.push_back(halt);
+
+  for (instruction &loaded : _instructions) {
+    if (loaded.target >= 0) {
+      loaded.target = loaded_at[loaded.target];
+    }
+  }
+}
+
+size_t pcode_vm::fuse(const vector<pcode_instruction> &code,
+                      const vector<bool> &entries, size_t address,
+                      instruction &fused) {
+  // the instructions after the first one, if nothing jumps to them
+  auto next = [&](size_t offset) -> const pcode_instruction * {
+    size_t index = address + offset;
+    return index < code.size() && !entries[index] ? &code[index] : nullptr;
+  };
+  auto is = [](const pcode_instruction *ins, pcode_function function) {
+    return ins != nullptr && ins->function == function;
+  };
+  auto store = [&fused](const pcode_instruction *ins) {
+    fused.store_level = static_cast<uint16_t>(ins->level);
+    fused.store_address = ins->address;
+  };
+
+  const pcode_instruction &first = code[address];
+  const pcode_instruction *second = next(1);
+  const pcode_instruction *third = next(2);
+  const pcode_instruction *fourth = next(3);
+
+  if (first.function == pcode_lod) {
+    fused.level = static_cast<uint16_t>(first.level);
+    fused.address = first.address;
+
+    // LOD LOD OPR [STO|JPC] and LOD LIT OPR [STO|JPC]
+    if ((is(second, pcode_lod) || is(second, pcode_lit)) && third != nullptr) {
+      bool load = second->function == pcode_lod;
+      if (load) {
+        fused.level2 = static_cast<uint16_t>(second->level);
+        fused.address2 = second->address;
+      } else {
+        fused.value = second->address;
+      }
+      if (const arithmetic_opcodes *opcodes = find_arithmetic(*third)) {
+        if (is(fourth, pcode_sto)) {
+          fused.op = load ? opcodes->lod_lod_sto : opcodes->lod_lit_sto;
+          store(fourth);
+          return 4;
+        }
+        fused.op = load ? opcodes->lod_lod : opcodes->lod_lit;
+        return 3;
+      }
+      if (const relation_opcodes *opcodes = find_relation(*third)) {
+        if (is(fourth, pcode_jpc)) {
+          fused.op = load ? opcodes->lod_lod_jpc : opcodes->lod_lit_jpc;
+          fused.target = fourth->address;
+          return 4;
+        }
+      }
+      fused.level2 = 0;
+      fused.address2 = 0;
+      fused.value = 0;
+    }
+
+    // LOD STO and LOD OPR
+    if (is(second, pcode_sto)) {
+      fused.op = op_lod_sto;
+      store(second);
+      return 2;
+    }
+    if (second != nullptr) {
+      if (const arithmetic_opcodes *opcodes = find_arithmetic(*second)) {
+        fused.op = opcodes->lod;
+        return 2;
+      }
+    }
+    fused.level = 0;
+    fused.address = 0;
+    return 0;
+  }
+
+  // LIT STO and LIT OPR
+  if (first.function == pcode_lit && second != nullptr) {
+    fused.value = first.address;
+    if (second->function == pcode_sto) {
+      fused.op = op_lit_sto;
+      store(second);
+      return 2;
+    }
+    if (const arithmetic_opcodes *opcodes = find_arithmetic(*second)) {
+      fused.op = opcodes->lit;
+      return 2;
+    }
+    fused.value = 0;
+    return 0;
+  }
+
+  // OPR STO and OPR JPC
+  if (const arithmetic_opcodes *opcodes = find_arithmetic(first)) {
+    if (is(second, pcode_sto)) {
+      fused.op = opcodes->sto;
+      store(second);
+      return 2;
+    }
+  } else if (const relation_opcodes *opcodes = find_relation(first)) {
+    if (is(second, pcode_jpc)) {
+      fused.op = opcodes->jpc;
+      fused.target = second->address;
+      return 2;
+    }
+  } else if (first.function == pcode_opr && first.address == opr_odd &&
+             is(second, pcode_jpc)) {
+    fused.op = op_odd_jpc;
+    fused.target = second->address;
+    return 2;
+  }
+  return 0;
+}
+
+#define PL0_VM_LOAD (frame_at(stack, frame, ins->level)[ins->address])
+#define PL0_VM_LOAD2 (frame_at(stack, frame, ins->level2)[ins->address2])
+#define PL0_VM_STORE                                                           \
+  (frame_at(stack, frame, ins->store_level)[ins->store_address])
+
+#ifdef PL0_THREADED_DISPATCH
+#define PL0_VM_LABEL(name) &&vm_label_##name,
+#define PL0_VM_CASE(name) vm_label_##name:
+#define PL0_VM_DISPATCH() goto *labels[ins->op]
+#else
+#define PL0_VM_CASE(name) case op_##name:
+#define PL0_VM_DISPATCH() continue
+#endif
+#define PL0_VM_NEXT()                                                          \
+  ++ins;                                                                       \
+  PL0_VM_DISPATCH()
+#define PL0_VM_JUMP(to)                                                        \
+  ins = code + (to);                                                           \
+  PL0_VM_DISPATCH()
+
+#define PL0_VM_ARITHMETIC_HANDLERS(F, name, function)                          \
+  PL0_VM_CASE(name) {                                                          \
+    --top;                                                                     \
+    top[0] = function(top[0], top[1]);                                         \
+    PL0_VM_NEXT();                                                             \
+  }                                                                            \
+  PL0_VM_CASE(lod_##name) {                                                    \
+    top[0] = function(top[0], PL0_VM_LOAD);                                    \
+    PL0_VM_NEXT();                                                             \
+  }                                                                            \
+  PL0_VM_CASE(lit_##name) {                                                    \
+    top[0] = function(top[0], ins->value);                                     \
+    PL0_VM_NEXT();                                                             \
+  }                                                                            \
+  PL0_VM_CASE(lod_lod_##name) {                                                \
+    int result = function(PL0_VM_LOAD, PL0_VM_LOAD2);                          \
+    *++top = result;                                                           \
+    PL0_VM_NEXT();                                                             \
+  }                                                                            \
+  PL0_VM_CASE(lod_lit_##name) {                                                \
+    int result = function(PL0_VM_LOAD, ins->value);                            \
+    *++top = result;                                                           \
+    PL0_VM_NEXT();                                                             \
+  }                                                                            \
+  PL0_VM_CASE(name##_sto) {                                                    \
+    top -= 2;                                                                  \
+    PL0_VM_STORE = function(top[1], top[2]);                                   \
+    PL0_VM_NEXT();                                                             \
+  }                                                                            \
+  PL0_VM_CASE(lod_lod_##name##_sto) {                                          \
+    PL0_VM_STORE = function(PL0_VM_LOAD, PL0_VM_LOAD2);                        \
+    PL0_VM_NEXT();                                                             \
+  }                                                                            \
+  PL0_VM_CASE(lod_lit_##name##_sto) {                                          \
+    PL0_VM_STORE = function(PL0_VM_LOAD, ins->value);                          \
+    PL0_VM_NEXT();                                                             \
+  }
+
+#define PL0_VM_RELATION_HANDLERS(F, name, op)                                  \
+  PL0_VM_CASE(name) {                                                          \
+    --top;                                                                     \
+    top[0] = top[0] op top[1];                                                 \
+    PL0_VM_NEXT();                                                             \
+  }                                                                            \
+  PL0_VM_CASE(name##_jpc) {                                                    \
+    top -= 2;                                                                  \
+    if (top[1] op top[2]) {                                                    \
+      PL0_VM_NEXT();                                                           \
+    }                                                                          \
+    PL0_VM_JUMP(ins->target);                                                  \
+  }                                                                            \
+  PL0_VM_CASE(lod_lod_##name##_jpc) {                                          \
+    if (PL0_VM_LOAD op PL0_VM_LOAD2) {                                         \
+      PL0_VM_NEXT();                                                           \
+    }                                                                          \
+    PL0_VM_JUMP(ins->target);                                                  \
+  }                                                                            \
+  PL0_VM_CASE(lod_lit_##name##_jpc) {                                          \
+    if (PL0_VM_LOAD op ins->value) {                                           \
+      PL0_VM_NEXT();                                                           \
+    }                                                                          \
+    PL0_VM_JUMP(ins->target);                                                  \
+  }
+
+void pcode_vm::run(istream &in, ostream &out) {
+  if (_instructions.empty()) {
+    throw logic_error("No p-code to run");
+  }
+
+  const instruction *code = _instructions.data();
+  const instruction *ins = code;
+  int *stack = _stack.data();
+  int *stack_end = stack + _stack.size();
+
+  // the first word stays unused, so the empty stack has a top; the frame of
+  // the main program links to itself and returns to the halt
+  int *top = stack;
+  int *frame = stack + 1;
+  frame[0] = 1;
+  frame[1] = 1;
+  frame[2] = static_cast<int>(_instructions.size() - 1);
+
+  _output.clear();
+  try {
+#ifdef PL0_THREADED_DISPATCH
+    static const void *const labels[vm_opcode_size] = {
+        PL0_VM_OPCODES(PL0_VM_LABEL)};
+    PL0_VM_DISPATCH();
+#else
+    for (;;) {
+      switch (ins->op) {
+#endif
+
+    PL0_VM_CASE(halt) { goto finished; }
+    PL0_VM_CASE(lit) {
+      *++top = ins->value;
+      PL0_VM_NEXT();
+    }
+    PL0_VM_CASE(lod) {
+      int value = PL0_VM_LOAD;
+      *++top = value;
+      PL0_VM_NEXT();
+    }
+    PL0_VM_CASE(sto) {
+      PL0_VM_STORE = *top--;
+      PL0_VM_NEXT();
+    }
+    PL0_VM_CASE(cal) {
+      int *callee = top + 1;
+      callee[0] = static_cast<int>(frame_at(stack, frame, ins->level) - stack);
+      callee[1] = static_cast<int>(frame - stack);
+      callee[2] = static_cast<int>(ins - code) + 1;
+      frame = callee;
+      PL0_VM_JUMP(ins->target);
+    }
+    PL0_VM_CASE(int) {
+      if (stack_end - top <= ins->value) {
+        throw runtime_error("Stack overflow");
+      }
+      top += ins->address;
+      PL0_VM_NEXT();
+    }
+    PL0_VM_CASE(jmp) { PL0_VM_JUMP(ins->target); }
+    PL0_VM_CASE(jpc) {
+      if (*top-- != 0) {
+        PL0_VM_NEXT();
+      }
+      PL0_VM_JUMP(ins->target);
+    }
+    PL0_VM_CASE(red) {
+      // what was written so far is seen before the program waits
+      flush(out);
+      int number;
+      if (!(in >> number)) {
+        throw ios_base::failure("no number to read");
+      }
+      PL0_VM_STORE = number;
+      PL0_VM_NEXT();
+    }
+    PL0_VM_CASE(wrt) {
+      _output << *top-- << '\n';
+      if (_output.size() >= flush_size) {
+        flush(out);
+      }
+      PL0_VM_NEXT();
+    }
+    PL0_VM_CASE(ret) {
+      int *returning = frame;
+      top = returning - 1;
+      frame = stack + returning[1];
+      PL0_VM_JUMP(returning[2]);
+    }
+    PL0_VM_CASE(neg) {
+      top[0] = vm_sub(0, top[0]);
+      PL0_VM_NEXT();
+    }
+    PL0_VM_CASE(odd) {
+      top[0] &= 1;
+      PL0_VM_NEXT();
+    }
+    PL0_VM_CASE(odd_jpc) {
+      if ((*top-- & 1) != 0) {
+        PL0_VM_NEXT();
+      }
+      PL0_VM_JUMP(ins->target);
+    }
+    PL0_VM_CASE(lit_sto) {
+      PL0_VM_STORE = ins->value;
+      PL0_VM_NEXT();
+    }
+    PL0_VM_CASE(lod_sto) {
+      PL0_VM_STORE = PL0_VM_LOAD;
+      PL0_VM_NEXT();
+    }
+    PL0_VM_ARITHMETIC(PL0_VM_ARITHMETIC_HANDLERS, _)
+    PL0_VM_RELATIONS(PL0_VM_RELATION_HANDLERS, _)
+
+#ifndef PL0_THREADED_DISPATCH
+      default:
+        throw logic_error("Unknown opcode " + to_string(ins->op));
+      }
+    }
+#endif
+  finished:
+    flush(out);
+  } catch (...) {
+    // the output of the program up to the error is kept
+    flush(out);
+    throw;
+  }
+}
+
+void pcode_vm::flush(ostream &out) {
+  out.write(_output.data(), static_cast<std::streamsize>(_output.size()));
+  _output.clear();
+  if (!out) {
+    throw ios_base::failure("output write failed");
+  }
+}
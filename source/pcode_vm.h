@@ -0,0 +1,143 @@
+/**
+ * @file pcode_vm.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Virtual machine running p-code, with superinstructions
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_PCODE_VM_H
+#define LIB_7CXX_PCODE_VM_H
+
+#include "output_buffer.h"
+#include "pcode.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+using std::istream;
+using std::ostream;
+using std::size_t;
+using std::uint16_t;
+using std::vector;
+
+/**
+ * @brief Run p-code on a stack of words.
+ *
+ * `load` translates the p-code once into instructions of its own: a call or
+ * a jump to a jump goes to where that jump goes, and common sequences are
+ * fused into superinstructions, so a loop like
+ *
+ *     while i <= n do begin s := s + i; i := i + 1 end
+ *
+ * takes 4 dispatches per round instead of 13: `LOD LOD OPR JPC` is one
+ * compare-and-branch, `LOD LOD OPR STO` one load-load-op-store,
+ * `LOD LIT OPR STO` one increment, and the jump back stays. A sequence is
+ * only fused if no jump lands inside it. With GCC and Clang the
+ * instructions are dispatched with computed gotos, elsewhere with a switch.
+ *
+ * `run` then runs the instructions from address 0. `read` takes numbers
+ * from a stream, `write` writes every number on a line of its own.
+ * Arithmetic wraps around like two's complement integers, division by zero
+ * throws `std::domain_error`, and a stack which would grow beyond its size
+ * throws `std::runtime_error`.
+ */
+class pcode_vm {
+public:
+  /**
+   * @brief Construct a new VM
+   * @param stack_size The words of the stack
+   * @param superinstructions Fuse common sequences, otherwise every p-code
+   * instruction is dispatched on its own
+   */
+  explicit pcode_vm(size_t stack_size = default_stack_size,
+                    bool superinstructions = true);
+
+  /**
+   * @brief Translate p-code into instructions
+   * @param code The p-code
+   * @throw std::logic_error The p-code is malformed
+   */
+  void load(const vector<pcode_instruction> &code);
+
+  /**
+   * @brief Run the loaded instructions
+   * @param in Where `read` takes numbers from
+   * @param out Where `write` writes numbers to
+   * @throw std::domain_error Division by zero
+   * @throw std::runtime_error The stack overflows
+   * @throw std::ios_base::failure There is no number to read
+   */
+  void run(istream &in, ostream &out);
+
+  /**
+   * @brief Get the number of loaded instructions
+   * @return The number, superinstructions count as one
+   */
+  inline size_t get_instruction_count() const {
+    return _instructions.size();
+  }
+
+  /**
+   * @brief Get the number of superinstructions
+   * @return The number
+   */
+  inline size_t get_superinstruction_count() const {
+    return _superinstruction_count;
+  }
+
+  /**
+   * @brief The default words of the stack, 4 MiB
+   */
+  static const size_t default_stack_size = 1 << 20;
+
+private:
+  /**
+   * @brief A loaded instruction. Variables are loaded from `level` and
+   * `level2` and stored to `store_level`, the operands an instruction does
+   * not use are 0
+   */
+  struct instruction {
+    uint16_t op;          // The opcode
+    uint16_t level;       // The level difference of the first load, or of a
+                          // call
+    uint16_t level2;      // The level difference of the second load
+    uint16_t store_level; // The level difference of the store
+    int address;          // The address of the first load, or the frame
+                          // size of an INT
+    int address2;         // The address of the second load
+    int store_address;    // The address of the store
+    int value;            // The number, or the words an INT needs
+    int target;           // The instruction a jump or a call goes to
+  };
+
+  /**
+   * @brief Fuse the sequence at an address into a superinstruction
+   * @param code The p-code
+   * @param entries The addresses jumps, calls and returns land on
+   * @param address The address
+   * @param fused The superinstruction, its target is the one of the p-code
+   * @return The p-code instructions fused, 0 if no superinstruction starts
+   * at the address
+   */
+  static size_t fuse(const vector<pcode_instruction> &code,
+                     const vector<bool> &entries, size_t address,
+                     instruction &fused);
+
+  /**
+   * @brief Write the pending output
+   * @param out The output
+   * @throw std::ios_base::failure The output failed
+   */
+  void flush(ostream &out);
+
+private:
+  bool _superinstructions;            // Fuse common sequences
+  vector<int> _stack;                 // The stack
+  vector<instruction> _instructions;  // Loaded instructions
+  size_t _superinstruction_count = 0; // Superinstructions loaded
+  output_buffer _output;              // Numbers written, not yet flushed
+};
+
+#endif // LIB_7CXX_PCODE_VM_H
@@ -0,0 +1,211 @@
+#include "pipelined_compiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::setw;
+using std::thread;
+
+typedef std::chrono::steady_clock pipeline_clock;
+
+/**
+ * @brief Get the seconds passed since a time point
+ * @param start The time point
+ * @return The seconds
+ */
+static inline double seconds_since(pipeline_clock::time_point start) {
+  return std::chrono::duration<double>(pipeline_clock::now() - start).count();
+}
+
+/**
+ * @brief Push into a queue, waiting while it is full
+ * @param queue The queue
+ * @param job The job
+ * @return The seconds waited
+ */
+static double wait_push(spsc_queue<compile_job *> &queue, compile_job *job) {
+  pipeline_clock::time_point start = pipeline_clock::now();
+  return queue.push(job) ? seconds_since(start) : 0;
+}
+
+/**
+ * @brief Pop from a queue, waiting while it is empty
+ * @param queue The queue
+ * @param job The popped job
+ * @return The seconds waited
+ */
+static double wait_pop(spsc_queue<compile_job *> &queue, compile_job *&job) {
+  pipeline_clock::time_point start = pipeline_clock::now();
+  return queue.pop(job) ? seconds_since(start) : 0;
+}
+
+pipelined_compiler::pipelined_compiler(const compile_options &options,
+                                       size_t queue_capacity,
+                                       const vector<size_t> &stage_workers)
+    : _queue_capacity(queue_capacity < 1 ? 1 : queue_capacity),
+      _use_arenas(options.use_arenas), _workers(compile_stage_size, 1),
+      _pipelines(compile_stage_size) {
+  for (int stage = 0; stage < compile_stage_size; ++stage) {
+    if (static_cast<size_t>(stage) < stage_workers.size() &&
+        stage_workers[stage] > 0) {
+      _workers[stage] = stage_workers[stage];
+    }
+    for (size_t worker = 0; worker < _workers[stage]; ++worker) {
+      _pipelines[stage].emplace_back(new compiler_pipeline(options));
+    }
+  }
+}
+
+vector<compile_result> pipelined_compiler::run(const vector<string> &inputs,
+                                               const vector<string> &stems) {
+  vector<compile_result> results(inputs.size());
+
+  // the lanes into stage `s` come from stage `s - 1`, the ones into the
+  // lexing stage carry the free jobs back from the output stage; every lane
+  // can hold all jobs, so handing a job on never waits
+  vector<job_lanes> lanes(compile_stage_size);
+  for (int stage = 0; stage < compile_stage_size; ++stage) {
+    size_t producers =
+        _workers[(stage + compile_stage_size - 1) % compile_stage_size];
+    for (size_t lane = 0; lane < producers * _workers[stage]; ++lane) {
+      lanes[stage].emplace_back(new job_queue(_queue_capacity));
+    }
+  }
+  vector<compile_job> jobs(_queue_capacity);
+  vector<unique_ptr<arena>> arenas;
+  if (_use_arenas) {
+    for (compile_job &job : jobs) {
+      // a job goes from thread to thread, its arena goes with it
+      arenas.emplace_back(new arena());
+      job.memory = arenas.back().get();
+    }
+  }
+
+  vector<vector<stage_statistics>> statistics(compile_stage_size);
+  vector<thread> threads;
+  for (int stage = 0; stage < compile_stage_size; ++stage) {
+    statistics[stage].resize(_workers[stage]);
+    for (size_t worker = 0; worker < _workers[stage]; ++worker) {
+      threads.emplace_back(&pipelined_compiler::worker_loop, this,
+                           static_cast<compile_stage>(stage), worker,
+                           std::ref(lanes), std::ref(jobs), std::cref(inputs),
+                           std::cref(stems), std::ref(results),
+                           std::ref(statistics[stage][worker]));
+    }
+  }
+  for (thread &t : threads) {
+    t.join();
+  }
+
+  _statistics.clear();
+  for (int stage = 0; stage < compile_stage_size; ++stage) {
+    stage_statistics merged = {
+        compiler_pipeline::stage_name(static_cast<compile_stage>(stage)),
+        _workers[stage], 0, 0, 0, 0, 0};
+    for (const stage_statistics &s : statistics[stage]) {
+      merged.jobs += s.jobs;
+      merged.busy_seconds += s.busy_seconds;
+      merged.starved_seconds += s.starved_seconds;
+      merged.blocked_seconds += s.blocked_seconds;
+      merged.wall_seconds = std::max(merged.wall_seconds, s.wall_seconds);
+    }
+    _statistics.push_back(merged);
+  }
+
+  return results;
+}
+
+void pipelined_compiler::worker_loop(compile_stage stage, size_t worker,
+                                     vector<job_lanes> &lanes,
+                                     vector<compile_job> &jobs,
+                                     const vector<string> &inputs,
+                                     const vector<string> &stems,
+                                     vector<compile_result> &results,
+                                     stage_statistics &statistics) {
+  pipeline_clock::time_point start = pipeline_clock::now();
+  compiler_pipeline &pipeline = *_pipelines[stage][worker];
+  int next = (stage + 1) % compile_stage_size;
+  size_t workers = _workers[stage];
+  size_t previous_workers =
+      _workers[(stage + compile_stage_size - 1) % compile_stage_size];
+  size_t next_workers = _workers[next];
+  job_lanes &in = lanes[stage];
+  job_lanes &out = lanes[next];
+
+  // the file `index` is run by worker `index % workers` of every stage, and
+  // the job of the file `index` is free again for the file
+  // `index + jobs.size()`
+  for (size_t index = worker; index < inputs.size(); index += workers) {
+    compile_job *job = nullptr;
+    if (stage == stage_lex) {
+      if (index < jobs.size()) {
+        job = &jobs[index];
+      } else {
+        // no free job means every job is still in a later stage
+        size_t freed = index - jobs.size();
+        statistics.blocked_seconds += wait_pop(
+            *in[freed % previous_workers * workers + worker], job);
+      }
+      compiler_pipeline::reset_job(
+          *job, inputs[index], stems[index],
+          "pl0_expression" + std::to_string(index + 1));
+      job->index = index;
+    } else {
+      statistics.starved_seconds +=
+          wait_pop(*in[index % previous_workers * workers + worker], job);
+    }
+
+    pipeline_clock::time_point busy = pipeline_clock::now();
+    pipeline.run_stage(stage, *job);
+    if (stage == stage_output) {
+      results[job->index] = compiler_pipeline::take_result(*job);
+      if (job->memory != nullptr) {
+        job->memory->reset();
+      }
+    }
+    statistics.busy_seconds += seconds_since(busy);
+    ++statistics.jobs;
+
+    if (stage != stage_output) {
+      statistics.blocked_seconds += wait_push(
+          *out[worker * next_workers + index % next_workers], job);
+    } else if (index + jobs.size() < inputs.size()) {
+      size_t reuse = index + jobs.size();
+      statistics.blocked_seconds += wait_push(
+          *out[worker * next_workers + reuse % next_workers], job);
+    }
+  }
+
+  statistics.wall_seconds = seconds_since(start);
+}
+
+metrics pipelined_compiler::get_metrics() const {
+  metrics merged;
+  for (const auto &stage : _pipelines) {
+    for (const auto &pipeline : stage) {
+      merged.merge(pipeline->get_metrics());
+    }
+  }
+  return merged;
+}
+
+void pipelined_compiler::print_utilization(ostream &out) const {
+  out << std::left << setw(12) << "stage" << std::right << setw(10)
+      << "workers" << setw(10) << "jobs" << setw(12) << "busy(ms)" << setw(10)
+      << "busy%" << setw(10) << "starved%" << setw(10) << "blocked%" << '\n';
+  for (const auto &s : _statistics) {
+    // the percentages are of the time all workers of the stage had
+    double wall = s.wall_seconds > 0 ? s.wall_seconds * s.workers : 1;
+    out << std::left << setw(12) << s.name << std::right << setw(10)
+        << s.workers << setw(10) << s.jobs
+        << std::fixed << std::setprecision(1) << setw(12)
+        << s.busy_seconds * 1e3 << setw(10) << s.busy_seconds / wall * 100
+        << setw(10) << s.starved_seconds / wall * 100 << setw(10)
+        << s.blocked_seconds / wall * 100 << '\n';
+  }
+}
@@ -0,0 +1,134 @@
+/**
+ * @file pipelined_compiler.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Compile a stream of files with every stage on its own threads
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_PIPELINED_COMPILER_H
+#define LIB_7CXX_PIPELINED_COMPILER_H
+
+#include "compiler_pipeline.h"
+#include "spsc_queue.h"
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using std::ostream;
+using std::size_t;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+/**
+ * @brief Run the stages of `compiler_pipeline` as an assembly line.
+ *
+ * Every stage runs on one or more worker threads, each with its own
+ * pipeline, and hands jobs to the next stage over bounded `spsc_queue`s. The
+ * output stage returns finished jobs to the lexing stage over one more set of
+ * queues, so at most `queue_capacity` files are in flight: when a stage falls
+ * behind, the stages before it run out of free jobs and wait for it.
+ *
+ * Worker `w` of a stage with `n` workers runs the files whose index is `w`
+ * modulo `n`, in order. Every worker of a stage has a queue, a lane, to every
+ * worker of the next stage, and pushes a file into the lane of the worker
+ * which runs it; that worker knows which worker ran the file before, and pops
+ * the lane of that worker. Every lane thus keeps one producer and one
+ * consumer, and every worker sees its files in input order.
+ */
+class pipelined_compiler {
+public:
+  /**
+   * @brief The time a stage spent on working and on waiting
+   */
+  struct stage_statistics {
+    string name;            // The name of the stage
+    size_t workers;         // Worker threads of the stage
+    size_t jobs;            // Jobs run
+    double busy_seconds;    // Running the stage, summed over the workers
+    double starved_seconds; // Waiting for a job from the previous stage
+    double blocked_seconds; // Waiting for a free job or for room in a lane
+    double wall_seconds;    // Lifetime of the longest living worker
+  };
+
+public:
+  /**
+   * @brief Construct a new pipelined compiler
+   * @param options The options of the pipelines
+   * @param queue_capacity The files in flight, and the capacity of the lanes
+   * @param stage_workers The worker threads of every stage, indexed by
+   * `compile_stage`; a missing or zero count means one worker
+   * @throw std::invalid_argument A disabled pass does not exist
+   */
+  explicit pipelined_compiler(const compile_options &options,
+                              size_t queue_capacity = 64,
+                              const vector<size_t> &stage_workers = {});
+
+  pipelined_compiler(const pipelined_compiler &) = delete;
+
+  /**
+   * @brief Compile files
+   * @param inputs The names of the input files
+   * @param stems The output stems of the files
+   * @return The results, in the order of the inputs
+   */
+  vector<compile_result> run(const vector<string> &inputs,
+                             const vector<string> &stems);
+
+  /**
+   * @brief Get the statistics of the last run
+   * @return The statistics of every stage, in order
+   */
+  inline const vector<stage_statistics> &get_statistics() const {
+    return _statistics;
+  }
+
+  /**
+   * @brief Print the utilization of every stage in the last run
+   * @param out The output stream
+   */
+  void print_utilization(ostream &out) const;
+
+  /**
+   * @brief Get the metrics of all stages
+   * @return The merged metrics of the stage pipelines
+   */
+  metrics get_metrics() const;
+
+private:
+  typedef spsc_queue<compile_job *> job_queue;
+
+  /**
+   * @brief The lanes into a stage, the one from worker `p` of the previous
+   * stage to worker `c` is at `p * workers + c`
+   */
+  typedef vector<unique_ptr<job_queue>> job_lanes;
+
+  /**
+   * @brief The main loop of a worker
+   * @param stage The stage
+   * @param worker The worker in the stage
+   * @param lanes The lanes into every stage
+   * @param jobs The jobs, the first ones are taken without a lane
+   * @param inputs The names of the input files, for the lexing stage
+   * @param stems The output stems, for the lexing stage
+   * @param results The results, for the output stage
+   * @param statistics The statistics of the worker
+   */
+  void worker_loop(compile_stage stage, size_t worker,
+                   vector<job_lanes> &lanes, vector<compile_job> &jobs,
+                   const vector<string> &inputs, const vector<string> &stems,
+                   vector<compile_result> &results,
+                   stage_statistics &statistics);
+
+private:
+  size_t _queue_capacity;     // Files in flight, and capacity of a lane
+  bool _use_arenas;           // An arena per job
+  vector<size_t> _workers;    // Workers of every stage
+  vector<vector<unique_ptr<compiler_pipeline>>> _pipelines; // One per worker
+  vector<stage_statistics> _statistics;                     // One per stage
+};
+
+#endif // LIB_7CXX_PIPELINED_COMPILER_H
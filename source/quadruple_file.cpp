@@ -0,0 +1,171 @@
+#include "quadruple_file.h"
+
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <vector>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using std::ifstream;
+using std::ios_base;
+using std::ofstream;
+
+const uint32_t quadruple_file::version;
+const uint32_t quadruple_file::byte_order_mark;
+
+static const char quadruple_file_magic[4] = {'P', 'L', '0', 'Q'};
+
+void quadruple_file::write(const string &file_name,
+                           const vector<quadruple> &quads) {
+  vector<quadruple_record> records;
+  records.reserve(quads.size());
+  for (const quadruple &quad : quads) {
+    records.push_back(to_record(quad));
+  }
+
+  quadruple_file_header header;
+  std::memcpy(header.magic, quadruple_file_magic, sizeof(header.magic));
+  header.byte_order = byte_order_mark;
+  header.version = version;
+  header.record_size = sizeof(quadruple_record);
+  header.count = records.size();
+  header.checksum = checksum(records.data(), records.size());
+  header.reserved = 0;
+
+  ofstream fout(file_name, ios_base::binary | ios_base::trunc);
+  if (!fout.is_open()) {
+    throw ios_base::failure("file " + file_name + " open failed");
+  }
+  fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  fout.write(reinterpret_cast<const char *>(records.data()),
+             static_cast<std::streamsize>(records.size() *
+                                          sizeof(quadruple_record)));
+  if (!fout.good()) {
+    throw ios_base::failure("file " + file_name + " write failed");
+  }
+}
+
+uint32_t quadruple_file::checksum(const quadruple_record *records,
+                                  size_t count) {
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(records);
+  uint32_t hash = 2166136261u;
+  for (size_t index = 0; index < count * sizeof(quadruple_record); ++index) {
+    hash ^= bytes[index];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+quadruple_record quadruple_file::to_record(const quadruple &quad) {
+  quadruple_record record;
+  record.op = static_cast<uint8_t>(quad.op);
+  record.type1 = static_cast<uint8_t>(quad.operand1.first);
+  record.type2 = static_cast<uint8_t>(quad.operand2.first);
+  record.type_count = static_cast<uint8_t>(quad.count.first);
+  record.value1 = quad.operand1.second;
+  record.value2 = quad.operand2.second;
+  record.value_count = quad.count.second;
+  return record;
+}
+
+quadruple quadruple_file::to_quadruple(const quadruple_record &record) {
+  return {static_cast<char>(record.op),
+          {static_cast<quadruple::type>(record.type1), record.value1},
+          {static_cast<quadruple::type>(record.type2), record.value2},
+          {static_cast<quadruple::type>(record.type_count), record.value_count}};
+}
+
+quadruple_file::quadruple_file(const string &file_name, bool verify_checksum) {
+  const char *data = nullptr;
+  size_t length = 0;
+
+#ifdef __unix__
+  int fd = ::open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw ios_base::failure("file " + file_name + " open failed");
+  }
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) != 0) {
+    ::close(fd);
+    throw ios_base::failure("file " + file_name + " stat failed");
+  }
+  length = static_cast<size_t>(file_stat.st_size);
+  if (length > 0) {
+    _data = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (_data == MAP_FAILED) {
+      _data = nullptr;
+      ::close(fd);
+      throw ios_base::failure("file " + file_name + " map failed");
+    }
+    _length = length;
+    data = static_cast<const char *>(_data);
+  }
+  ::close(fd);
+#else
+  ifstream fin(file_name, ios_base::binary);
+  if (!fin.is_open()) {
+    throw ios_base::failure("file " + file_name + " open failed");
+  }
+  _buffer.assign(std::istreambuf_iterator<char>(fin),
+                 std::istreambuf_iterator<char>());
+  data = _buffer.data();
+  length = _buffer.size();
+#endif
+
+  // check the header, the records are used as they are
+  const quadruple_file_header *header =
+      reinterpret_cast<const quadruple_file_header *>(data);
+  if (length < sizeof(quadruple_file_header) ||
+      std::memcmp(header->magic, quadruple_file_magic, 4) != 0) {
+    unmap();
+    throw ios_base::failure("file " + file_name + " is not a quadruple file");
+  }
+  if (header->byte_order != byte_order_mark) {
+    unmap();
+    throw ios_base::failure("file " + file_name +
+                            " was written with another byte order");
+  }
+  if (header->version != version ||
+      header->record_size != sizeof(quadruple_record) ||
+      (length - sizeof(quadruple_file_header)) / sizeof(quadruple_record) <
+          header->count) {
+    unmap();
+    throw ios_base::failure("file " + file_name +
+                            " has an unsupported version or is truncated");
+  }
+
+  _records = reinterpret_cast<const quadruple_record *>(
+      data + sizeof(quadruple_file_header));
+  _count = static_cast<size_t>(header->count);
+
+  if (verify_checksum && checksum(_records, _count) != header->checksum) {
+    unmap();
+    throw ios_base::failure("file " + file_name + " has a wrong checksum");
+  }
+}
+
+quadruple_file::~quadruple_file() { unmap(); }
+
+void quadruple_file::unmap() {
+#ifdef __unix__
+  if (_data != nullptr) {
+    ::munmap(_data, _length);
+    _data = nullptr;
+  }
+#endif
+}
+
+vector<quadruple> quadruple_file::to_vector() const {
+  vector<quadruple> quads;
+  quads.reserve(_count);
+  for (size_t index = 0; index < _count; ++index) {
+    quads.push_back(to_quadruple(_records[index]));
+  }
+  return quads;
+}
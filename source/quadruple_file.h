@@ -0,0 +1,185 @@
+/**
+ * @file quadruple_file.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Binary, memory-mappable file format for quadruples
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_QUADRUPLE_FILE_H
+#define LIB_7CXX_QUADRUPLE_FILE_H
+
+#include "intermediate_code_generator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using quadruple = intermediate_code_generator::quadruple;
+
+using std::int32_t;
+using std::size_t;
+using std::string;
+using std::uint32_t;
+using std::uint64_t;
+using std::uint8_t;
+using std::vector;
+
+/**
+ * The layout of a quadruple file, all fields in the byte order of the host
+ * which wrote it:
+ *
+ * | offset | size   | field                                  |
+ * |--------|--------|----------------------------------------|
+ * | 0      | 4      | magic "PL0Q"                           |
+ * | 4      | 4      | byte order mark 0x01020304             |
+ * | 8      | 4      | version                                |
+ * | 12     | 4      | size of a record (16)                  |
+ * | 16     | 8      | number of records                      |
+ * | 24     | 4      | FNV-1a checksum of all record bytes    |
+ * | 28     | 4      | reserved, 0                            |
+ * | 32     | 16 * n | records                                |
+ *
+ * A record stores the operator, the three item types and the three item
+ * values at fixed offsets, so the mapped records are used without parsing.
+ * The byte order mark comes before everything else whose bytes depend on
+ * the host, a file written on a host of the other byte order is refused.
+ */
+
+/**
+ * @brief The header of a quadruple file
+ */
+struct quadruple_file_header {
+  char magic[4];        // "PL0Q"
+  uint32_t byte_order;  // `quadruple_file::byte_order_mark` in host order
+  uint32_t version;     // Format version
+  uint32_t record_size; // Size of a record
+  uint64_t count;       // Number of records
+  uint32_t checksum;    // FNV-1a checksum of the records
+  uint32_t reserved;    // Reserved, 0
+};
+
+/**
+ * @brief One quadruple in a quadruple file
+ */
+struct quadruple_record {
+  uint8_t op;          // Operator
+  uint8_t type1;       // Type of operand 1
+  uint8_t type2;       // Type of operand 2
+  uint8_t type_count;  // Type of count
+  int32_t value1;      // Value of operand 1
+  int32_t value2;      // Value of operand 2
+  int32_t value_count; // Value of count
+};
+
+static_assert(sizeof(quadruple_file_header) == 32,
+              "unexpected quadruple file header layout");
+static_assert(sizeof(quadruple_record) == 16,
+              "unexpected quadruple record layout");
+
+/**
+ * @brief Write and map quadruple files
+ */
+class quadruple_file {
+public:
+  /**
+   * @brief The version written by this build
+   */
+  static const uint32_t version = 3;
+
+  /**
+   * @brief The byte order mark, it reads as another number on a host of the
+   * other byte order
+   */
+  static const uint32_t byte_order_mark = 0x01020304;
+
+  /**
+   * @brief Write quadruples into a file
+   * @param file_name The name of the file
+   * @param quads The quadruples
+   * @throw std::ios_base::failure The file cannot be written
+   */
+  static void write(const string &file_name, const vector<quadruple> &quads);
+
+  /**
+   * @brief Compute the checksum of records
+   * @param records The records
+   * @param count The number of records
+   * @return The FNV-1a hash of the record bytes
+   */
+  static uint32_t checksum(const quadruple_record *records, size_t count);
+
+  /**
+   * @brief Convert a quadruple into a record
+   * @param quad The quadruple
+   * @return The record
+   */
+  static quadruple_record to_record(const quadruple &quad);
+
+  /**
+   * @brief Convert a record into a quadruple
+   * @param record The record
+   * @return The quadruple
+   */
+  static quadruple to_quadruple(const quadruple_record &record);
+
+public:
+  /**
+   * @brief Map a quadruple file into memory and check its header
+   * @param file_name The name of the file
+   * @param verify_checksum Whether to check the checksum of the records
+   * @throw std::ios_base::failure The file cannot be read, is malformed or
+   * was written on a host of another byte order
+   */
+  explicit quadruple_file(const string &file_name, bool verify_checksum = true);
+
+  quadruple_file(const quadruple_file &) = delete;
+
+  quadruple_file &operator=(const quadruple_file &) = delete;
+
+  /**
+   * @brief Unmap the file
+   */
+  ~quadruple_file();
+
+  /**
+   * @brief Get the number of quadruples
+   * @return The number of quadruples
+   */
+  inline size_t size() const { return _count; }
+
+  /**
+   * @brief Get the mapped records
+   * @return The first record
+   */
+  inline const quadruple_record *records() const { return _records; }
+
+  /**
+   * @brief Decode a quadruple
+   * @param index The index of the quadruple
+   * @return The quadruple
+   */
+  inline quadruple operator[](size_t index) const {
+    return to_quadruple(_records[index]);
+  }
+
+  /**
+   * @brief Decode all quadruples
+   * @return The quadruples
+   */
+  vector<quadruple> to_vector() const;
+
+private:
+  /**
+   * @brief Unmap the file, if it is mapped
+   */
+  void unmap();
+
+private:
+  void *_data = nullptr;                      // The mapped file
+  size_t _length = 0;                         // The length of the mapping
+  vector<char> _buffer;                       // The file, if not mapped
+  const quadruple_record *_records = nullptr; // The records
+  size_t _count = 0;                          // The number of records
+};
+
+#endif // LIB_7CXX_QUADRUPLE_FILE_H
@@ -0,0 +1,233 @@
+#include "quadruple_interpreter.h"
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::domain_error;
+using std::logic_error;
+using std::fill;
+using std::max;
+using std::min;
+
+void quadruple_interpreter::load(const vector<quadruple> &quads) {
+  clear();
+
+  // slots of T come first, then slots of O
+  int max_T = 0;
+  int max_optimized = 0;
+  for (const quadruple &quad : quads) {
+    if (quad.count.first == quadruple::T) {
+      max_T = max(max_T, quad.count.second);
+    } else if (quad.count.first == quadruple::optimized) {
+      max_optimized = max(max_optimized, quad.count.second);
+    } else {
+      throw logic_error("Result is not a tmp: " +
+                        quadruple::item2str(quad.count));
+    }
+  }
+  _max_T = max_T;
+  _temps.assign(static_cast<size_t>(max_T) + max_optimized + 1, 0);
+  _defined.assign(_temps.size(), false);
+
+  auto slot = [max_T](const quadruple::item &item) -> size_t {
+    return item.first == quadruple::T
+               ? static_cast<size_t>(item.second)
+               : static_cast<size_t>(max_T) + item.second;
+  };
+  auto translate = [&](const quadruple::item &item) -> operand {
+    switch (item.first) {
+    case quadruple::number:
+      return {true, item.second};
+    case quadruple::T:
+    case quadruple::optimized: {
+      size_t index = slot(item);
+      if (item.second < 0 || index >= _defined.size() || !_defined[index]) {
+        throw logic_error("Undefined variable: " + quadruple::item2str(item));
+      }
+      return {false, static_cast<int>(index)};
+    }
+    case quadruple::empty:
+    default:
+      return {true, 0};
+    }
+  };
+
+  _instructions.reserve(quads.size());
+  for (const quadruple &quad : quads) {
+    if (quad.count.second < 0) {
+      throw logic_error("Negative tmp: " + quadruple::item2str(quad.count));
+    }
+    instruction ins = {quad.op, translate(quad.operand1),
+                       translate(quad.operand2), slot(quad.count)};
+    _defined[ins.result] = true;
+    _instructions.push_back(ins);
+  }
+}
+
+int quadruple_interpreter::execute() {
+  if (_instructions.empty()) {
+    throw logic_error("No quadruples to execute");
+  }
+  run();
+  return _temps[_instructions.back().result];
+}
+
+void quadruple_interpreter::execute_prelude(const vector<quadruple> &prelude) {
+  load(prelude);
+  run();
+  _prelude_slots = _temps.size();
+  _prelude_max_T = _max_T;
+}
+
+int quadruple_interpreter::execute_continued(const vector<quadruple> &quads) {
+  if (quads.empty()) {
+    throw logic_error("No quadruples to execute");
+  }
+  _instructions.clear();
+
+  // tmps of a batch are numbered across all of its expressions, so the own
+  // tmps of the quadruples are renumbered from the smallest one of each kind
+  // into the slots after those of the prelude; an expression costs the span
+  // of its own numbers, whatever comes before it in the batch
+  int min_tmp[2] = {INT_MAX, INT_MAX};
+  int max_tmp[2] = {-1, -1};
+  for (const quadruple &quad : quads) {
+    if (quad.count.first != quadruple::T &&
+        quad.count.first != quadruple::optimized) {
+      throw logic_error("Result is not a tmp: " +
+                        quadruple::item2str(quad.count));
+    }
+    if (quad.count.second < 0) {
+      throw logic_error("Negative tmp: " + quadruple::item2str(quad.count));
+    }
+    int kind = quad.count.first == quadruple::T ? 0 : 1;
+    min_tmp[kind] = min(min_tmp[kind], quad.count.second);
+    max_tmp[kind] = max(max_tmp[kind], quad.count.second);
+  }
+  size_t span[2];
+  for (int kind = 0; kind < 2; ++kind) {
+    span[kind] = max_tmp[kind] < 0
+                     ? 0
+                     : static_cast<size_t>(max_tmp[kind] - min_tmp[kind]) + 1;
+  }
+  const size_t base = _prelude_slots;
+  const size_t total = base + span[0] + span[1];
+  if (_temps.size() < total) {
+    _temps.resize(total, 0);
+  }
+  if (_defined.size() < total) {
+    _defined.resize(total, false);
+  }
+  fill(_defined.begin() + base, _defined.begin() + total, false);
+
+  // whether a tmp is one of the own numbers, and its slot if it is
+  auto own_slot = [&](const quadruple::item &item, size_t &slot) -> bool {
+    if (item.first != quadruple::T && item.first != quadruple::optimized) {
+      return false;
+    }
+    int kind = item.first == quadruple::T ? 0 : 1;
+    if (item.second < min_tmp[kind] || item.second > max_tmp[kind]) {
+      return false;
+    }
+    slot = base + (kind == 0 ? 0 : span[0]) +
+           static_cast<size_t>(item.second - min_tmp[kind]);
+    return true;
+  };
+  auto translate = [&](const quadruple::item &item) -> operand {
+    switch (item.first) {
+    case quadruple::number:
+      return {true, item.second};
+    case quadruple::T:
+    case quadruple::optimized: {
+      size_t index;
+      if (own_slot(item, index) && _defined[index]) {
+        return {false, static_cast<int>(index)};
+      }
+      if (find_prelude_slot(item, index)) {
+        return {false, static_cast<int>(index)};
+      }
+      throw logic_error("Undefined variable: " + quadruple::item2str(item));
+    }
+    case quadruple::empty:
+    default:
+      return {true, 0};
+    }
+  };
+
+  _instructions.reserve(quads.size());
+  for (const quadruple &quad : quads) {
+    size_t slot;
+    if (find_prelude_slot(quad.count, slot)) {
+      throw logic_error("Tmp of the prelude defined again: " +
+                        quadruple::item2str(quad.count));
+    }
+    own_slot(quad.count, slot);
+    instruction ins = {quad.op, translate(quad.operand1),
+                       translate(quad.operand2), slot};
+    _defined[ins.result] = true;
+    _instructions.push_back(ins);
+  }
+
+  run();
+  return _temps[_instructions.back().result];
+}
+
+bool quadruple_interpreter::find_prelude_slot(const quadruple::item &item,
+                                              size_t &slot) const {
+  if (item.second < 0 || (item.first == quadruple::T &&
+                          item.second > _prelude_max_T)) {
+    return false;
+  }
+  if (item.first == quadruple::T) {
+    slot = static_cast<size_t>(item.second);
+  } else if (item.first == quadruple::optimized) {
+    slot = static_cast<size_t>(_prelude_max_T) + item.second;
+  } else {
+    return false;
+  }
+  return slot < _prelude_slots && _defined[slot];
+}
+
+void quadruple_interpreter::run() {
+  int *temps = _temps.data();
+  for (const instruction &ins : _instructions) {
+    int left = ins.operand1.immediate ? ins.operand1.value
+                                      : temps[ins.operand1.value];
+    if (ins.op == '=') {
+      temps[ins.result] = left;
+      continue;
+    }
+    int right = ins.operand2.immediate ? ins.operand2.value
+                                       : temps[ins.operand2.value];
+    temps[ins.result] = apply(ins.op, left, right);
+  }
+}
+
+int quadruple_interpreter::apply(char op, int left, int right) {
+  unsigned int l = static_cast<unsigned int>(left);
+  unsigned int r = static_cast<unsigned int>(right);
+
+  switch (op) {
+  case '+':
+    return static_cast<int>(l + r);
+  case '-':
+    return static_cast<int>(l - r);
+  case '*':
+    return static_cast<int>(l * r);
+  case '/':
+    if (right == 0) {
+      throw domain_error("Division by zero");
+    }
+    if (left == INT_MIN && right == -1) {
+      return INT_MIN;
+    }
+    return left / right;
+  case quadruple::shift_left:
+    return static_cast<int>(l << (r & 31));
+  default:
+    throw logic_error(std::string("unexpected operator") + op);
+  }
+}
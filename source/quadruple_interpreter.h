@@ -0,0 +1,145 @@
+/**
+ * @file quadruple_interpreter.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Interpreter executing quadruples
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_QUADRUPLE_INTERPRETER_H
+#define LIB_7CXX_QUADRUPLE_INTERPRETER_H
+
+#include "intermediate_code_generator.h"
+
+#include <cstddef>
+#include <vector>
+
+using quadruple = intermediate_code_generator::quadruple;
+
+using std::size_t;
+using std::vector;
+
+/**
+ * @brief Execute quadruples over a flat array of tmps.
+ *
+ * `load` translates the quadruples once into instructions whose operands are
+ * either immediates or slots of the tmp array: `T<k>` lives in slot k and
+ * `O<k>` in slot k + (largest T number), so both kinds can be mixed.
+ * `execute` then runs the instructions and returns the result of the last
+ * one, which is the value of the expression. Arithmetic wraps around like
+ * two's complement integers, division by zero throws `std::domain_error`.
+ *
+ * Quadruples of a batch share the tmps of a prelude. `execute_prelude` runs
+ * the prelude once and keeps its tmps, then `execute_continued` runs the
+ * quadruples of one expression after another against them: their own tmps
+ * get slots after those of the prelude, so the prelude is neither copied
+ * nor run again.
+ */
+class quadruple_interpreter {
+public:
+  /**
+   * @brief Translate quadruples into instructions
+   * @param quads The quadruples
+   * @throw std::logic_error A tmp is used before it is defined
+   */
+  void load(const vector<quadruple> &quads);
+
+  /**
+   * @brief Run the loaded instructions
+   * @return The result of the last instruction
+   */
+  int execute();
+
+  /**
+   * @brief Load and run quadruples
+   * @param quads The quadruples
+   * @return The result of the last quadruple
+   */
+  inline int execute(const vector<quadruple> &quads) {
+    load(quads);
+    return execute();
+  }
+
+  /**
+   * @brief Run the quadruples shared by a batch and keep their tmps for
+   * `execute_continued`
+   * @param prelude The shared quadruples, may be empty
+   * @throw std::logic_error A tmp is used before it is defined
+   */
+  void execute_prelude(const vector<quadruple> &prelude);
+
+  /**
+   * @brief Run quadruples which read the tmps of the last prelude. The tmps
+   * of the prelude are kept, the next call sees them unchanged
+   * @param quads The quadruples
+   * @return The result of the last quadruple
+   * @throw std::logic_error A tmp is used before it is defined, or a tmp of
+   * the prelude is defined again
+   */
+  int execute_continued(const vector<quadruple> &quads);
+
+  /**
+   * @brief Get the number of slots in the tmp array
+   * @return The number of slots
+   */
+  inline size_t get_temp_count() const { return _temps.size(); }
+
+  /**
+   * @brief Clear the loaded instructions, the capacity is kept
+   */
+  inline void clear() {
+    _instructions.clear();
+    _temps.clear();
+    _prelude_slots = 0;
+  }
+
+  /**
+   * @brief Apply an operator on two numbers
+   * @param op The operator
+   * @param left The left operand
+   * @param right The right operand
+   * @return The result
+   * @throw std::domain_error Division by zero
+   */
+  static int apply(char op, int left, int right);
+
+private:
+  /**
+   * @brief Run the loaded instructions, which may be none
+   */
+  void run();
+
+  /**
+   * @brief Find the slot a prelude keeps a tmp in
+   * @param item The tmp
+   * @param slot The slot
+   * @return true The prelude defines the tmp
+   * @return false It does not
+   */
+  bool find_prelude_slot(const quadruple::item &item, size_t &slot) const;
+
+  /**
+   * @brief An operand of an instruction
+   */
+  struct operand {
+    bool immediate; // The value is a number, otherwise a slot
+    int value;      // The number or the slot
+  };
+
+  /**
+   * @brief A loaded quadruple
+   */
+  struct instruction {
+    char op;          // Operator
+    operand operand1; // Operand 1
+    operand operand2; // Operand 2
+    size_t result;    // Slot of the result
+  };
+
+  vector<instruction> _instructions; // Loaded instructions
+  vector<int> _temps;                // The tmp array
+  vector<bool> _defined;             // Slots defined so far, while loading
+  int _max_T = 0;                    // The largest T number loaded
+  size_t _prelude_slots = 0;         // Slots kept by the last prelude
+  int _prelude_max_T = 0;            // The largest T number of the prelude
+};
+
+#endif // LIB_7CXX_QUADRUPLE_INTERPRETER_H
@@ -0,0 +1,42 @@
+#include "record_reader.h"
+
+size_t record_reader::read(vector<input_record> &records, size_t count) {
+  size_t read = 0;
+  while (read < count) {
+    if (!_in_line) {
+      if (!std::getline(_in, _line)) {
+        break;
+      }
+      ++_line_number;
+      _position = 0;
+      _in_line = true;
+    }
+
+    size_t end = _line.find(';', _position);
+    if (end == string::npos) {
+      end = _line.size();
+      _in_line = false;
+    }
+    const char *text = _line.data();
+    if (!is_blank(text + _position, text + end)) {
+      if (read == records.size()) {
+        records.emplace_back();
+      }
+      input_record &record = records[read++];
+      record.number = ++_record_count;
+      record.line = _line_number;
+      record.text.assign(text + _position, text + end);
+    }
+    _position = end + 1;
+  }
+  return read;
+}
+
+bool record_reader::is_blank(const char *begin, const char *end) {
+  for (; begin != end; ++begin) {
+    if (*begin != ' ' && *begin != '\t' && *begin != '\r') {
+      return false;
+    }
+  }
+  return true;
+}
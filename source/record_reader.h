@@ -0,0 +1,79 @@
+/**
+ * @file record_reader.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Stream of expressions, one per line or per `;`-separated record
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_RECORD_READER_H
+#define LIB_7CXX_RECORD_READER_H
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+using std::istream;
+using std::size_t;
+using std::string;
+using std::vector;
+
+/**
+ * @brief An expression of a record file
+ */
+struct input_record {
+  size_t number = 0; // The number of the record, from 1
+  size_t line = 0;   // The line it is on, from 1
+  string text;       // The expression
+};
+
+/**
+ * @brief Reads records from a stream in blocks, without loading the stream.
+ *
+ * Every line is a record, and so is every part of a line between `;`;
+ * blank records are skipped but still counted as lines. A record keeps its
+ * text as it is, the lexical analyzer normalizes it like a file.
+ */
+class record_reader {
+public:
+  /**
+   * @brief Construct a new reader
+   * @param in The stream
+   */
+  explicit record_reader(istream &in) : _in(in) {}
+
+  /**
+   * @brief Read the next records
+   * @param records The records, overwritten from the front; the vector only
+   * grows, so the texts keep their capacity between blocks
+   * @param count The maximum number of records
+   * @return The number of records read, 0 at the end of the stream
+   */
+  size_t read(vector<input_record> &records, size_t count);
+
+  /**
+   * @brief Judge if the stream failed while it was read
+   * @return true Reading failed
+   * @return false The stream was read to its end, or is still being read
+   */
+  inline bool failed() const { return _in.bad(); }
+
+private:
+  /**
+   * @brief Judge if a record has nothing but blanks
+   * @param begin The first character
+   * @param end Past the last character
+   * @return true The record is blank
+   * @return false There is an expression
+   */
+  static bool is_blank(const char *begin, const char *end);
+
+private:
+  istream &_in;             // The stream
+  string _line;             // The current line
+  size_t _position = 0;     // The start of the next record in the line
+  bool _in_line = false;    // Records of the current line are left
+  size_t _line_number = 0;  // The number of the current line
+  size_t _record_count = 0; // Records read so far
+};
+
+#endif // LIB_7CXX_RECORD_READER_H
@@ -0,0 +1,34 @@
+#include "regex_pattern.h"
+
+#define REGEX_DEFINE(var_name, param_name)                                     \
+  const regex var_name(param_name, std::regex::icase)
+
+REGEX_DEFINE(reg_letter, regstr_letter);
+REGEX_DEFINE(reg_digit, regstr_digit);
+REGEX_DEFINE(reg_semi, regstr_semi);
+REGEX_DEFINE(reg_paren, regstr_paren);
+REGEX_DEFINE(reg_identifier, regstr_identifier);
+REGEX_DEFINE(reg_unsigned, regstr_unsigned);
+REGEX_DEFINE(reg_const_define, regstr_const_define);
+REGEX_DEFINE(reg_const_declare, regstr_const_declare);
+REGEX_DEFINE(reg_variable, regstr_variable);
+REGEX_DEFINE(reg_procedure_header, regstr_procedure_header);
+REGEX_DEFINE(reg_procedure_declaration, regstr_procedure_declaration);
+REGEX_DEFINE(reg_operator_plus, regstr_operator_plus);
+REGEX_DEFINE(reg_operator_times, regstr_operator_times);
+REGEX_DEFINE(reg_operator_relation, regstr_operator_relation);
+REGEX_DEFINE(reg_factor, regstr_factor);
+REGEX_DEFINE(reg_item, regstr_item);
+REGEX_DEFINE(reg_expression, regstr_expression);
+REGEX_DEFINE(reg_assign, regstr_assign);
+REGEX_DEFINE(reg_operator_assign, regstr_operator_assign);
+REGEX_DEFINE(reg_condition_expression, regstr_condition_expression);
+REGEX_DEFINE(reg_if, regstr_if);
+REGEX_DEFINE(reg_procedure_call, regstr_procedure_call);
+REGEX_DEFINE(reg_while, regstr_while);
+REGEX_DEFINE(reg_read, regstr_read);
+REGEX_DEFINE(reg_write, regstr_write);
+REGEX_DEFINE(reg_compound, regstr_compound);
+REGEX_DEFINE(reg_sentence, regstr_sentence);
+REGEX_DEFINE(reg_sub_program, regstr_sub_program);
+REGEX_DEFINE(reg_program, regstr_program);
@@ -267,40 +267,39 @@ inline void print_all_patterns() {
 
 /**
  * Here are the regex objects constructed with the regex pattern strings
- * declared earlier. All objects are case insensitive.
+ * declared earlier. All objects are case insensitive. They are defined once
+ * in regex_pattern.cpp, so a translation unit including this header does
+ * not construct its own copies at startup.
  */
 
-#define REGEX_DEFINE(var_name, param_name)                                     \
-  const regex var_name(param_name, std::regex::icase)
-
-REGEX_DEFINE(reg_letter, regstr_letter);
-REGEX_DEFINE(reg_digit, regstr_digit);
-REGEX_DEFINE(reg_semi, regstr_semi);
-REGEX_DEFINE(reg_paren, regstr_paren);
-REGEX_DEFINE(reg_identifier, regstr_identifier);
-REGEX_DEFINE(reg_unsigned, regstr_unsigned);
-REGEX_DEFINE(reg_const_define, regstr_const_define);
-REGEX_DEFINE(reg_const_declare, regstr_const_declare);
-REGEX_DEFINE(reg_variable, regstr_variable);
-REGEX_DEFINE(reg_procedure_header, regstr_procedure_header);
-REGEX_DEFINE(reg_procedure_declaration, regstr_procedure_declaration);
-REGEX_DEFINE(reg_operator_plus, regstr_operator_plus);
-REGEX_DEFINE(reg_operator_times, regstr_operator_times);
-REGEX_DEFINE(reg_operator_relation, regstr_operator_relation);
-REGEX_DEFINE(reg_factor, regstr_factor);
-REGEX_DEFINE(reg_item, regstr_item);
-REGEX_DEFINE(reg_expression, regstr_expression);
-REGEX_DEFINE(reg_assign, regstr_assign);
-REGEX_DEFINE(reg_operator_assign, regstr_operator_assign);
-REGEX_DEFINE(reg_condition_expression, regstr_condition_expression);
-REGEX_DEFINE(reg_if, regstr_if);
-REGEX_DEFINE(reg_procedure_call, regstr_procedure_call);
-REGEX_DEFINE(reg_while, regstr_while);
-REGEX_DEFINE(reg_read, regstr_read);
-REGEX_DEFINE(reg_write, regstr_write);
-REGEX_DEFINE(reg_compound, regstr_compound);
-REGEX_DEFINE(reg_sentence, regstr_sentence);
-REGEX_DEFINE(reg_sub_program, regstr_sub_program);
-REGEX_DEFINE(reg_program, regstr_program);
+extern const regex reg_letter;
+extern const regex reg_digit;
+extern const regex reg_semi;
+extern const regex reg_paren;
+extern const regex reg_identifier;
+extern const regex reg_unsigned;
+extern const regex reg_const_define;
+extern const regex reg_const_declare;
+extern const regex reg_variable;
+extern const regex reg_procedure_header;
+extern const regex reg_procedure_declaration;
+extern const regex reg_operator_plus;
+extern const regex reg_operator_times;
+extern const regex reg_operator_relation;
+extern const regex reg_factor;
+extern const regex reg_item;
+extern const regex reg_expression;
+extern const regex reg_assign;
+extern const regex reg_operator_assign;
+extern const regex reg_condition_expression;
+extern const regex reg_if;
+extern const regex reg_procedure_call;
+extern const regex reg_while;
+extern const regex reg_read;
+extern const regex reg_write;
+extern const regex reg_compound;
+extern const regex reg_sentence;
+extern const regex reg_sub_program;
+extern const regex reg_program;
 
 #endif //LIB_2CXX_REGEX_PATTERN_H
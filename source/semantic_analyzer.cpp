@@ -1,20 +1,160 @@
 #include "semantic_analyzer.h"
 #include "str_opekit.h"
 
+#include <climits>
 #include <memory>
+#include <stdexcept>
 #include <unordered_map>
 
 using std::make_shared;
 using std::unordered_map;
 
-// calculate the result of expression
-int semantic_analyzer::evaluate_node(shared_ptr<ASTNode> node) {
-  if (node->get_left() == nullptr && node->get_right() == nullptr) {
+const size_t semantic_analyzer::default_cutoff;
+const size_t semantic_analyzer::max_fork_depth;
+const size_t semantic_analyzer::max_recursion_depth;
+
+ASTNode::~ASTNode() {
+  release(std::move(_left));
+  release(std::move(_right));
+}
+
+void ASTNode::release(shared_ptr<ASTNode> root) {
+  while (root) {
+    // a node shared with another tree is not destroyed here
+    if (root.use_count() > 1) {
+      return;
+    }
+    if (root->_left && root->_left.use_count() == 1) {
+      shared_ptr<ASTNode> left = std::move(root->_left);
+      root->_left = std::move(left->_right);
+      left->_right = std::move(root);
+      root = std::move(left);
+    } else {
+      root->_left.reset();
+      shared_ptr<ASTNode> right = std::move(root->_right);
+      root = std::move(right);
+    }
+  }
+}
+
+// calculate the result of expression, recursion is the fastest walk of a
+// shallow tree, the subtrees deeper than `max_recursion_depth` are handed to
+// the walk with the work stack
+int semantic_analyzer::evaluate_node(const ASTNode *node,
+                                     vector<work_item> &work, size_t depth) {
+  if (node->get_left() == nullptr) {
     return node->get_val();
   }
-  int left_val = evaluate_node(node->get_left());
-  int right_val = evaluate_node(node->get_right());
-  switch (node->get_op()) {
+  if (depth >= max_recursion_depth) {
+    return evaluate_deep(node, work);
+  }
+  int left_val = evaluate_node(node->get_left().get(), work, depth + 1);
+  int right_val = evaluate_node(node->get_right().get(), work, depth + 1);
+  return apply_operator(node->get_op(), left_val, right_val);
+}
+
+// calculate the result of expression: walk down the left children to a leaf,
+// then climb up, keeping the value of a left subtree while its right sibling
+// is evaluated
+int semantic_analyzer::evaluate_deep(const ASTNode *node,
+                                     vector<work_item> &work) {
+  // the stack is indexed by a local, so the loop keeps its top in registers
+  size_t size = 0;
+  const ASTNode *current = node;
+  for (;;) {
+    while (current->get_left() != nullptr) {
+      if (size == work.size()) {
+        work.resize(2 * size + 64);
+      }
+      work[size++] = {current, 0, false};
+      current = current->get_left().get();
+    }
+    int value = current->get_val();
+
+    for (;;) {
+      if (size == 0) {
+        return value;
+      }
+      work_item &top = work[size - 1];
+      if (top.expanded) {
+        // both subtrees are done
+        value = apply_operator(top.node->get_op(), top.left_val, value);
+        --size;
+        continue;
+      }
+
+      const ASTNode *right = top.node->get_right().get();
+      if (right->get_left() == nullptr) {
+        // a leaf on the right needs no visit of its own
+        value = apply_operator(top.node->get_op(), value, right->get_val());
+        --size;
+        continue;
+      }
+      top.expanded = true;
+      top.left_val = value;
+      current = right;
+      break;
+    }
+  }
+}
+
+// calculate the result of expression, the left subtree of a node whose
+// subtrees are both big is forked and the right one is evaluated by the
+// current thread; below a node with one big subtree the small one is
+// evaluated at once and the big one is walked into without recursion
+int semantic_analyzer::evaluate_node(const ASTNode *node, thread_pool &pool,
+                                     size_t cutoff, size_t depth) {
+  // the operators and the values of the small sides passed on the way down
+  struct pending {
+    char op;         // The operator
+    int value;       // The value of the small subtree
+    bool value_left; // Whether the small subtree is the left operand
+  };
+  vector<pending> chain;
+  vector<work_item> work;
+
+  int result;
+  for (;;) {
+    if (node->get_size() < cutoff || depth >= max_fork_depth) {
+      result = evaluate_node(node, work, 0);
+      break;
+    }
+    const ASTNode *left = node->get_left().get();
+    const ASTNode *right = node->get_right().get();
+    bool left_big = left->get_size() >= cutoff;
+    bool right_big = right->get_size() >= cutoff;
+
+    if (left_big && right_big) {
+      int left_val = 0;
+      task_group group(pool);
+      group.run([&left_val, left, &pool, cutoff, depth]() {
+        left_val = evaluate_node(left, pool, cutoff, depth + 1);
+      });
+      int right_val = evaluate_node(right, pool, cutoff, depth + 1);
+      group.wait();
+      result = apply_operator(node->get_op(), left_val, right_val);
+      break;
+    }
+    if (left_big) {
+      chain.push_back(
+          {node->get_op(), evaluate_node(right, work, 0), false});
+      node = left;
+    } else {
+      chain.push_back({node->get_op(), evaluate_node(left, work, 0), true});
+      node = right;
+    }
+  }
+
+  for (size_t index = chain.size(); index-- > 0;) {
+    const pending &step = chain[index];
+    result = step.value_left ? apply_operator(step.op, step.value, result)
+                             : apply_operator(step.op, result, step.value);
+  }
+  return result;
+}
+
+int semantic_analyzer::apply_operator(char op, int left_val, int right_val) {
+  switch (op) {
   case '+':
     return left_val + right_val;
   case '-':
@@ -22,9 +162,15 @@ int semantic_analyzer::evaluate_node(shared_ptr<ASTNode> node) {
   case '*':
     return left_val * right_val;
   case '/':
+    if (right_val == 0) {
+      throw std::domain_error("Division by zero");
+    }
+    if (left_val == INT_MIN && right_val == -1) {
+      return INT_MIN;
+    }
     return left_val / right_val;
   default:
-    throw std::logic_error(string("unexpected operator") + node->get_op());
+    throw std::logic_error(string("unexpected operator") + op);
   }
 }
 
@@ -33,40 +179,31 @@ std::unordered_map<std::string, int> priority = {
     {"+", 1}, {"-", 1}, {"*", 2}, {"/", 2}};
 
 void semantic_analyzer::construct_tree(vector<string> &tokens) {
-  stack<shared_ptr<ASTNode>> nodeStack; // operand stack
-  stack<char> opStack;                  // operatod stack
+  _node_stack.clear(); // operand stack
+  _op_stack.clear();   // operatod stack
 
   // itetate tokens
   for (auto &token : tokens) {
     if (is_all_whitespace(token)) {
-      shared_ptr<ASTNode> node(new ASTNode(' ', 0, nullptr, nullptr));
-      nodeStack.push(node);
+      _node_stack.push_back(make_node(' ', 0));
     }
     // If it is an operand, construct an ASTNode and push into operand stack
     else if (is_digit(token)) {
       int val = stoi(token);
-      nodeStack.push(make_shared<ASTNode>(' ', val));
+      _node_stack.push_back(make_node(' ', val));
     }
     // If it is a left paren, push it into operator stack
     else if (token == "(") {
-      opStack.push('(');
+      _op_stack.push_back('(');
     }
     // If it is a right paren, pop the operator in the operator stack and
     // calculate result
     else if (token == ")") {
       // Keep popping operatos in the operator stack until a left paren
-      while (opStack.top() != '(') {
-        // Pop two operands in the operand stack and construct them into a node
-        shared_ptr<ASTNode> right = nodeStack.top();
-        nodeStack.pop();
-        shared_ptr<ASTNode> left = nodeStack.top();
-        nodeStack.pop();
-        // Construct a new ASTNode with the two nodes and push into the stack
-        shared_ptr<ASTNode> node(new ASTNode(opStack.top(), 0, left, right));
-        opStack.pop();
-        nodeStack.push(node);
+      while (_op_stack.back() != '(') {
+        reduce_top();
       }
-      opStack.pop(); // pop left paren
+      _op_stack.pop_back(); // pop left paren
     }
       // If it is #
     else if (token == "#") {
@@ -75,37 +212,50 @@ void semantic_analyzer::construct_tree(vector<string> &tokens) {
     // If it is an operator, compare its priority with the operator on the top
     // of the stack
     else {
+      // the grammar accepts identifiers, but they have no value to evaluate
+      if (token.size() != 1 || priority.count(token) == 0) {
+        throw std::invalid_argument("no value for " + token);
+      }
       char op = token[0];
-      while (!opStack.empty() && opStack.top() != '(' &&
-             priority[string(1, opStack.top())] >= priority[string(1, op)]) {
-        // Pop two operands in the stack and construct them into an ASTNode
-        shared_ptr<ASTNode> right = nodeStack.top();
-        nodeStack.pop();
-        shared_ptr<ASTNode> left = nodeStack.top();
-        nodeStack.pop();
-        // Construct a new ASTNode with the two nodes and push it into the
-        // operand stack
-        shared_ptr<ASTNode> node =
-            make_shared<ASTNode>(opStack.top(), 0, left, right);
-        opStack.pop();
-        nodeStack.push(node);
+      while (!_op_stack.empty() && _op_stack.back() != '(' &&
+             priority[string(1, _op_stack.back())] >= priority[string(1, op)]) {
+        reduce_top();
       }
-      opStack.push(op);
+      _op_stack.push_back(op);
     }
   }
 
   // Process operators and operands in the stack and construct the tree
-  while (!opStack.empty()) {
-    shared_ptr<ASTNode> right = nodeStack.top();
-    nodeStack.pop();
-    shared_ptr<ASTNode> left = nodeStack.top();
-    nodeStack.pop();
-    shared_ptr<ASTNode> node =
-        make_shared<ASTNode>(opStack.top(), 0, left, right);
-    opStack.pop();
-    nodeStack.push(node);
+  while (!_op_stack.empty()) {
+    reduce_top();
   }
 
-  this->_root = nodeStack.top();
-  nodeStack.pop();
+  this->_root = _node_stack.back();
+  _node_stack.pop_back();
+}
+
+void semantic_analyzer::reduce_top() {
+  // Pop two operands in the operand stack and construct them into a node
+  shared_ptr<ASTNode> right = std::move(_node_stack.back());
+  _node_stack.pop_back();
+  shared_ptr<ASTNode> left = std::move(_node_stack.back());
+  _node_stack.pop_back();
+  // Construct a new ASTNode with the two nodes and push it into the operand
+  // stack
+  _node_stack.push_back(make_node(_op_stack.back(), 0, left, right));
+  _op_stack.pop_back();
+}
+
+shared_ptr<ASTNode> semantic_analyzer::make_node(
+    char op, int val, const shared_ptr<ASTNode> &left,
+    const shared_ptr<ASTNode> &right) {
+  if (_arena != nullptr) {
+    return std::allocate_shared<ASTNode>(arena_allocator<ASTNode>(_arena), op,
+                                         val, left, right);
+  }
+  if (_node_pool) {
+    return std::allocate_shared<ASTNode>(node_allocator<ASTNode>(_node_pool),
+                                         op, val, left, right);
+  }
+  return make_shared<ASTNode>(op, val, left, right);
 }
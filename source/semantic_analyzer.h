@@ -7,6 +7,11 @@
 #ifndef LIB_4CXX_SEMANTIC_ANALYSIS_H
 #define LIB_4CXX_SEMANTIC_ANALYSIS_H
 
+#include "arena.h"
+#include "node_pool.h"
+#include "thread_pool.h"
+
+#include <cstddef>
 #include <iostream>
 #include <memory>
 #include <stack>
@@ -16,6 +21,7 @@
 
 using std::pair;
 using std::shared_ptr;
+using std::size_t;
 using std::stack;
 using std::string;
 using std::vector;
@@ -33,7 +39,8 @@ public:
    * @param right The right child of node
    */
   ASTNode(char op, int val, ASTNode *left = nullptr, ASTNode *right = nullptr)
-      : _op(op), _val(val), _left(left), _right(right) {}
+      : _op(op), _val(val), _left(left), _right(right),
+        _size(subtree_size(_left, _right)) {}
 
   /**
    * @brief Construct a new ASTNode object
@@ -44,7 +51,18 @@ public:
    */
   ASTNode(char op, int val, const shared_ptr<ASTNode> &left,
           const shared_ptr<ASTNode> &right)
-      : _op(op), _val(val), _left(left), _right(right) {}
+      : _op(op), _val(val), _left(left), _right(right),
+        _size(subtree_size(_left, _right)) {}
+
+  ASTNode(const ASTNode &) = delete;
+
+  ASTNode &operator=(const ASTNode &) = delete;
+
+  /**
+   * @brief Destroy the ASTNode object. The nodes only this one owns are
+   * released without recursion, so a tree of any depth can be destroyed
+   */
+  ~ASTNode();
 
   /**
    * @brief Get the operator
@@ -62,19 +80,46 @@ public:
    * @brief Get the left child node
    * @return The left child node
    */
-  inline shared_ptr<ASTNode> get_left() const { return _left; }
+  inline const shared_ptr<ASTNode> &get_left() const { return _left; }
 
   /**
    * @brief Get the right child node
    * @return The right child node
    */
-  inline shared_ptr<ASTNode> get_right() const { return _right; }
+  inline const shared_ptr<ASTNode> &get_right() const { return _right; }
+
+  /**
+   * @brief Get the number of nodes in the subtree rooted at this node
+   * @return The size of the subtree, computed once at construction
+   */
+  inline size_t get_size() const { return _size; }
+
+private:
+  /**
+   * @brief Release a subtree without recursion: a left child owned by the
+   * subtree alone is rotated up until the root has none, then the root is
+   * destroyed, having no children left, and its right child takes its place
+   * @param root The subtree
+   */
+  static void release(shared_ptr<ASTNode> root);
+
+  /**
+   * @brief Compute the size of a subtree from its children
+   * @param left The left child node
+   * @param right The right child node
+   * @return The size of the subtree
+   */
+  static inline size_t subtree_size(const shared_ptr<ASTNode> &left,
+                                    const shared_ptr<ASTNode> &right) {
+    return 1 + (left ? left->_size : 0) + (right ? right->_size : 0);
+  }
 
 private:
   char _op;                   // operator
   int _val;                   // operand
   shared_ptr<ASTNode> _left;  // left child node
   shared_ptr<ASTNode> _right; // right child node
+  size_t _size;               // number of nodes in the subtree
 };
 
 class semantic_analyzer {
@@ -102,35 +147,172 @@ public:
   void construct_tree(vector<string> &tokens);
 
   /**
-   * @brief Evaluate the AST
+   * @brief Evaluate the AST. The recursion is at most `max_recursion_depth`
+   * deep, deeper subtrees are walked with a work stack
    * @return The result of the expression
    */
-  inline int evaluate() { return evaluate_node(this->_root); }
+  inline int evaluate() {
+    return evaluate_node(this->_root.get(), _work, 0);
+  }
+
+  /**
+   * @brief Evaluate the AST with fork-join parallelism. Subtrees with at least
+   * `cutoff` nodes are split into tasks, smaller ones are evaluated serially.
+   * A chain of nodes with one big child is walked down in a loop, and tasks
+   * are nested at most `max_fork_depth` deep, so the stack of a thread stays
+   * small whatever the shape of the tree. The result always equals the one
+   * of `evaluate`.
+   * @param pool The work-stealing pool which runs the tasks
+   * @param cutoff The minimum subtree size of a task
+   * @return The result of the expression
+   */
+  inline int evaluate(thread_pool &pool, size_t cutoff = default_cutoff) {
+    return evaluate_node(this->_root.get(), pool, cutoff < 2 ? 2 : cutoff, 0);
+  }
 
   /**
    * @brief Get the root node
    * @return The root of the AST
    */
-  inline shared_ptr<ASTNode> get_root() const { return this->_root; }
+  inline const shared_ptr<ASTNode> &get_root() const { return this->_root; }
+
+  /**
+   * @brief Draw the nodes of the trees from a pool instead of the heap. The
+   * pool keeps the memory of released trees for the next ones, so building a
+   * tree no bigger than an earlier one does not allocate.
+   * @param pooled Whether to use a pool
+   */
+  inline void set_node_pool(bool pooled) {
+    _node_pool = pooled ? std::make_shared<node_pool>() : nullptr;
+  }
+
+  /**
+   * @brief Take the nodes of the trees from an arena, until another one is
+   * set; the arena comes before the pool. A tree must be released before its
+   * arena is reset.
+   * @param memory The arena, or null
+   */
+  inline void set_arena(arena *memory) { _arena = memory; }
+
+  /**
+   * @brief Clear the AST, and the nodes left on the stack by a failed
+   * construction
+   */
+  inline void clear() {
+    this->_root.reset();
+    _node_stack.clear();
+  }
+
+  /**
+   * @brief The default subtree size below which evaluation stays serial
+   */
+  static const size_t default_cutoff = 1 << 14;
+
+  /**
+   * @brief The deepest nesting of tasks, subtrees below it are evaluated
+   * serially
+   */
+  static const size_t max_fork_depth = 64;
 
   /**
-   * @brief Clear the AST
+   * @brief The deepest recursion of the serial evaluation, deeper subtrees
+   * are walked with a work stack
    */
-  inline void clear() { this->_root.reset(); }
+  static const size_t max_recursion_depth = 1 << 10;
 
 private:
   /**
-   * @brief Evaluate the node
-   * @param node
+   * @brief A node on the work stack of the postorder traversal
+   */
+  struct work_item {
+    const ASTNode *node; // The node
+    int left_val;        // The value of the left subtree, once it is done
+    bool expanded;       // Whether its left subtree is done
+  };
+
+  /**
+   * @brief Evaluate a subtree by recursion, down to `max_recursion_depth`
+   * @param node The root of the subtree
+   * @param work The work stack of the deeper subtrees
+   * @param depth The depth of the node below the root of the evaluation
    * @return The result of the expression
    */
-  int evaluate_node(shared_ptr<ASTNode> node);
+  static int evaluate_node(const ASTNode *node, vector<work_item> &work,
+                           size_t depth);
+
+  /**
+   * @brief Evaluate a subtree in postorder with a work stack
+   * @param node The root of the subtree
+   * @param work The work stack, its capacity is reused
+   * @return The result of the expression
+   */
+  static int evaluate_deep(const ASTNode *node, vector<work_item> &work);
+
+  /**
+   * @brief Evaluate the node, forking the left subtree when both subtrees are
+   * big enough
+   * @param node The node
+   * @param pool The pool which runs the tasks
+   * @param cutoff The minimum subtree size of a task
+   * @param depth The tasks the node is nested in
+   * @return The result of the expression
+   */
+  static int evaluate_node(const ASTNode *node, thread_pool &pool,
+                           size_t cutoff, size_t depth);
+
+  /**
+   * @brief Apply a binary operator
+   * @param op The operator
+   * @param left_val The left operand
+   * @param right_val The right operand
+   * @return The result
+   * @throw std::domain_error Division by zero
+   */
+  static int apply_operator(char op, int left_val, int right_val);
+
+  /**
+   * @brief Pop two operands and the operator on top of the stacks, and push
+   * the node combining them
+   */
+  void reduce_top();
+
+  /**
+   * @brief Create a node, from the arena or the pool if there is one
+   * @param op Operator
+   * @param val The value of the node
+   * @param left The left child of node
+   * @param right The right child of node
+   * @return The node
+   */
+  shared_ptr<ASTNode> make_node(char op, int val,
+                                const shared_ptr<ASTNode> &left = nullptr,
+                                const shared_ptr<ASTNode> &right = nullptr);
 
 private:
   /**
    * @brief The root of the AST
    */
   shared_ptr<ASTNode> _root;
+  /**
+   * @brief The pool of the nodes, null if they come from the heap
+   */
+  shared_ptr<node_pool> _node_pool;
+  /**
+   * @brief The arena of the nodes, null if there is none
+   */
+  arena *_arena = nullptr;
+  /**
+   * @brief Operand stack of `construct_tree`, keeps its capacity
+   */
+  vector<shared_ptr<ASTNode>> _node_stack;
+  /**
+   * @brief Operator stack of `construct_tree`, keeps its capacity
+   */
+  vector<char> _op_stack;
+  /**
+   * @brief Work stack of `evaluate`, keeps its capacity
+   */
+  vector<work_item> _work;
 };
 
 #endif // LIB_4CXX_SEMANTIC_ANALYSIS_H
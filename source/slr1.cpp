@@ -23,7 +23,7 @@ const vector<pair<string, size_t>> grammars = {{"start", 1},
                                                {"times-operator", 1},
                                                {"times-operator", 1}};
 
-bool slr1::parse_lexeme(const pair<const string, const string> &lexeme) {
+bool slr1::parse_lexeme(const lexical_pair &lexeme) {
   int col_index = -1;
 
   if (lexeme.first == "ident") {
@@ -60,13 +60,15 @@ bool slr1::parse_lexeme(const pair<const string, const string> &lexeme) {
 
   // shift in
   if (type == action_type::shift_in) {
+    PL0_METRIC(++_shift_count);
     _status_stack.push(next_row);
     return true;
   }
   // reduction
   else if (type == action_type::reduction) {
-    pair<string, size_t> grammar_item = grammars[next_row];
-    string grammar = grammar_item.first;
+    PL0_METRIC(++_reduction_count);
+    const pair<string, size_t> &grammar_item = grammars[next_row];
+    const string &grammar = grammar_item.first;
     for (size_t count = 0; count < grammar_item.second; ++count) {
       _status_stack.pop();
     }
@@ -102,11 +104,14 @@ bool slr1::parse_lexeme(const pair<const string, const string> &lexeme) {
   }
 }
 
-bool slr1::parse(list<lexical_pair> &list) {
+bool slr1::parse(lexical_list &list) {
   clear();
 
   auto &parsed_text = list;
-  parsed_text.push_back({"acc", "#"});
+  // a list whose nodes are reused may carry the marker already
+  if (parsed_text.empty() || parsed_text.back().first != "acc") {
+    parsed_text.push_back({"acc", "#"});
+  }
 
   _status_stack.push(0);
 
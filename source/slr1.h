@@ -9,16 +9,19 @@
 
 #include "analysis_table.h"
 #include "lexical_analyzer.h"
+#include "metrics.h"
 
 #include <fstream>
 #include <stack>
 #include <string>
 #include <utility>
+#include <vector>
 
 using std::ifstream;
 using std::pair;
 using std::stack;
 using std::string;
+using std::vector;
 
 /**
  * @brief SLR(1) analyzer
@@ -36,6 +39,13 @@ class slr1 {
 
   slr1() = default;
 
+  /**
+   * @brief Construct a parser with the analysis table in a csv file
+   *
+   * @param table_file The name of the csv file
+   */
+  explicit slr1(const string &table_file) : _table(table_file) {}
+
   slr1(const slr1 &) = delete;
 
   ~slr1() = default;
@@ -43,10 +53,12 @@ class slr1 {
   /**
    * @brief Parse expression
    *
+   * @param list The lexemes, the end marker `{"acc", "#"}` is appended
+   * unless the list already ends with it
    * @return true The expression is valid
    * @return false The expression is invalid
    */
-  bool parse(list<lexical_pair> &);
+  bool parse(lexical_list &list);
 
   /**
    * @brief Reset the parser's status
@@ -57,8 +69,26 @@ class slr1 {
     }
 
     _grammar_status = grammar_judgement::not_sure;
+    _shift_count = 0;
+    _reduction_count = 0;
   }
 
+  /**
+   * @brief Get the number of shifts of the last parse, counted only in builds
+   * with metrics
+   *
+   * @return size_t The number of shifts
+   */
+  inline size_t get_shift_count() const { return _shift_count; }
+
+  /**
+   * @brief Get the number of reductions of the last parse, counted only in
+   * builds with metrics
+   *
+   * @return size_t The number of reductions
+   */
+  inline size_t get_reduction_count() const { return _reduction_count; }
+
  private:
   /**
    * @brief Parse expression's lexemes
@@ -67,14 +97,16 @@ class slr1 {
    * @return true The parser should analyze the next lexeme
    * @return false The parser should not analyze the next lexeme
    */
-  bool parse_lexeme(const pair<const Token, const Lexeme> &lexeme);
+  bool parse_lexeme(const lexical_pair &lexeme);
 
  private:
   typedef unsigned int line_number;
 
   analysis_table _table;
-  stack<line_number> _status_stack;
+  stack<line_number, vector<line_number>> _status_stack; // keeps capacity
   grammar_judgement _grammar_status = grammar_judgement::not_sure;
+  size_t _shift_count = 0;     // shifts of the last parse
+  size_t _reduction_count = 0; // reductions of the last parse
 };
 
 #endif // LIB_3CXX_SLR1_H
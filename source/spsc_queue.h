@@ -0,0 +1,214 @@
+/**
+ * @file spsc_queue.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Bounded lock-free single-producer/single-consumer queue
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_SPSC_QUEUE_H
+#define LIB_7CXX_SPSC_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::size_t;
+using std::vector;
+
+/**
+ * @brief A ring buffer shared by exactly one producer thread and one consumer
+ * thread.
+ *
+ * The producer only writes `_tail` and the consumer only writes `_head`, so
+ * no lock or read-modify-write is needed: an acquire load of the other side's
+ * index tells how far it is safe to go. Each side also caches the last index
+ * it read from the other side and reloads it only when the cached one says
+ * the queue is full (or empty), which keeps the two cache lines from bouncing
+ * between the cores on every operation.
+ *
+ * The indices are kept a cache line apart by padding rather than `alignas`,
+ * which a queue made with `new` would not honor before C++17.
+ *
+ * `push` and `pop` wait for room or for an element: they spin for a while,
+ * then park on a condition variable. A side raises its flag before it
+ * parks, and the other side takes the lock and wakes it only when it sees
+ * the flag, so the operations which need not wait never lock.
+ *
+ * @tparam T The type of the elements, copied in and out of the slots
+ */
+template <typename T> class spsc_queue {
+public:
+  /**
+   * @brief Construct a new queue
+   * @param capacity The least number of elements it can hold, rounded up to
+   * a power of two
+   */
+  explicit spsc_queue(size_t capacity)
+      : _head(0), _tail(0), _cached_head(0), _cached_tail(0),
+        _producer_waiting(false), _consumer_waiting(false) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    _slots.resize(size);
+    _mask = size - 1;
+  }
+
+  spsc_queue(const spsc_queue &) = delete;
+
+  spsc_queue &operator=(const spsc_queue &) = delete;
+
+  /**
+   * @brief Push an element, called by the producer only
+   * @param value The element
+   * @return true The element is pushed
+   * @return false The queue is full
+   */
+  bool try_push(const T &value) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _cached_head == _slots.size()) {
+      _cached_head = _head.load(std::memory_order_acquire);
+      if (tail - _cached_head == _slots.size()) {
+        return false;
+      }
+    }
+
+    _slots[tail & _mask] = value;
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Pop an element, called by the consumer only
+   * @param value The popped element
+   * @return true An element is popped
+   * @return false The queue is empty
+   */
+  bool try_pop(T &value) {
+    size_t head = _head.load(std::memory_order_relaxed);
+    if (head == _cached_tail) {
+      _cached_tail = _tail.load(std::memory_order_acquire);
+      if (head == _cached_tail) {
+        return false;
+      }
+    }
+
+    value = _slots[head & _mask];
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Push an element, waiting while the queue is full, called by the
+   * producer only
+   * @param value The element
+   * @return true The push had to wait
+   * @return false The element is pushed at once
+   */
+  bool push(const T &value) {
+    bool waited = false;
+    if (!try_push(value)) {
+      waited = true;
+      wait_until([this, &value]() { return try_push(value); },
+                 _producer_waiting);
+    }
+    wake(_consumer_waiting);
+    return waited;
+  }
+
+  /**
+   * @brief Pop an element, waiting while the queue is empty, called by the
+   * consumer only
+   * @param value The popped element
+   * @return true The pop had to wait
+   * @return false The element is popped at once
+   */
+  bool pop(T &value) {
+    bool waited = false;
+    if (!try_pop(value)) {
+      waited = true;
+      wait_until([this, &value]() { return try_pop(value); },
+                 _consumer_waiting);
+    }
+    wake(_producer_waiting);
+    return waited;
+  }
+
+  /**
+   * @brief Get the number of elements the queue can hold
+   * @return The capacity
+   */
+  inline size_t capacity() const { return _slots.size(); }
+
+private:
+  /**
+   * @brief Retry an operation until it succeeds, spinning first and parking
+   * after `spin_limit` failures
+   * @param done The operation, true when it succeeds
+   * @param waiting The flag of the side which waits
+   */
+  template <typename F> void wait_until(F done, std::atomic<bool> &waiting) {
+    for (int spin = 0; spin < spin_limit; ++spin) {
+      std::this_thread::yield();
+      if (done()) {
+        return;
+      }
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    waiting.store(true, std::memory_order_relaxed);
+    // pairs with the fence in `wake`: either the retry below sees the other
+    // side's move, or the other side sees the flag and wakes this one
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!done()) {
+      _changed.wait(lock);
+    }
+    waiting.store(false, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Wake the other side if it is parked
+   * @param waiting The flag of the other side
+   */
+  void wake(std::atomic<bool> &waiting) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_relaxed)) {
+      // the other side holds the lock until it waits, so it cannot miss this
+      std::lock_guard<std::mutex> lock(_mutex);
+      _changed.notify_one();
+    }
+  }
+
+private:
+  /**
+   * @brief The size of a cache line, fields this far apart never share one
+   */
+  static const size_t cache_line = 64;
+
+  /**
+   * @brief The failed retries of `push` and `pop` before they park
+   */
+  static const int spin_limit = 64;
+
+  vector<T> _slots; // The ring buffer
+  size_t _mask = 0; // `capacity() - 1`
+
+  char _padding0[cache_line];
+  std::atomic<size_t> _head; // Next slot to pop, by the consumer
+  char _padding1[cache_line - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> _tail; // Next slot to push, by the producer
+  char _padding2[cache_line - sizeof(std::atomic<size_t>)];
+  size_t _cached_head; // `_head` as last seen by producer
+  char _padding3[cache_line - sizeof(size_t)];
+  size_t _cached_tail; // `_tail` as last seen by consumer
+  char _padding4[cache_line - sizeof(size_t)];
+
+  std::atomic<bool> _producer_waiting; // The producer is parked
+  std::atomic<bool> _consumer_waiting; // The consumer is parked
+  std::mutex _mutex;                   // Guards parking
+  std::condition_variable _changed;    // Signaled when a side moved
+};
+
+#endif // LIB_7CXX_SPSC_QUEUE_H
@@ -0,0 +1,18 @@
+#include "symbol_table.h"
+
+symbol *symbol_table::declare(identifier_id name, const symbol &declared) {
+  open_hash_map<identifier_id, symbol> &scope = _scopes[_depth - 1];
+  if (!scope.emplace(name, declared)) {
+    return nullptr;
+  }
+  return scope.find(name);
+}
+
+const symbol *symbol_table::lookup(identifier_id name) const {
+  for (size_t depth = _depth; depth > 0; --depth) {
+    if (const symbol *found = _scopes[depth - 1].find(name)) {
+      return found;
+    }
+  }
+  return nullptr;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file symbol_table.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Scoped table of the constants, variables and procedures of PL/0
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_SYMBOL_TABLE_H
+#define LIB_7CXX_SYMBOL_TABLE_H
+
+#include "identifier_interner.h"
+#include "open_hash_map.h"
+
+#include <cstddef>
+#include <vector>
+
+using std::size_t;
+using std::vector;
+
+/**
+ * @brief The kind of a declared name
+ */
+enum symbol_kind {
+  symbol_constant, // A constant, with its value
+  symbol_variable, // A variable, with its address in the frame
+  symbol_procedure // A procedure, with the address of its code
+};
+
+/**
+ * @brief A declared name
+ */
+struct symbol {
+  symbol_kind kind = symbol_constant; // What it names
+  int level = 0;                      // The level it is declared at
+  int value = 0;                      // The value, the address or the
+                                      // code address
+};
+
+/**
+ * @brief Symbols of nested blocks, looked up by interned identifier.
+ *
+ * Every open scope is an `open_hash_map` from ids to symbols. Pushing a
+ * scope takes the next map and popping one clears it, both in O(1), and the
+ * maps keep their slots for the next block at that depth. A lookup probes
+ * the scopes from the innermost one outwards, so an inner declaration hides
+ * an outer one.
+ */
+class symbol_table {
+public:
+  /**
+   * @brief Open a scope inside the current one
+   */
+  inline void push_scope() {
+    if (_depth == _scopes.size()) {
+      _scopes.emplace_back();
+    }
+    ++_depth;
+  }
+
+  /**
+   * @brief Close the innermost scope, dropping its symbols
+   */
+  inline void pop_scope() { _scopes[--_depth].clear(); }
+
+  /**
+   * @brief Declare a name in the innermost scope
+   * @param name The id of the name
+   * @param declared The symbol
+   * @return The symbol in the table, valid until the next declaration in the
+   * scope; null if the name is declared in the scope already
+   */
+  symbol *declare(identifier_id name, const symbol &declared);
+
+  /**
+   * @brief Find the innermost declaration of a name
+   * @param name The id of the name
+   * @return The symbol, null if the name is not declared
+   */
+  const symbol *lookup(identifier_id name) const;
+
+  /**
+   * @brief Get the number of open scopes
+   * @return The number
+   */
+  inline size_t get_depth() const { return _depth; }
+
+  /**
+   * @brief Close all scopes, their memory is kept
+   */
+  inline void clear() {
+    while (_depth > 0) {
+      pop_scope();
+    }
+  }
+
+private:
+  vector<open_hash_map<identifier_id, symbol>> _scopes; // Outermost first
+  size_t _depth = 0; // The open scopes, the maps after them are empty
+};
+
+#endif // LIB_7CXX_SYMBOL_TABLE_H
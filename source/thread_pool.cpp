@@ -0,0 +1,166 @@
+#include "thread_pool.h"
+
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+// The pool and deque index of the calling worker thread
+static thread_local thread_pool *current_pool = nullptr;
+static thread_local size_t current_index = 0;
+
+thread_pool::thread_pool(size_t thread_count) : _pending(0), _next_queue(0) {
+  if (thread_count == 0) {
+    thread_count = std::thread::hardware_concurrency();
+  }
+  if (thread_count == 0) {
+    thread_count = 1;
+  }
+
+  for (size_t index = 0; index < thread_count; ++index) {
+    _queues.emplace_back(new worker_queue);
+  }
+  for (size_t index = 0; index < thread_count; ++index) {
+    _workers.emplace_back(&thread_pool::worker_loop, this, index);
+  }
+}
+
+thread_pool::~thread_pool() {
+  {
+    lock_guard<mutex> lock(_sleep_mutex);
+    _stopping = true;
+  }
+  _sleep_cv.notify_all();
+
+  for (auto &worker : _workers) {
+    worker.join();
+  }
+}
+
+void thread_pool::submit(task t) {
+  size_t index = local_index();
+  {
+    lock_guard<mutex> lock(_queues[index]->mutex);
+    _queues[index]->tasks.push_back(std::move(t));
+  }
+  {
+    lock_guard<mutex> lock(_sleep_mutex);
+    ++_pending;
+  }
+  _sleep_cv.notify_one();
+}
+
+bool thread_pool::run_pending_task() {
+  task t;
+  if (!pop_task(local_index(), t)) {
+    return false;
+  }
+  t();
+  return true;
+}
+
+void thread_pool::worker_loop(size_t index) {
+  current_pool = this;
+  current_index = index;
+
+  task t;
+  while (true) {
+    if (pop_task(index, t)) {
+      t();
+      t = nullptr;
+      continue;
+    }
+
+    unique_lock<mutex> lock(_sleep_mutex);
+    _sleep_cv.wait(lock, [this] { return _pending > 0 || _stopping; });
+    if (_stopping && _pending == 0) {
+      break;
+    }
+  }
+
+  current_pool = nullptr;
+}
+
+bool thread_pool::pop_task(size_t index, task &t) {
+  // the own deque, newest task first
+  {
+    worker_queue &queue = *_queues[index];
+    lock_guard<mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      t = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      --_pending;
+      return true;
+    }
+  }
+
+  // steal from the others, oldest task first
+  for (size_t offset = 1; offset < _queues.size(); ++offset) {
+    worker_queue &queue = *_queues[(index + offset) % _queues.size()];
+    lock_guard<mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      t = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      --_pending;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+size_t thread_pool::worker_index() const {
+  return current_pool == this ? current_index : _workers.size();
+}
+
+size_t thread_pool::local_index() {
+  if (current_pool == this) {
+    return current_index;
+  }
+  return _next_queue++ % _queues.size();
+}
+
+task_group::~task_group() {
+  // the tasks reference the group, so they must be finished before it dies
+  while (_unfinished > 0) {
+    if (!_pool.run_pending_task()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void task_group::run(thread_pool::task t) {
+  ++_unfinished;
+  _pool.submit([this, t]() {
+    try {
+      t();
+    } catch (...) {
+      lock_guard<mutex> lock(_error_mutex);
+      if (!_error) {
+        _error = std::current_exception();
+      }
+    }
+    --_unfinished;
+  });
+}
+
+void task_group::wait() {
+  while (_unfinished > 0) {
+    if (!_pool.run_pending_task()) {
+      std::this_thread::yield();
+    }
+  }
+
+  std::exception_ptr error;
+  {
+    lock_guard<mutex> lock(_error_mutex);
+    std::swap(error, _error);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
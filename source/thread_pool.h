@@ -0,0 +1,158 @@
+/**
+ * @file thread_pool.h
+ * @author Yuan Liu (Liuyuan\@shu.edu.cn)
+ * @brief Work-stealing thread pool and fork-join task group
+ * @date 2026-10-18
+ */
+#ifndef LIB_7CXX_THREAD_POOL_H
+#define LIB_7CXX_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::size_t;
+using std::unique_ptr;
+using std::vector;
+
+/**
+ * @brief A thread pool in which every worker owns a task deque.
+ *
+ * A worker pushes and pops its own tasks at the back of its deque (LIFO, so
+ * the most recently forked and cache-hot task runs first) and steals from the
+ * front of the other deques (FIFO, so thieves take the biggest, oldest tasks)
+ * when its own deque is empty.
+ */
+class thread_pool {
+public:
+  typedef std::function<void()> task;
+
+  /**
+   * @brief Construct a new thread pool object
+   * @param thread_count The number of workers, 0 means one per hardware thread
+   */
+  explicit thread_pool(size_t thread_count = 0);
+
+  thread_pool(const thread_pool &) = delete;
+
+  /**
+   * @brief Run the remaining tasks and join all workers
+   */
+  ~thread_pool();
+
+  /**
+   * @brief Submit a task. Tasks submitted by a worker go to its own deque,
+   * others are distributed over the deques round-robin.
+   * @param t The task
+   */
+  void submit(task t);
+
+  /**
+   * @brief Run one pending task on the calling thread, if there is any.
+   * Used by threads that wait for a result so that they help instead of block.
+   * @return true A task was run
+   * @return false No task was found
+   */
+  bool run_pending_task();
+
+  /**
+   * @brief Get the number of workers
+   * @return The number of workers
+   */
+  inline size_t size() const { return _workers.size(); }
+
+  /**
+   * @brief Get the index of the calling worker, so that a worker can keep
+   * per-thread state in a vector of `size() + 1` entries
+   * @return The index of the worker, or `size()` for threads outside the pool
+   */
+  size_t worker_index() const;
+
+private:
+  /**
+   * @brief The task deque owned by one worker
+   */
+  struct worker_queue {
+    std::mutex mutex;
+    std::deque<task> tasks;
+  };
+
+  /**
+   * @brief The main loop of worker `index`
+   * @param index The index of the worker
+   */
+  void worker_loop(size_t index);
+
+  /**
+   * @brief Pop a task from the own deque of `index`, or steal one
+   * @param index The index of the deque to start with
+   * @param t The popped task
+   * @return true A task was popped
+   * @return false All deques are empty
+   */
+  bool pop_task(size_t index, task &t);
+
+  /**
+   * @brief Get the deque index of the calling thread
+   * @return The index of the worker, or a round-robin index for other threads
+   */
+  size_t local_index();
+
+private:
+  vector<unique_ptr<worker_queue>> _queues; // one deque per worker
+  vector<std::thread> _workers;             // worker threads
+  std::mutex _sleep_mutex;                  // guards `_pending` for sleepers
+  std::condition_variable _sleep_cv;        // idle workers wait on it
+  std::atomic<size_t> _pending;             // tasks pushed but not popped
+  std::atomic<size_t> _next_queue;          // round-robin submit index
+  bool _stopping = false;                   // set by the destructor
+};
+
+/**
+ * @brief A group of forked tasks that can be joined together.
+ *
+ * `wait` keeps running pending tasks of the pool while the group is not
+ * finished, so nested fork-join never blocks a worker. The first exception
+ * thrown by a task is rethrown by `wait`.
+ */
+class task_group {
+public:
+  /**
+   * @brief Construct a new task group object
+   * @param pool The pool which runs the tasks
+   */
+  explicit task_group(thread_pool &pool) : _pool(pool), _unfinished(0) {}
+
+  task_group(const task_group &) = delete;
+
+  /**
+   * @brief Wait for the unfinished tasks, a group must not outlive its tasks
+   */
+  ~task_group();
+
+  /**
+   * @brief Fork a task into the group
+   * @param t The task
+   */
+  void run(thread_pool::task t);
+
+  /**
+   * @brief Join all tasks of the group
+   */
+  void wait();
+
+private:
+  thread_pool &_pool;               // the pool which runs the tasks
+  std::atomic<size_t> _unfinished;  // the number of unfinished tasks
+  std::mutex _error_mutex;          // guards `_error`
+  std::exception_ptr _error;        // the first exception thrown by a task
+};
+
+#endif // LIB_7CXX_THREAD_POOL_H